@@ -0,0 +1,479 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "attributesarray.h"
+#include "common.h"
+#include "shadow.h"
+#include "simd.h"
+
+/* 3D attributes for many emitters, stored as separate float arrays per vector
+   component so the kernels below process four emitters per SSE instruction.
+   The arrays live inside the userdata, padded to a multiple of four; padding
+   lanes are computed along with the rest and never read back.
+
+   A typical frame: set positions, derive velocities from the previous frame,
+   then set3DAttributes to hand every emitter to FMOD in one call.
+*/
+
+/* Vectors shorter than this are left unnormalized rather than divided by zero */
+#define MIN_LENGTH 1e-12f
+
+enum {
+    POSITION_X, POSITION_Y, POSITION_Z,
+    PREVIOUS_X, PREVIOUS_Y, PREVIOUS_Z,
+    VELOCITY_X, VELOCITY_Y, VELOCITY_Z,
+    FORWARD_X, FORWARD_Y, FORWARD_Z,
+    UP_X, UP_Y, UP_Z,
+    ARRAY_COUNT
+};
+
+/* Keeps every component offset, ARRAY_COUNT * stride, within an int */
+#define MAX_COUNT ((INT_MAX / ARRAY_COUNT) & ~3)
+
+struct luaFMOD_AttributesArray {
+    int count;
+    int stride;
+    float data[1];
+};
+
+#define SELF_TYPE luaFMOD_AttributesArray
+
+#undef GET_SELF
+#define GET_SELF \
+    SELF_TYPE *self = (SELF_TYPE*)luaL_checkudata(L, 1, STRINGIZE(SELF_TYPE))
+
+#define COMPONENT(array, component) ((array)->data + (component) * (array)->stride)
+
+int createAttributesArray(lua_State *L)
+{
+    int count = luaL_checkint(L, 1);
+
+    luaL_argcheck(L, count > 0, 1, "count must be positive");
+    luaL_argcheck(L, count <= MAX_COUNT, 1, "count too large");
+
+    int stride = (count + 3) & ~3;
+    size_t floats = (size_t)ARRAY_COUNT * stride;
+
+    luaL_argcheck(L, floats <= (SIZE_MAX - sizeof(luaFMOD_AttributesArray)) / sizeof(float), 1, "count too large");
+
+    size_t size = sizeof(luaFMOD_AttributesArray) + (floats - 1) * sizeof(float);
+
+    luaFMOD_AttributesArray *array = lua_newuserdata(L, size);
+    memset(array, 0, size);
+
+    array->count = count;
+    array->stride = stride;
+
+    /* FMOD rejects zero orientation vectors, so start with its defaults */
+    for (int i = 0; i < stride; ++i) {
+        COMPONENT(array, FORWARD_Z)[i] = 1;
+        COMPONENT(array, UP_Y)[i] = 1;
+    }
+
+    luaL_getmetatable(L, STRINGIZE(SELF_TYPE));
+    lua_setmetatable(L, -2);
+
+    return 1;
+}
+
+static int checkIndex(lua_State *L, luaFMOD_AttributesArray *array, int index)
+{
+    int i = luaL_checkint(L, index);
+
+    luaL_argcheck(L, 1 <= i && i <= array->count, index, "index out of range");
+
+    return i - 1;
+}
+
+static void readVector(lua_State *L, luaFMOD_AttributesArray *array, int i, int component, int index)
+{
+    COMPONENT(array, component)[i] = (float)luaL_checknumber(L, index);
+    COMPONENT(array, component + 1)[i] = (float)luaL_checknumber(L, index + 1);
+    COMPONENT(array, component + 2)[i] = (float)luaL_checknumber(L, index + 2);
+}
+
+static void pushVector(lua_State *L, luaFMOD_AttributesArray *array, int i, int component)
+{
+    lua_pushnumber(L, COMPONENT(array, component)[i]);
+    lua_pushnumber(L, COMPONENT(array, component + 1)[i]);
+    lua_pushnumber(L, COMPONENT(array, component + 2)[i]);
+}
+
+static void getAttributes(luaFMOD_AttributesArray *array, int i, FMOD_3D_ATTRIBUTES *attributes)
+{
+    attributes->position.x = COMPONENT(array, POSITION_X)[i];
+    attributes->position.y = COMPONENT(array, POSITION_Y)[i];
+    attributes->position.z = COMPONENT(array, POSITION_Z)[i];
+    attributes->velocity.x = COMPONENT(array, VELOCITY_X)[i];
+    attributes->velocity.y = COMPONENT(array, VELOCITY_Y)[i];
+    attributes->velocity.z = COMPONENT(array, VELOCITY_Z)[i];
+    attributes->forward.x = COMPONENT(array, FORWARD_X)[i];
+    attributes->forward.y = COMPONENT(array, FORWARD_Y)[i];
+    attributes->forward.z = COMPONENT(array, FORWARD_Z)[i];
+    attributes->up.x = COMPONENT(array, UP_X)[i];
+    attributes->up.y = COMPONENT(array, UP_Y)[i];
+    attributes->up.z = COMPONENT(array, UP_Z)[i];
+}
+
+static int METHOD_NAME(getCount)(lua_State *L)
+{
+    GET_SELF;
+
+    lua_pushinteger(L, self->count);
+
+    return 1;
+}
+
+/* setPosition(index, x, y, z) */
+static int METHOD_NAME(setPosition)(lua_State *L)
+{
+    GET_SELF;
+
+    readVector(L, self, checkIndex(L, self, 2), POSITION_X, 3);
+
+    return 0;
+}
+
+static int METHOD_NAME(getPosition)(lua_State *L)
+{
+    GET_SELF;
+
+    pushVector(L, self, checkIndex(L, self, 2), POSITION_X);
+
+    return 3;
+}
+
+/* setVelocity(index, x, y, z) */
+static int METHOD_NAME(setVelocity)(lua_State *L)
+{
+    GET_SELF;
+
+    readVector(L, self, checkIndex(L, self, 2), VELOCITY_X, 3);
+
+    return 0;
+}
+
+static int METHOD_NAME(getVelocity)(lua_State *L)
+{
+    GET_SELF;
+
+    pushVector(L, self, checkIndex(L, self, 2), VELOCITY_X);
+
+    return 3;
+}
+
+/* setOrientation(index, forwardX, forwardY, forwardZ, upX, upY, upZ) */
+static int METHOD_NAME(setOrientation)(lua_State *L)
+{
+    GET_SELF;
+
+    int i = checkIndex(L, self, 2);
+
+    readVector(L, self, i, FORWARD_X, 3);
+    readVector(L, self, i, UP_X, 6);
+
+    return 0;
+}
+
+static int METHOD_NAME(getOrientation)(lua_State *L)
+{
+    GET_SELF;
+
+    int i = checkIndex(L, self, 2);
+
+    pushVector(L, self, i, FORWARD_X);
+    pushVector(L, self, i, UP_X);
+
+    return 6;
+}
+
+/* getAttributes(index)
+   Returns the emitter's attributes as an FMOD_3D_ATTRIBUTES structure.
+*/
+static int METHOD_NAME(getAttributes)(lua_State *L)
+{
+    GET_SELF;
+
+    FMOD_3D_ATTRIBUTES attributes;
+    getAttributes(self, checkIndex(L, self, 2), &attributes);
+
+    PUSH_STRUCT(L, FMOD_3D_ATTRIBUTES, attributes);
+
+    return 1;
+}
+
+/* setPositions(positions, [first])
+   positions is a flat array { x1, y1, z1, x2, ... } written from index first
+   (default 1).
+*/
+static int METHOD_NAME(setPositions)(lua_State *L)
+{
+    GET_SELF;
+
+    luaL_checktype(L, 2, LUA_TTABLE);
+
+    int first = luaL_optint(L, 3, 1) - 1;
+    int count = (int)lua_objlen(L, 2) / 3;
+
+    luaL_argcheck(L, first >= 0 && first + count <= self->count, 3, "positions out of range");
+
+    float *x = COMPONENT(self, POSITION_X) + first;
+    float *y = COMPONENT(self, POSITION_Y) + first;
+    float *z = COMPONENT(self, POSITION_Z) + first;
+
+    for (int i = 0; i < count; ++i) {
+        lua_rawgeti(L, 2, i * 3 + 1);
+        lua_rawgeti(L, 2, i * 3 + 2);
+        lua_rawgeti(L, 2, i * 3 + 3);
+
+        x[i] = (float)lua_tonumber(L, -3);
+        y[i] = (float)lua_tonumber(L, -2);
+        z[i] = (float)lua_tonumber(L, -1);
+
+        lua_pop(L, 3);
+    }
+
+    return 0;
+}
+
+/* updateVelocities(deltaTime)
+   Sets each velocity to the distance moved since the previous call divided by
+   deltaTime, then remembers the current positions for next time. Call it once
+   before the first frame (with any deltaTime) to initialise the previous positions.
+*/
+static int METHOD_NAME(updateVelocities)(lua_State *L)
+{
+    GET_SELF;
+
+    float deltaTime = (float)luaL_checknumber(L, 2);
+
+    luaL_argcheck(L, deltaTime > 0, 2, "delta time must be positive");
+
+    Lanes scale = SPLAT(1 / deltaTime);
+
+    for (int c = 0; c < 3; ++c) {
+        float *position = COMPONENT(self, POSITION_X + c);
+        float *previous = COMPONENT(self, PREVIOUS_X + c);
+        float *velocity = COMPONENT(self, VELOCITY_X + c);
+
+        for (int i = 0; i < self->stride; i += LANES) {
+            Lanes current = LOAD(position + i);
+
+            STORE(velocity + i, MUL(SUB(current, LOAD(previous + i)), scale));
+            STORE(previous + i, current);
+        }
+    }
+
+    return 0;
+}
+
+/* orthonormalize()
+   Normalizes every forward vector and makes each up vector perpendicular to its
+   forward vector and unit length, as FMOD requires.
+*/
+static int METHOD_NAME(orthonormalize)(lua_State *L)
+{
+    GET_SELF;
+
+    float *fx = COMPONENT(self, FORWARD_X);
+    float *fy = COMPONENT(self, FORWARD_Y);
+    float *fz = COMPONENT(self, FORWARD_Z);
+    float *ux = COMPONENT(self, UP_X);
+    float *uy = COMPONENT(self, UP_Y);
+    float *uz = COMPONENT(self, UP_Z);
+
+    Lanes minLength = SPLAT(MIN_LENGTH);
+
+    for (int i = 0; i < self->stride; i += LANES) {
+        Lanes x = LOAD(fx + i);
+        Lanes y = LOAD(fy + i);
+        Lanes z = LOAD(fz + i);
+
+        Lanes length = MAX(SQRT(ADD(ADD(MUL(x, x), MUL(y, y)), MUL(z, z))), minLength);
+
+        x = DIV(x, length);
+        y = DIV(y, length);
+        z = DIV(z, length);
+
+        STORE(fx + i, x);
+        STORE(fy + i, y);
+        STORE(fz + i, z);
+
+        /* Gram-Schmidt: remove the forward component from up */
+        Lanes upX = LOAD(ux + i);
+        Lanes upY = LOAD(uy + i);
+        Lanes upZ = LOAD(uz + i);
+
+        Lanes dot = ADD(ADD(MUL(upX, x), MUL(upY, y)), MUL(upZ, z));
+
+        upX = SUB(upX, MUL(dot, x));
+        upY = SUB(upY, MUL(dot, y));
+        upZ = SUB(upZ, MUL(dot, z));
+
+        length = MAX(SQRT(ADD(ADD(MUL(upX, upX), MUL(upY, upY)), MUL(upZ, upZ))), minLength);
+
+        STORE(ux + i, DIV(upX, length));
+        STORE(uy + i, DIV(upY, length));
+        STORE(uz + i, DIV(upZ, length));
+    }
+
+    return 0;
+}
+
+/* Rotates the vectors in components source..source+2 into the listener's basis,
+   after subtracting origin, writing to the same components of destination.
+*/
+static void transformVectors(const luaFMOD_AttributesArray *source, luaFMOD_AttributesArray *destination,
+    int component, const FMOD_VECTOR *origin, const FMOD_VECTOR basis[3])
+{
+    const float *sx = COMPONENT(source, component);
+    const float *sy = COMPONENT(source, component + 1);
+    const float *sz = COMPONENT(source, component + 2);
+    float *dx = COMPONENT(destination, component);
+    float *dy = COMPONENT(destination, component + 1);
+    float *dz = COMPONENT(destination, component + 2);
+
+    Lanes ox = SPLAT(origin->x);
+    Lanes oy = SPLAT(origin->y);
+    Lanes oz = SPLAT(origin->z);
+
+    Lanes axes[3][3];
+
+    for (int a = 0; a < 3; ++a) {
+        axes[a][0] = SPLAT(basis[a].x);
+        axes[a][1] = SPLAT(basis[a].y);
+        axes[a][2] = SPLAT(basis[a].z);
+    }
+
+    for (int i = 0; i < source->stride; i += LANES) {
+        Lanes x = SUB(LOAD(sx + i), ox);
+        Lanes y = SUB(LOAD(sy + i), oy);
+        Lanes z = SUB(LOAD(sz + i), oz);
+
+        STORE(dx + i, ADD(ADD(MUL(x, axes[0][0]), MUL(y, axes[0][1])), MUL(z, axes[0][2])));
+        STORE(dy + i, ADD(ADD(MUL(x, axes[1][0]), MUL(y, axes[1][1])), MUL(z, axes[1][2])));
+        STORE(dz + i, ADD(ADD(MUL(x, axes[2][0]), MUL(y, axes[2][1])), MUL(z, axes[2][2])));
+    }
+}
+
+/* toListenerSpace(listener, destination)
+   Writes every emitter's attributes relative to listener (an FMOD_3D_ATTRIBUTES)
+   into destination, an array of the same size, which may be this array. In
+   listener space x is right, y is up and z is forward, using FMOD's default
+   left-handed coordinates.
+*/
+static int METHOD_NAME(toListenerSpace)(lua_State *L)
+{
+    GET_SELF;
+
+    FMOD_3D_ATTRIBUTES *listener = CHECK_STRUCT(L, 2, FMOD_3D_ATTRIBUTES);
+    luaFMOD_AttributesArray *destination = luaL_checkudata(L, 3, STRINGIZE(SELF_TYPE));
+
+    luaL_argcheck(L, destination->count == self->count, 3, "arrays must be the same size");
+
+    const FMOD_VECTOR *forward = &listener->forward;
+    const FMOD_VECTOR *up = &listener->up;
+
+    FMOD_VECTOR basis[3] = {
+        { up->y * forward->z - up->z * forward->y, up->z * forward->x - up->x * forward->z,
+            up->x * forward->y - up->y * forward->x },
+        *up,
+        *forward,
+    };
+
+    FMOD_VECTOR zero = { 0, 0, 0 };
+
+    transformVectors(self, destination, POSITION_X, &listener->position, basis);
+    transformVectors(self, destination, VELOCITY_X, &listener->velocity, basis);
+    transformVectors(self, destination, FORWARD_X, &zero, basis);
+    transformVectors(self, destination, UP_X, &zero, basis);
+
+    return 0;
+}
+
+/* set3DAttributes(targets, [first])
+   targets is an array of EventInstances and Channels; targets[n] receives the
+   attributes at index first + n - 1 (first defaults to 1). Nil or false entries
+   are skipped. Returns true, or the usual error values for the first failure,
+   after attempting every target.
+*/
+static int METHOD_NAME(set3DAttributes)(lua_State *L)
+{
+    GET_SELF;
+
+    luaL_checktype(L, 2, LUA_TTABLE);
+
+    int first = luaL_optint(L, 3, 1) - 1;
+    int count = (int)lua_objlen(L, 2);
+
+    luaL_argcheck(L, first >= 0 && first + count <= self->count, 3, "targets out of range");
+
+    FMOD_RESULT firstError = FMOD_OK;
+
+    for (int n = 0; n < count; ++n) {
+        lua_rawgeti(L, 2, n + 1);
+
+        if (lua_toboolean(L, -1)) {
+            FMOD_3D_ATTRIBUTES attributes;
+            getAttributes(self, first + n, &attributes);
+
+            FMOD_RESULT result = FMOD_OK;
+
+            if (hasMetatable(L, -1, "FMOD_STUDIO_EVENTINSTANCE")) {
+                FMOD_STUDIO_EVENTINSTANCE *instance = CHECK_HANDLE(L, -1, FMOD_STUDIO_EVENTINSTANCE);
+
+                result = FMOD_Studio_EventInstance_Set3DAttributes(instance, &attributes);
+                shadowRecord(L, instance, SHADOW_ATTRIBUTES, (const float*)&attributes, result);
+            } else {
+                result = FMOD_Channel_Set3DAttributes(CHECK_HANDLE(L, -1, FMOD_CHANNEL),
+                    &attributes.position, &attributes.velocity);
+            }
+
+            if (firstError == FMOD_OK) {
+                firstError = result;
+            }
+        }
+
+        lua_pop(L, 1);
+    }
+
+    RETURN_STATUS(firstError);
+}
+
+METHODS_TABLE_BEGIN
+    METHODS_TABLE_ENTRY(getCount)
+    METHODS_TABLE_ENTRY(setPosition)
+    METHODS_TABLE_ENTRY(getPosition)
+    METHODS_TABLE_ENTRY(setVelocity)
+    METHODS_TABLE_ENTRY(getVelocity)
+    METHODS_TABLE_ENTRY(setOrientation)
+    METHODS_TABLE_ENTRY(getOrientation)
+    METHODS_TABLE_ENTRY(getAttributes)
+    METHODS_TABLE_ENTRY(setPositions)
+    METHODS_TABLE_ENTRY(updateVelocities)
+    METHODS_TABLE_ENTRY(orthonormalize)
+    METHODS_TABLE_ENTRY(toListenerSpace)
+    METHODS_TABLE_ENTRY(set3DAttributes)
+METHODS_TABLE_END
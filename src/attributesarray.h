@@ -0,0 +1,11 @@
+#ifndef ATTRIBUTESARRAY_H
+#define ATTRIBUTESARRAY_H
+
+#include <lauxlib.h>
+
+typedef struct luaFMOD_AttributesArray luaFMOD_AttributesArray;
+
+/* FMOD.createAttributesArray(count) */
+int createAttributesArray(lua_State *L);
+
+#endif /* ATTRIBUTESARRAY_H */
@@ -0,0 +1,572 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "automation.h"
+#include "common.h"
+#include "context.h"
+#include "shadow.h"
+
+/* Drives event parameters, event volume and pitch, and bus and VCA volumes along
+   curves. Tracks are evaluated from Studio.System:update, before the Studio update
+   so new values are applied in the same frame, and only write to FMOD when their
+   value changes. Time is the mixer clock of the system the automation was created
+   from, so tracks keep pace with the audio under simulate and non-realtime output
+   as well as in real time. Finished tracks are freed and their ids
+   queued for popCompleted. Track ids are slot indices, valid until completion or
+   removal.
+
+   Releasing or collecting an automation frees its tracks and leaves every target
+   at the last value written.
+*/
+
+enum {
+    TARGET_INSTANCE_PARAMETER,
+    TARGET_INSTANCE_VOLUME,
+    TARGET_INSTANCE_PITCH,
+    TARGET_BUS_VOLUME,
+    TARGET_VCA_VOLUME,
+};
+
+typedef struct Track {
+    int used;
+    int target;
+    void *handle;
+    FMOD_STUDIO_PARAMETER_ID parameter;
+
+    int curve;
+    double start;
+    double duration;
+    float a;
+    float b;
+    float c;
+    float *table;
+    int tableCount;
+
+    float value;
+    int written;
+} Track;
+
+struct luaFMOD_Automation {
+    Track *tracks;
+    int trackCount;
+    int capacity;
+    int *freeSlots;
+    int freeCount;
+
+    /* Slots can complete, be reused and complete again before popCompleted, so this
+       grows on its own
+    */
+    int *completed;
+    int completedCount;
+    int completedCapacity;
+    unsigned int completedDropped;
+
+    double writes;
+    double skipped;
+    FMOD_RESULT lastError;
+
+    FMOD_SYSTEM *core;
+    int sampleRate;
+
+    int released;
+
+    luaFMOD_Automation *next;
+};
+
+#define SELF_TYPE luaFMOD_Automation
+
+#undef GET_SELF
+#define GET_SELF GET_RELEASABLE_SELF("automation")
+
+static int growArray(void **array, int capacity, size_t itemSize)
+{
+    void *items = realloc(*array, capacity * itemSize);
+
+    if (!items) {
+        return 0;
+    }
+
+    *array = items;
+
+    return 1;
+}
+
+static float evaluate(const Track *track, double elapsed)
+{
+    double t = 1;
+
+    if (track->duration > 0) {
+        t = elapsed < track->duration ? elapsed / track->duration : 1;
+    }
+
+    switch (track->curve) {
+    case luaFMOD_AUTOMATION_CURVE_EXPONENTIAL:
+        return (float)(track->a * pow(track->b / track->a, t));
+    case luaFMOD_AUTOMATION_CURVE_SINE:
+        /* a is the centre, b the depth and c the frequency in Hz */
+        return (float)(track->a + track->b * sin(2 * 3.14159265358979323846 * track->c * elapsed));
+    case luaFMOD_AUTOMATION_CURVE_TABLE:
+        {
+            double position = t * (track->tableCount - 1);
+            int i = (int)position;
+
+            if (i >= track->tableCount - 1) {
+                return track->table[track->tableCount - 1];
+            }
+
+            float fraction = (float)(position - i);
+
+            return track->table[i] + (track->table[i + 1] - track->table[i]) * fraction;
+        }
+    default:
+        return (float)(track->a + (track->b - track->a) * t);
+    }
+}
+
+/* Writes the value and records it in the shadow cache, so a later setter call
+   with a different value isn't skipped as redundant
+*/
+static FMOD_RESULT writeValue(lua_State *L, const Track *track, float value)
+{
+    FMOD_RESULT result = FMOD_OK;
+
+    switch (track->target) {
+    case TARGET_INSTANCE_PARAMETER:
+        result = FMOD_Studio_EventInstance_SetParameterByID(track->handle, track->parameter, value, 0);
+        shadowRecordParameter(L, track->handle, track->parameter, value, result);
+        return result;
+    case TARGET_INSTANCE_VOLUME:
+        result = FMOD_Studio_EventInstance_SetVolume(track->handle, value);
+        shadowRecord(L, track->handle, SHADOW_VOLUME, &value, result);
+        return result;
+    case TARGET_INSTANCE_PITCH:
+        result = FMOD_Studio_EventInstance_SetPitch(track->handle, value);
+        shadowRecord(L, track->handle, SHADOW_PITCH, &value, result);
+        return result;
+    case TARGET_BUS_VOLUME:
+        result = FMOD_Studio_Bus_SetVolume(track->handle, value);
+        shadowRecord(L, track->handle, SHADOW_VOLUME, &value, result);
+        return result;
+    default:
+        return FMOD_Studio_VCA_SetVolume(track->handle, value);
+    }
+}
+
+/* Only called on used slots, so freeSlots never holds more than capacity entries */
+static void freeTrack(luaFMOD_Automation *automation, int i)
+{
+    Track *track = &automation->tracks[i];
+
+    free(track->table);
+    track->table = NULL;
+    track->used = 0;
+
+    automation->freeSlots[automation->freeCount++] = i;
+}
+
+static void completeTrack(luaFMOD_Automation *automation, int i)
+{
+    freeTrack(automation, i);
+
+    if (automation->completedCount == automation->completedCapacity) {
+        int capacity = automation->completedCapacity ? automation->completedCapacity * 2 : 32;
+
+        if (!growArray((void**)&automation->completed, capacity, sizeof(int))) {
+            automation->completedDropped++;
+            return;
+        }
+
+        automation->completedCapacity = capacity;
+    }
+
+    automation->completed[automation->completedCount++] = i + 1;
+}
+
+/* The master ChannelGroup's DSP clock, in seconds */
+static FMOD_RESULT getMixerTime(luaFMOD_Automation *automation, double *time)
+{
+    FMOD_CHANNELGROUP *master = NULL;
+    unsigned long long clock = 0;
+
+    FMOD_RESULT result = FMOD_System_GetMasterChannelGroup(automation->core, &master);
+
+    if (result == FMOD_OK) {
+        result = FMOD_ChannelGroup_GetDSPClock(master, NULL, &clock);
+    }
+
+    *time = (double)clock / automation->sampleRate;
+
+    return result;
+}
+
+static void updateAutomation(lua_State *L, luaFMOD_Automation *automation)
+{
+    double now = 0;
+    FMOD_RESULT result = getMixerTime(automation, &now);
+
+    if (result != FMOD_OK) {
+        automation->lastError = result;
+        return;
+    }
+
+    for (int i = 0; i < automation->trackCount; ++i) {
+        Track *track = &automation->tracks[i];
+
+        if (!track->used) {
+            continue;
+        }
+
+        double elapsed = now - track->start;
+        float value = evaluate(track, elapsed);
+
+        if (track->written && value == track->value) {
+            automation->skipped++;
+        } else {
+            FMOD_RESULT result = writeValue(L, track, value);
+
+            if (result != FMOD_OK) {
+                /* The target has most likely been released */
+                automation->lastError = result;
+                completeTrack(automation, i);
+                continue;
+            }
+
+            track->value = value;
+            track->written = 1;
+            automation->writes++;
+        }
+
+        if (track->duration > 0 && elapsed >= track->duration) {
+            completeTrack(automation, i);
+        }
+    }
+}
+
+void automationUpdateAll(lua_State *L)
+{
+    for (luaFMOD_Automation *automation = contextGet(L)->automations; automation; automation = automation->next) {
+        updateAutomation(L, automation);
+    }
+}
+
+int automationCreate(lua_State *L, FMOD_STUDIO_SYSTEM *system)
+{
+    FMOD_SYSTEM *core = NULL;
+    RETURN_IF_ERROR(FMOD_Studio_System_GetCoreSystem(system, &core));
+
+    int sampleRate = 0;
+    RETURN_IF_ERROR(FMOD_System_GetSoftwareFormat(core, &sampleRate, NULL, NULL));
+
+    luaFMOD_Automation *automation = NEW_SELF(L);
+
+    automation->lastError = FMOD_OK;
+    automation->core = core;
+    automation->sampleRate = sampleRate;
+
+    luaFMOD_Context *context = contextGet(L);
+
+    automation->next = context->automations;
+    context->automations = automation;
+
+    return 1;
+}
+
+static int METHOD_NAME(__gc)(lua_State *L)
+{
+    GET_SELF_FOR_GC;
+
+    for (luaFMOD_Automation **link = &contextGet(L)->automations; *link; link = &(*link)->next) {
+        if (*link == self) {
+            *link = self->next;
+            break;
+        }
+    }
+
+    for (int i = 0; i < self->trackCount; ++i) {
+        if (self->tracks[i].used) {
+            free(self->tracks[i].table);
+        }
+    }
+
+    free(self->tracks);
+    free(self->freeSlots);
+    free(self->completed);
+
+    self->tracks = NULL;
+    self->freeSlots = NULL;
+    self->completed = NULL;
+    self->trackCount = 0;
+    self->released = 1;
+
+    return 0;
+}
+
+/* Stops the automation, leaving every target at the last value written. */
+static int METHOD_NAME(release)(lua_State *L)
+{
+    return METHOD_NAME(__gc)(L);
+}
+
+/* Returns a free slot index, or -1 if out of memory */
+static int allocateTrack(luaFMOD_Automation *automation)
+{
+    if (automation->freeCount > 0) {
+        return automation->freeSlots[--automation->freeCount];
+    }
+
+    if (automation->trackCount == automation->capacity) {
+        int capacity = automation->capacity ? automation->capacity * 2 : 32;
+
+        /* Every slot can be free at once */
+        if (!growArray((void**)&automation->tracks, capacity, sizeof(Track))
+            || !growArray((void**)&automation->freeSlots, capacity, sizeof(int))) {
+            return -1;
+        }
+
+        automation->capacity = capacity;
+    }
+
+    return automation->trackCount++;
+}
+
+/* Reads the target and property arguments into track */
+static void checkTarget(lua_State *L, Track *track)
+{
+    static const char *PROPERTIES[] = { "volume", "pitch", NULL };
+
+    if (hasMetatable(L, 2, "FMOD_STUDIO_EVENTINSTANCE")) {
+        track->handle = CHECK_HANDLE(L, 2, FMOD_STUDIO_EVENTINSTANCE);
+
+        if (lua_type(L, 3) == LUA_TSTRING) {
+            track->target = luaL_checkoption(L, 3, NULL, PROPERTIES) == 0
+                ? TARGET_INSTANCE_VOLUME : TARGET_INSTANCE_PITCH;
+        } else {
+            track->target = TARGET_INSTANCE_PARAMETER;
+            track->parameter = *CHECK_STRUCT(L, 3, FMOD_STUDIO_PARAMETER_ID);
+        }
+    } else if (hasMetatable(L, 2, "FMOD_STUDIO_BUS")) {
+        track->handle = CHECK_HANDLE(L, 2, FMOD_STUDIO_BUS);
+        track->target = TARGET_BUS_VOLUME;
+        luaL_argcheck(L, luaL_checkoption(L, 3, NULL, PROPERTIES) == 0, 3, "buses only have volume");
+    } else if (hasMetatable(L, 2, "FMOD_STUDIO_VCA")) {
+        track->handle = CHECK_HANDLE(L, 2, FMOD_STUDIO_VCA);
+        track->target = TARGET_VCA_VOLUME;
+        luaL_argcheck(L, luaL_checkoption(L, 3, NULL, PROPERTIES) == 0, 3, "VCAs only have volume");
+    } else {
+        luaL_argerror(L, 2, "expected an EventInstance, Bus or VCA");
+    }
+}
+
+/* Reads the curve arguments into track, allocating its table if it has one */
+static void checkCurve(lua_State *L, Track *track)
+{
+    track->curve = CHECK_CONSTANT(L, 4, luaFMOD_AUTOMATION_CURVE);
+    track->duration = luaL_checknumber(L, 5);
+    track->table = NULL;
+    track->tableCount = 0;
+
+    switch (track->curve) {
+    case luaFMOD_AUTOMATION_CURVE_LINEAR:
+    case luaFMOD_AUTOMATION_CURVE_EXPONENTIAL:
+        luaL_argcheck(L, track->duration > 0, 5, "duration must be positive");
+
+        track->a = (float)luaL_checknumber(L, 6);
+        track->b = (float)luaL_checknumber(L, 7);
+
+        if (track->curve == luaFMOD_AUTOMATION_CURVE_EXPONENTIAL) {
+            luaL_argcheck(L, track->a > 0 && track->b > 0, 6, "exponential curves need positive values");
+        }
+        break;
+    case luaFMOD_AUTOMATION_CURVE_SINE:
+        track->a = (float)luaL_checknumber(L, 6);
+        track->b = (float)luaL_checknumber(L, 7);
+        track->c = (float)luaL_checknumber(L, 8);
+        break;
+    case luaFMOD_AUTOMATION_CURVE_TABLE:
+        {
+            luaL_argcheck(L, track->duration > 0, 5, "duration must be positive");
+            luaL_checktype(L, 6, LUA_TTABLE);
+
+            int count = (int)lua_objlen(L, 6);
+            luaL_argcheck(L, count > 0, 6, "table must not be empty");
+
+            track->table = malloc(count * sizeof(float));
+
+            if (!track->table) {
+                luaL_error(L, "out of memory");
+            }
+
+            for (int i = 0; i < count; ++i) {
+                lua_rawgeti(L, 6, i + 1);
+                track->table[i] = (float)lua_tonumber(L, -1);
+                lua_pop(L, 1);
+            }
+
+            track->tableCount = count;
+        }
+        break;
+    }
+}
+
+/* addTrack(target, property, curve, duration, ...)
+   target is an EventInstance, Bus or VCA. property is "volume", "pitch" (instances
+   only) or an instance parameter's FMOD_STUDIO_PARAMETER_ID. The remaining
+   arguments depend on the curve:
+
+       LINEAR, EXPONENTIAL   from, to
+       SINE                  centre, depth, frequency in Hz
+       TABLE                 { values }, spaced evenly over the duration
+
+   duration is in seconds of mixer time; a SINE track with a duration of 0 runs
+   until removed.
+   Returns the track id.
+*/
+static int METHOD_NAME(addTrack)(lua_State *L)
+{
+    GET_SELF;
+
+    double start = 0;
+    RETURN_IF_ERROR(getMixerTime(self, &start));
+
+    Track track;
+    memset(&track, 0, sizeof(track));
+
+    checkTarget(L, &track);
+    checkCurve(L, &track);
+
+    int i = allocateTrack(self);
+
+    if (i < 0) {
+        free(track.table);
+        return luaL_error(L, "out of memory");
+    }
+
+    track.used = 1;
+    track.start = start;
+
+    self->tracks[i] = track;
+
+    lua_pushinteger(L, i + 1);
+
+    return 1;
+}
+
+static int checkTrack(lua_State *L, luaFMOD_Automation *automation, int index)
+{
+    int id = luaL_checkint(L, index);
+
+    luaL_argcheck(L, 1 <= id && id <= automation->trackCount && automation->tracks[id - 1].used,
+        index, "invalid track id");
+
+    return id - 1;
+}
+
+/* removeTrack(id)
+   Stops a track, leaving its target at the last value written. Removed tracks are
+   not reported as completed.
+*/
+static int METHOD_NAME(removeTrack)(lua_State *L)
+{
+    GET_SELF;
+
+    freeTrack(self, checkTrack(L, self, 2));
+
+    return 0;
+}
+
+/* getValue(id)
+   Returns the value last written by the track, or nil if it hasn't written yet.
+*/
+static int METHOD_NAME(getValue)(lua_State *L)
+{
+    GET_SELF;
+
+    Track *track = &self->tracks[checkTrack(L, self, 2)];
+
+    if (track->written) {
+        lua_pushnumber(L, track->value);
+    } else {
+        lua_pushnil(L);
+    }
+
+    return 1;
+}
+
+/* popCompleted()
+   Returns an array of the ids of tracks that have finished since the last call,
+   including tracks whose target was released. The same id can appear more than
+   once if its slot was reused.
+*/
+static int METHOD_NAME(popCompleted)(lua_State *L)
+{
+    GET_SELF;
+
+    lua_createtable(L, self->completedCount, 0);
+
+    for (int i = 0; i < self->completedCount; ++i) {
+        lua_pushinteger(L, self->completed[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+
+    self->completedCount = 0;
+
+    return 1;
+}
+
+static int METHOD_NAME(getStats)(lua_State *L)
+{
+    GET_SELF;
+
+    lua_createtable(L, 0, 6);
+
+    lua_pushinteger(L, self->trackCount - self->freeCount);
+    lua_setfield(L, -2, "tracks");
+
+    lua_pushinteger(L, self->completedCount);
+    lua_setfield(L, -2, "completed");
+
+    lua_pushinteger(L, self->completedDropped);
+    lua_setfield(L, -2, "completedDropped");
+
+    lua_pushnumber(L, self->writes);
+    lua_setfield(L, -2, "writes");
+
+    lua_pushnumber(L, self->skipped);
+    lua_setfield(L, -2, "skipped");
+
+    lua_pushinteger(L, self->lastError);
+    lua_setfield(L, -2, "lastError");
+
+    return 1;
+}
+
+METHODS_TABLE_BEGIN
+    METHODS_TABLE_ENTRY(__gc)
+    METHODS_TABLE_ENTRY(release)
+    METHODS_TABLE_ENTRY(addTrack)
+    METHODS_TABLE_ENTRY(removeTrack)
+    METHODS_TABLE_ENTRY(getValue)
+    METHODS_TABLE_ENTRY(popCompleted)
+    METHODS_TABLE_ENTRY(getStats)
+METHODS_TABLE_END
@@ -0,0 +1,20 @@
+#ifndef AUTOMATION_H
+#define AUTOMATION_H
+
+#include <fmod_studio.h>
+#include <lauxlib.h>
+
+typedef struct luaFMOD_Automation luaFMOD_Automation;
+
+/* Curve shapes for Automation:addTrack */
+typedef int luaFMOD_AUTOMATION_CURVE;
+
+#define luaFMOD_AUTOMATION_CURVE_LINEAR      0
+#define luaFMOD_AUTOMATION_CURVE_EXPONENTIAL 1
+#define luaFMOD_AUTOMATION_CURVE_SINE        2
+#define luaFMOD_AUTOMATION_CURVE_TABLE       3
+
+int automationCreate(lua_State *L, FMOD_STUDIO_SYSTEM *system);
+void automationUpdateAll(lua_State *L);
+
+#endif /* AUTOMATION_H */
@@ -0,0 +1,332 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "await.h"
+#include "common.h"
+#include "context.h"
+
+/* FMOD.await yields the calling coroutine until a Studio object reaches a state:
+
+       FMOD.await(bank, "LOADED")            -- Bank:getLoadingState
+       FMOD.await(bank, "SAMPLES_LOADED")    -- Bank:getSampleLoadingState
+       FMOD.await(description, "LOADED")     -- EventDescription:getSampleLoadingState
+       FMOD.await(instance, "STOPPED")       -- EventInstance:getPlaybackState
+
+   Waits are kept in a plain array in the context and checked in one loop by
+   awaitPump, so only coroutines whose condition is met are resumed. The coroutine
+   receives true, or the usual error values if the state can no longer be reached
+   (e.g. the bank failed to load).
+*/
+
+enum {
+    KIND_BANK_LOADING,
+    KIND_BANK_SAMPLES,
+    KIND_DESCRIPTION_SAMPLES,
+    KIND_INSTANCE_PLAYBACK,
+};
+
+typedef struct Wait {
+    int kind;
+    void *handle;
+    int target;
+    int threadReference;
+} Wait;
+
+struct AwaitList {
+    Wait *waits;
+    int count;
+    int capacity;
+
+    /* Set while awaitPump runs, so a nested Studio update doesn't pump the list again */
+    int pumping;
+};
+
+static const char *LOADING_STATE_NAMES[] = {
+    "UNLOADING", "UNLOADED", "LOADING", "LOADED", "ERROR", NULL
+};
+
+static const char *PLAYBACK_STATE_NAMES[] = {
+    "PLAYING", "SUSTAINING", "STOPPED", "STARTING", "STOPPING", NULL
+};
+
+static const int LOADING_STATES[] = {
+    FMOD_STUDIO_LOADING_STATE_UNLOADING,
+    FMOD_STUDIO_LOADING_STATE_UNLOADED,
+    FMOD_STUDIO_LOADING_STATE_LOADING,
+    FMOD_STUDIO_LOADING_STATE_LOADED,
+    FMOD_STUDIO_LOADING_STATE_ERROR,
+};
+
+static const int PLAYBACK_STATES[] = {
+    FMOD_STUDIO_PLAYBACK_PLAYING,
+    FMOD_STUDIO_PLAYBACK_SUSTAINING,
+    FMOD_STUDIO_PLAYBACK_STOPPED,
+    FMOD_STUDIO_PLAYBACK_STARTING,
+    FMOD_STUDIO_PLAYBACK_STOPPING,
+};
+
+static int findName(const char **names, const char *name)
+{
+    for (int i = 0; names[i]; ++i) {
+        if (strcmp(names[i], name) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/* Reads the awaited object and state into wait, raising an error if they are invalid */
+static void checkWait(lua_State *L, Wait *wait)
+{
+    const char *state = luaL_checkstring(L, 2);
+    int index = -1;
+
+    if (lua_type(L, 1) != LUA_TUSERDATA) {
+        luaL_argerror(L, 1, "expected a Bank, EventDescription or EventInstance");
+    }
+
+    wait->handle = *(void**)lua_touserdata(L, 1);
+
+    if (hasMetatable(L, 1, "FMOD_STUDIO_BANK")) {
+        if (strncmp(state, "SAMPLES_", 8) == 0) {
+            wait->kind = KIND_BANK_SAMPLES;
+            index = findName(LOADING_STATE_NAMES, state + 8);
+        } else {
+            wait->kind = KIND_BANK_LOADING;
+            index = findName(LOADING_STATE_NAMES, state);
+        }
+
+        if (index >= 0) {
+            wait->target = LOADING_STATES[index];
+        }
+    } else if (hasMetatable(L, 1, "FMOD_STUDIO_EVENTDESCRIPTION")) {
+        wait->kind = KIND_DESCRIPTION_SAMPLES;
+        index = findName(LOADING_STATE_NAMES, state);
+
+        if (index >= 0) {
+            wait->target = LOADING_STATES[index];
+        }
+    } else if (hasMetatable(L, 1, "FMOD_STUDIO_EVENTINSTANCE")) {
+        wait->kind = KIND_INSTANCE_PLAYBACK;
+        index = findName(PLAYBACK_STATE_NAMES, state);
+
+        if (index >= 0) {
+            wait->target = PLAYBACK_STATES[index];
+        }
+    } else {
+        luaL_argerror(L, 1, "expected a Bank, EventDescription or EventInstance");
+    }
+
+    if (index < 0) {
+        luaL_argerror(L, 2, lua_pushfstring(L, "invalid state '%s'", state));
+    }
+}
+
+/* Returns 1 if the wait is over, with *result set to FMOD_OK if the state was reached
+   or to an error if it never will be. Returns 0 if the wait should continue.
+*/
+static int checkCondition(const Wait *wait, FMOD_RESULT *result)
+{
+    FMOD_STUDIO_LOADING_STATE loading = FMOD_STUDIO_LOADING_STATE_UNLOADED;
+    FMOD_STUDIO_PLAYBACK_STATE playback = FMOD_STUDIO_PLAYBACK_STOPPED;
+    int state = 0;
+
+    switch (wait->kind) {
+    case KIND_BANK_LOADING:
+        *result = FMOD_Studio_Bank_GetLoadingState(wait->handle, &loading);
+        state = loading;
+        break;
+    case KIND_BANK_SAMPLES:
+        *result = FMOD_Studio_Bank_GetSampleLoadingState(wait->handle, &loading);
+        state = loading;
+        break;
+    case KIND_DESCRIPTION_SAMPLES:
+        *result = FMOD_Studio_EventDescription_GetSampleLoadingState(wait->handle, &loading);
+        state = loading;
+        break;
+    default:
+        *result = FMOD_Studio_EventInstance_GetPlaybackState(wait->handle, &playback);
+        state = playback;
+
+        /* A released instance has certainly stopped */
+        if (*result == FMOD_ERR_INVALID_HANDLE && wait->target == FMOD_STUDIO_PLAYBACK_STOPPED) {
+            *result = FMOD_OK;
+            return 1;
+        }
+        break;
+    }
+
+    if (*result != FMOD_OK) {
+        return 1;
+    }
+
+    if (state == wait->target) {
+        return 1;
+    }
+
+    if (wait->kind != KIND_INSTANCE_PLAYBACK && state == FMOD_STUDIO_LOADING_STATE_ERROR) {
+        *result = FMOD_ERR_FILE_BAD;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int pushStatus(lua_State *L, FMOD_RESULT result)
+{
+    if (result == FMOD_OK) {
+        lua_pushboolean(L, 1);
+        return 1;
+    } else {
+        return pushError(L, result);
+    }
+}
+
+int await(lua_State *L)
+{
+    Wait wait;
+    checkWait(L, &wait);
+
+    FMOD_RESULT result = FMOD_OK;
+
+    if (checkCondition(&wait, &result)) {
+        return pushStatus(L, result);
+    }
+
+    if (lua_pushthread(L)) {
+        return luaL_error(L, "FMOD.await must be called from a coroutine");
+    }
+
+    luaFMOD_Context *context = contextGet(L);
+
+    if (!context->awaits) {
+        context->awaits = calloc(1, sizeof(*context->awaits));
+
+        if (!context->awaits) {
+            return luaL_error(L, "out of memory");
+        }
+    }
+
+    AwaitList *list = context->awaits;
+
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 32;
+        Wait *waits = realloc(list->waits, capacity * sizeof(Wait));
+
+        if (!waits) {
+            return luaL_error(L, "out of memory");
+        }
+
+        list->waits = waits;
+        list->capacity = capacity;
+    }
+
+    wait.threadReference = luaL_ref(L, LUA_REGISTRYINDEX);
+    list->waits[list->count++] = wait;
+
+    lua_settop(L, 0);
+    return lua_yield(L, 0);
+}
+
+void awaitListFree(AwaitList *list)
+{
+    free(list->waits);
+    free(list);
+}
+
+/* Returns 1 and pushes the first error raised by a resumed coroutine once all waits
+   have been checked, or returns 0 and leaves the stack unchanged. Updates made by
+   resumed coroutines don't pump the list; their waits are checked next time.
+*/
+int awaitPump(lua_State *L)
+{
+    AwaitList *list = contextGet(L)->awaits;
+
+    if (!list || list->count == 0 || list->pumping) {
+        return 0;
+    }
+
+    list->pumping = 1;
+
+    lua_pushnil(L);
+    int errorIndex = lua_gettop(L);
+
+    /* Coroutines resumed here may add waits, which are checked next time */
+    int count = list->count;
+
+    for (int i = 0; i < count; ++i) {
+        Wait wait = list->waits[i];
+        FMOD_RESULT result = FMOD_OK;
+
+        if (wait.threadReference == LUA_NOREF || !checkCondition(&wait, &result)) {
+            continue;
+        }
+
+        list->waits[i].threadReference = LUA_NOREF;
+
+        /* The thread stays on the stack so it can't be collected while it runs */
+        lua_rawgeti(L, LUA_REGISTRYINDEX, wait.threadReference);
+        lua_State *thread = lua_tothread(L, -1);
+
+        /* A coroutine resumed by someone else since it awaited has finished or is
+           waiting on something else, so the wait is dropped
+        */
+        if (lua_status(thread) == LUA_YIELD) {
+            int status = lua_resume(thread, pushStatus(thread, result));
+
+            if (status != 0 && status != LUA_YIELD) {
+                lua_xmove(thread, L, 1);
+
+                if (lua_isnil(L, errorIndex)) {
+                    lua_replace(L, errorIndex);
+                } else {
+                    lua_pop(L, 1);
+                }
+            }
+        }
+
+        lua_pop(L, 1);
+        luaL_unref(L, LUA_REGISTRYINDEX, wait.threadReference);
+    }
+
+    /* Compact the list, keeping waits in order */
+    int kept = 0;
+
+    for (int i = 0; i < list->count; ++i) {
+        if (list->waits[i].threadReference != LUA_NOREF) {
+            list->waits[kept++] = list->waits[i];
+        }
+    }
+
+    list->count = kept;
+    list->pumping = 0;
+
+    if (!lua_isnil(L, errorIndex)) {
+        return 1;
+    }
+
+    lua_pop(L, 1);
+
+    return 0;
+}
@@ -0,0 +1,19 @@
+#ifndef AWAIT_H
+#define AWAIT_H
+
+#include <lauxlib.h>
+
+struct AwaitList;
+
+/* FMOD.await(object, state) */
+int await(lua_State *L);
+
+/* Resumes coroutines whose awaited state has been reached. Called from update.
+   Returns 1 and pushes the first error a coroutine raised, else returns 0.
+*/
+int awaitPump(lua_State *L);
+
+/* Frees a list of waits; their coroutines go with the state that owned them */
+void awaitListFree(struct AwaitList *list);
+
+#endif /* AWAIT_H */
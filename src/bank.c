@@ -19,6 +19,7 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include "common.h"
+#include "shadow.h"
 
 #define SELF_TYPE FMOD_STUDIO_BANK
 
@@ -69,6 +70,8 @@ static int METHOD_NAME(unload)(lua_State *L)
 {
     GET_SELF;
 
+    shadowForgetAll(L);
+
     RETURN_STATUS(FMOD_Studio_Bank_Unload(self));
 }
 
@@ -256,6 +259,99 @@ static int METHOD_NAME(getVCAList)(lua_State *L)
     return 1;
 }
 
+static FMOD_RESULT getEventDetails(void *handle, FMOD_GUID *id, char *path, int size, int *retrieved)
+{
+    FMOD_RESULT result = FMOD_Studio_EventDescription_GetID(handle, id);
+
+    if (result != FMOD_OK) {
+        return result;
+    }
+
+    return FMOD_Studio_EventDescription_GetPath(handle, path, size, retrieved);
+}
+
+/* Returns arrays of handles, paths and IDs */
+static int METHOD_NAME(getEventListDetailed)(lua_State *L)
+{
+    GET_SELF;
+
+    int count = 0;
+    RETURN_IF_ERROR(FMOD_Studio_Bank_GetEventCount(self, &count));
+
+    STACKBUFFER_CREATE(FMOD_STUDIO_EVENTDESCRIPTION*, array, count);
+
+    RETURN_IF_ERROR(FMOD_Studio_Bank_GetEventList(self, array, count, &count),
+        STACKBUFFER_RELEASE(array););
+
+    int results = pushDetailedList(L, "FMOD_STUDIO_EVENTDESCRIPTION", (void**)array, count, getEventDetails);
+
+    STACKBUFFER_RELEASE(array);
+
+    return results;
+}
+
+static FMOD_RESULT getBusDetails(void *handle, FMOD_GUID *id, char *path, int size, int *retrieved)
+{
+    FMOD_RESULT result = FMOD_Studio_Bus_GetID(handle, id);
+
+    if (result != FMOD_OK) {
+        return result;
+    }
+
+    return FMOD_Studio_Bus_GetPath(handle, path, size, retrieved);
+}
+
+/* Returns arrays of handles, paths and IDs */
+static int METHOD_NAME(getBusListDetailed)(lua_State *L)
+{
+    GET_SELF;
+
+    int count = 0;
+    RETURN_IF_ERROR(FMOD_Studio_Bank_GetBusCount(self, &count));
+
+    STACKBUFFER_CREATE(FMOD_STUDIO_BUS*, array, count);
+
+    RETURN_IF_ERROR(FMOD_Studio_Bank_GetBusList(self, array, count, &count),
+        STACKBUFFER_RELEASE(array););
+
+    int results = pushDetailedList(L, "FMOD_STUDIO_BUS", (void**)array, count, getBusDetails);
+
+    STACKBUFFER_RELEASE(array);
+
+    return results;
+}
+
+static FMOD_RESULT getVCADetails(void *handle, FMOD_GUID *id, char *path, int size, int *retrieved)
+{
+    FMOD_RESULT result = FMOD_Studio_VCA_GetID(handle, id);
+
+    if (result != FMOD_OK) {
+        return result;
+    }
+
+    return FMOD_Studio_VCA_GetPath(handle, path, size, retrieved);
+}
+
+/* Returns arrays of handles, paths and IDs */
+static int METHOD_NAME(getVCAListDetailed)(lua_State *L)
+{
+    GET_SELF;
+
+    int count = 0;
+    RETURN_IF_ERROR(FMOD_Studio_Bank_GetVCACount(self, &count));
+
+    STACKBUFFER_CREATE(FMOD_STUDIO_VCA*, array, count);
+
+    RETURN_IF_ERROR(FMOD_Studio_Bank_GetVCAList(self, array, count, &count),
+        STACKBUFFER_RELEASE(array););
+
+    int results = pushDetailedList(L, "FMOD_STUDIO_VCA", (void**)array, count, getVCADetails);
+
+    STACKBUFFER_RELEASE(array);
+
+    return results;
+}
+
 METHODS_TABLE_BEGIN
     METHODS_TABLE_ENTRY(isValid)
     METHODS_TABLE_ENTRY(getID)
@@ -269,8 +365,11 @@ METHODS_TABLE_BEGIN
     METHODS_TABLE_ENTRY(getStringInfo)
     METHODS_TABLE_ENTRY(getEventCount)
     METHODS_TABLE_ENTRY(getEventList)
+    METHODS_TABLE_ENTRY(getEventListDetailed)
     METHODS_TABLE_ENTRY(getBusCount)
     METHODS_TABLE_ENTRY(getBusList)
+    METHODS_TABLE_ENTRY(getBusListDetailed)
     METHODS_TABLE_ENTRY(getVCACount)
     METHODS_TABLE_ENTRY(getVCAList)
+    METHODS_TABLE_ENTRY(getVCAListDetailed)
 METHODS_TABLE_END
@@ -0,0 +1,1016 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bankindex.h"
+#include "common.h"
+
+/* A compact, position-independent index of bank metadata.
+
+   Studio.System:buildBankIndex(filename, [stamps]) walks every loaded bank and writes
+   its events, buses, VCAs, parameter descriptions and user properties to a file. Each
+   bank is recorded with its GUID and a caller-supplied modification stamp.
+
+   FMOD.Studio.loadBankIndex(filename) reads that file back as a single block and
+   answers queries from it without calling FMOD. Everything in the file is referenced
+   by offset, so it could equally be memory-mapped.
+
+   Objects whose path FMOD cannot report (because the strings bank is not loaded)
+   are indexed under the empty string at offset 0, so they can only be found by GUID.
+
+   File layout:
+       IndexHeader
+       IndexBank[bankCount]
+       IndexEntry[entryCount]          sorted by path
+       uint32_t[entryCount]            entry indices sorted by GUID
+       IndexParameter[parameterCount]
+       IndexProperty[propertyCount]
+       char[stringBytes]               NUL-terminated strings
+*/
+
+#define INDEX_MAGIC 0x494d464c /* "LFMI" */
+#define INDEX_VERSION 2
+
+/* String offset of the empty string, used for objects without a path */
+#define NO_PATH 0
+
+typedef unsigned int u32;
+
+typedef struct IndexHeader {
+    u32 magic;
+    u32 version;
+    u32 bankCount;
+    u32 entryCount;
+    u32 parameterCount;
+    u32 propertyCount;
+    u32 stringBytes;
+    u32 reserved;
+} IndexHeader;
+
+typedef struct IndexBank {
+    FMOD_GUID id;
+    double stamp;
+    u32 path;
+    u32 reserved;
+} IndexBank;
+
+enum {
+    ENTRY_BANK,
+    ENTRY_EVENT,
+    ENTRY_BUS,
+    ENTRY_VCA,
+};
+
+static const char *ENTRY_KINDS[] = { "bank", "event", "bus", "vca" };
+
+#define ENTRY_KIND_COUNT (sizeof(ENTRY_KINDS) / sizeof(ENTRY_KINDS[0]))
+
+typedef struct IndexEntry {
+    FMOD_GUID id;
+    u32 path;
+    u32 kind;
+    u32 bank;
+    u32 firstParameter;
+    u32 parameterCount;
+    u32 firstProperty;
+    u32 propertyCount;
+    u32 reserved;
+} IndexEntry;
+
+typedef struct IndexParameter {
+    u32 name;
+    u32 type;
+    u32 flags;
+    u32 id1;
+    u32 id2;
+    float minimum;
+    float maximum;
+    float defaultvalue;
+} IndexParameter;
+
+typedef struct IndexProperty {
+    u32 name;
+    u32 type;
+    union {
+        int intvalue;
+        int boolvalue;
+        float floatvalue;
+        u32 stringvalue;
+    } value;
+} IndexProperty;
+
+/* Builder */
+
+typedef struct Table {
+    void *items;
+    u32 count;
+    u32 capacity;
+    size_t itemSize;
+} Table;
+
+typedef struct Builder {
+    Table banks;
+    Table entries;
+    Table parameters;
+    Table properties;
+    Table strings;
+
+    char *path;
+    int pathCapacity;
+
+    /* Scratch handle list */
+    void **handles;
+    int handleCapacity;
+
+    int missingPaths;
+} Builder;
+
+static void *tableAdd(Table *table, u32 count)
+{
+    if (table->count + count > table->capacity) {
+        u32 capacity = table->capacity ? table->capacity : 64;
+
+        while (capacity < table->count + count) {
+            capacity *= 2;
+        }
+
+        void *items = realloc(table->items, capacity * table->itemSize);
+
+        if (!items) {
+            return NULL;
+        }
+
+        table->items = items;
+        table->capacity = capacity;
+    }
+
+    void *result = (char*)table->items + table->count * table->itemSize;
+    table->count += count;
+
+    return result;
+}
+
+/* Adds a string to the pool, setting *offset. Returns 0 if out of memory. */
+static int addString(Builder *builder, const char *string, u32 *offset)
+{
+    size_t length = strlen(string) + 1;
+
+    *offset = builder->strings.count;
+
+    char *destination = tableAdd(&builder->strings, (u32)length);
+
+    if (!destination) {
+        return 0;
+    }
+
+    memcpy(destination, string, length);
+
+    return 1;
+}
+
+static int reservePath(Builder *builder, int size)
+{
+    if (size > builder->pathCapacity) {
+        char *path = realloc(builder->path, size);
+
+        if (!path) {
+            return 0;
+        }
+
+        builder->path = path;
+        builder->pathCapacity = size;
+    }
+
+    return 1;
+}
+
+static int reserveHandles(Builder *builder, int count)
+{
+    if (count > builder->handleCapacity) {
+        void **handles = realloc(builder->handles, sizeof(*handles) * count);
+
+        if (!handles) {
+            return 0;
+        }
+
+        builder->handles = handles;
+        builder->handleCapacity = count;
+    }
+
+    return 1;
+}
+
+/* Reads an object's path into the string pool, or sets offset to NO_PATH if FMOD has
+   no path for it. Expects `result` and `builder` in scope.
+*/
+#define READ_PATH(getPath, handle, offset) \
+    do { \
+        int _size = 0; \
+        result = getPath(handle, NULL, 0, &_size); \
+        if (result == FMOD_ERR_EVENT_NOTFOUND) { \
+            (offset) = NO_PATH; \
+            builder->missingPaths++; \
+            break; \
+        } \
+        if (result != FMOD_OK) return result; \
+        if (!reservePath(builder, _size)) return FMOD_ERR_MEMORY; \
+        result = getPath(handle, builder->path, _size, &_size); \
+        if (result != FMOD_OK) return result; \
+        if (!addString(builder, builder->path, &(offset))) return FMOD_ERR_MEMORY; \
+    } while(0)
+
+/* Fills builder->handles from a GetCount/GetList pair. */
+#define READ_LIST(getCount, getList, owner, type, count) \
+    do { \
+        result = getCount(owner, &(count)); \
+        if (result != FMOD_OK) return result; \
+        if (!reserveHandles(builder, count)) return FMOD_ERR_MEMORY; \
+        result = getList(owner, (type**)builder->handles, count, &(count)); \
+        if (result != FMOD_OK) return result; \
+    } while(0)
+
+static IndexEntry *addEntry(Builder *builder, u32 kind, u32 bank)
+{
+    IndexEntry *entry = tableAdd(&builder->entries, 1);
+
+    if (entry) {
+        memset(entry, 0, sizeof(*entry));
+        entry->kind = kind;
+        entry->bank = bank;
+    }
+
+    return entry;
+}
+
+static FMOD_RESULT addEvent(Builder *builder, FMOD_STUDIO_EVENTDESCRIPTION *description, u32 bank)
+{
+    FMOD_RESULT result = FMOD_OK;
+
+    IndexEntry *entry = addEntry(builder, ENTRY_EVENT, bank);
+    if (!entry) return FMOD_ERR_MEMORY;
+
+    u32 entryIndex = builder->entries.count - 1;
+
+    result = FMOD_Studio_EventDescription_GetID(description, &entry->id);
+    if (result != FMOD_OK) return result;
+
+    u32 pathOffset = 0;
+    READ_PATH(FMOD_Studio_EventDescription_GetPath, description, pathOffset);
+
+    int parameterCount = 0;
+    result = FMOD_Studio_EventDescription_GetParameterDescriptionCount(description, &parameterCount);
+    if (result != FMOD_OK) return result;
+
+    u32 firstParameter = builder->parameters.count;
+
+    for (int i = 0; i < parameterCount; ++i) {
+        FMOD_STUDIO_PARAMETER_DESCRIPTION parameter;
+
+        result = FMOD_Studio_EventDescription_GetParameterDescriptionByIndex(description, i, &parameter);
+        if (result != FMOD_OK) return result;
+
+        u32 nameOffset = 0;
+        if (!addString(builder, parameter.name, &nameOffset)) return FMOD_ERR_MEMORY;
+
+        IndexParameter *record = tableAdd(&builder->parameters, 1);
+        if (!record) return FMOD_ERR_MEMORY;
+
+        record->name = nameOffset;
+        record->type = parameter.type;
+        record->flags = parameter.flags;
+        record->id1 = parameter.id.data1;
+        record->id2 = parameter.id.data2;
+        record->minimum = parameter.minimum;
+        record->maximum = parameter.maximum;
+        record->defaultvalue = parameter.defaultvalue;
+    }
+
+    int propertyCount = 0;
+    result = FMOD_Studio_EventDescription_GetUserPropertyCount(description, &propertyCount);
+    if (result != FMOD_OK) return result;
+
+    u32 firstProperty = builder->properties.count;
+
+    for (int i = 0; i < propertyCount; ++i) {
+        FMOD_STUDIO_USER_PROPERTY property;
+
+        result = FMOD_Studio_EventDescription_GetUserPropertyByIndex(description, i, &property);
+        if (result != FMOD_OK) return result;
+
+        IndexProperty record;
+        memset(&record, 0, sizeof(record));
+
+        if (!addString(builder, property.name, &record.name)) return FMOD_ERR_MEMORY;
+
+        record.type = property.type;
+
+        switch (property.type) {
+        case FMOD_STUDIO_USER_PROPERTY_TYPE_INTEGER:
+            record.value.intvalue = property.intvalue;
+            break;
+        case FMOD_STUDIO_USER_PROPERTY_TYPE_BOOLEAN:
+            record.value.boolvalue = property.boolvalue;
+            break;
+        case FMOD_STUDIO_USER_PROPERTY_TYPE_FLOAT:
+            record.value.floatvalue = property.floatvalue;
+            break;
+        case FMOD_STUDIO_USER_PROPERTY_TYPE_STRING:
+            if (!addString(builder, property.stringvalue, &record.value.stringvalue)) return FMOD_ERR_MEMORY;
+            break;
+        default:
+            break;
+        }
+
+        IndexProperty *destination = tableAdd(&builder->properties, 1);
+        if (!destination) return FMOD_ERR_MEMORY;
+
+        *destination = record;
+    }
+
+    /* The tables may have moved */
+    entry = (IndexEntry*)builder->entries.items + entryIndex;
+    entry->path = pathOffset;
+    entry->firstParameter = firstParameter;
+    entry->parameterCount = builder->parameters.count - firstParameter;
+    entry->firstProperty = firstProperty;
+    entry->propertyCount = builder->properties.count - firstProperty;
+
+    return FMOD_OK;
+}
+
+static FMOD_RESULT addBank(Builder *builder, FMOD_STUDIO_BANK *bank, lua_State *L, int stampsIndex)
+{
+    FMOD_RESULT result = FMOD_OK;
+
+    u32 bankIndex = builder->banks.count;
+
+    IndexBank *record = tableAdd(&builder->banks, 1);
+    if (!record) return FMOD_ERR_MEMORY;
+
+    memset(record, 0, sizeof(*record));
+
+    result = FMOD_Studio_Bank_GetID(bank, &record->id);
+    if (result != FMOD_OK) return result;
+
+    u32 pathOffset = 0;
+    READ_PATH(FMOD_Studio_Bank_GetPath, bank, pathOffset);
+
+    record = (IndexBank*)builder->banks.items + bankIndex;
+    record->path = pathOffset;
+
+    if (stampsIndex && pathOffset != NO_PATH) {
+        lua_getfield(L, stampsIndex, builder->path);
+        record->stamp = lua_tonumber(L, -1);
+        lua_pop(L, 1);
+    }
+
+    IndexEntry *entry = addEntry(builder, ENTRY_BANK, bankIndex);
+    if (!entry) return FMOD_ERR_MEMORY;
+
+    entry->id = record->id;
+    entry->path = pathOffset;
+
+    int count = 0;
+
+    READ_LIST(FMOD_Studio_Bank_GetEventCount, FMOD_Studio_Bank_GetEventList, bank,
+        FMOD_STUDIO_EVENTDESCRIPTION, count);
+
+    for (int i = 0; i < count; ++i) {
+        result = addEvent(builder, builder->handles[i], bankIndex);
+        if (result != FMOD_OK) return result;
+    }
+
+    READ_LIST(FMOD_Studio_Bank_GetBusCount, FMOD_Studio_Bank_GetBusList, bank, FMOD_STUDIO_BUS, count);
+
+    for (int i = 0; i < count; ++i) {
+        FMOD_STUDIO_BUS *bus = builder->handles[i];
+
+        IndexEntry *busEntry = addEntry(builder, ENTRY_BUS, bankIndex);
+        if (!busEntry) return FMOD_ERR_MEMORY;
+
+        result = FMOD_Studio_Bus_GetID(bus, &busEntry->id);
+        if (result != FMOD_OK) return result;
+
+        u32 entryIndex = builder->entries.count - 1;
+
+        READ_PATH(FMOD_Studio_Bus_GetPath, bus, pathOffset);
+
+        ((IndexEntry*)builder->entries.items)[entryIndex].path = pathOffset;
+    }
+
+    READ_LIST(FMOD_Studio_Bank_GetVCACount, FMOD_Studio_Bank_GetVCAList, bank, FMOD_STUDIO_VCA, count);
+
+    for (int i = 0; i < count; ++i) {
+        FMOD_STUDIO_VCA *vca = builder->handles[i];
+
+        IndexEntry *vcaEntry = addEntry(builder, ENTRY_VCA, bankIndex);
+        if (!vcaEntry) return FMOD_ERR_MEMORY;
+
+        result = FMOD_Studio_VCA_GetID(vca, &vcaEntry->id);
+        if (result != FMOD_OK) return result;
+
+        u32 entryIndex = builder->entries.count - 1;
+
+        READ_PATH(FMOD_Studio_VCA_GetPath, vca, pathOffset);
+
+        ((IndexEntry*)builder->entries.items)[entryIndex].path = pathOffset;
+    }
+
+    return FMOD_OK;
+}
+
+#undef READ_PATH
+#undef READ_LIST
+
+/* qsort has no context argument, so keys are sorted together with their entry index */
+typedef struct PathKey {
+    const char *path;
+    u32 index;
+} PathKey;
+
+typedef struct IDKey {
+    FMOD_GUID id;
+    u32 index;
+} IDKey;
+
+static int comparePathKeys(const void *a, const void *b)
+{
+    return strcmp(((const PathKey*)a)->path, ((const PathKey*)b)->path);
+}
+
+static int compareIDKeys(const void *a, const void *b)
+{
+    return memcmp(&((const IDKey*)a)->id, &((const IDKey*)b)->id, sizeof(FMOD_GUID));
+}
+
+static FMOD_RESULT sortEntriesByPath(IndexEntry *entries, u32 entryCount, const char *strings)
+{
+    PathKey *keys = malloc(sizeof(*keys) * (entryCount ? entryCount : 1));
+    IndexEntry *sorted = malloc(sizeof(*sorted) * (entryCount ? entryCount : 1));
+
+    if (!keys || !sorted) {
+        free(keys);
+        free(sorted);
+        return FMOD_ERR_MEMORY;
+    }
+
+    for (u32 i = 0; i < entryCount; ++i) {
+        keys[i].path = strings + entries[i].path;
+        keys[i].index = i;
+    }
+
+    qsort(keys, entryCount, sizeof(*keys), comparePathKeys);
+
+    for (u32 i = 0; i < entryCount; ++i) {
+        sorted[i] = entries[keys[i].index];
+    }
+
+    memcpy(entries, sorted, sizeof(*entries) * entryCount);
+
+    free(keys);
+    free(sorted);
+
+    return FMOD_OK;
+}
+
+/* Fills byID with entry indices in ID order */
+static FMOD_RESULT sortIndicesByID(const IndexEntry *entries, u32 entryCount, u32 *byID)
+{
+    IDKey *keys = malloc(sizeof(*keys) * (entryCount ? entryCount : 1));
+
+    if (!keys) {
+        return FMOD_ERR_MEMORY;
+    }
+
+    for (u32 i = 0; i < entryCount; ++i) {
+        keys[i].id = entries[i].id;
+        keys[i].index = i;
+    }
+
+    qsort(keys, entryCount, sizeof(*keys), compareIDKeys);
+
+    for (u32 i = 0; i < entryCount; ++i) {
+        byID[i] = keys[i].index;
+    }
+
+    free(keys);
+
+    return FMOD_OK;
+}
+
+static FMOD_RESULT writeIndex(Builder *builder, const char *filename)
+{
+    IndexEntry *entries = builder->entries.items;
+    u32 entryCount = builder->entries.count;
+
+    FMOD_RESULT result = sortEntriesByPath(entries, entryCount, builder->strings.items);
+
+    if (result != FMOD_OK) {
+        return result;
+    }
+
+    u32 *byID = malloc(sizeof(*byID) * (entryCount ? entryCount : 1));
+
+    if (!byID) {
+        return FMOD_ERR_MEMORY;
+    }
+
+    result = sortIndicesByID(entries, entryCount, byID);
+
+    if (result != FMOD_OK) {
+        free(byID);
+        return result;
+    }
+
+    IndexHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = INDEX_MAGIC;
+    header.version = INDEX_VERSION;
+    header.bankCount = builder->banks.count;
+    header.entryCount = entryCount;
+    header.parameterCount = builder->parameters.count;
+    header.propertyCount = builder->properties.count;
+    header.stringBytes = builder->strings.count;
+
+    FILE *file = fopen(filename, "wb");
+
+    if (!file) {
+        free(byID);
+        return FMOD_ERR_FILE_NOTFOUND;
+    }
+
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(builder->banks.items, sizeof(IndexBank), header.bankCount, file) == header.bankCount
+        && fwrite(entries, sizeof(IndexEntry), entryCount, file) == entryCount
+        && fwrite(byID, sizeof(*byID), entryCount, file) == entryCount
+        && fwrite(builder->parameters.items, sizeof(IndexParameter), header.parameterCount, file) == header.parameterCount
+        && fwrite(builder->properties.items, sizeof(IndexProperty), header.propertyCount, file) == header.propertyCount
+        && fwrite(builder->strings.items, 1, header.stringBytes, file) == header.stringBytes;
+
+    ok = (fclose(file) == 0) && ok;
+
+    free(byID);
+
+    return ok ? FMOD_OK : FMOD_ERR_FILE_BAD;
+}
+
+static FMOD_RESULT build(Builder *builder, FMOD_STUDIO_SYSTEM *system, const char *filename,
+    lua_State *L, int stampsIndex)
+{
+    FMOD_RESULT result = FMOD_OK;
+
+    u32 emptyPath = 0;
+    if (!addString(builder, "", &emptyPath)) return FMOD_ERR_MEMORY;
+
+    int bankCount = 0;
+    result = FMOD_Studio_System_GetBankCount(system, &bankCount);
+    if (result != FMOD_OK) return result;
+
+    FMOD_STUDIO_BANK **banks = malloc(sizeof(*banks) * (bankCount ? bankCount : 1));
+    if (!banks) return FMOD_ERR_MEMORY;
+
+    result = FMOD_Studio_System_GetBankList(system, banks, bankCount, &bankCount);
+
+    for (int i = 0; i < bankCount && result == FMOD_OK; ++i) {
+        result = addBank(builder, banks[i], L, stampsIndex);
+    }
+
+    free(banks);
+
+    if (result == FMOD_OK) {
+        result = writeIndex(builder, filename);
+    }
+
+    return result;
+}
+
+int bankIndexBuild(lua_State *L, FMOD_STUDIO_SYSTEM *system, int filenameIndex, int stampsIndex)
+{
+    const char *filename = luaL_checkstring(L, filenameIndex);
+
+    if (lua_isnoneornil(L, stampsIndex)) {
+        stampsIndex = 0;
+    } else {
+        luaL_checktype(L, stampsIndex, LUA_TTABLE);
+    }
+
+    Builder builder;
+    memset(&builder, 0, sizeof(builder));
+    builder.banks.itemSize = sizeof(IndexBank);
+    builder.entries.itemSize = sizeof(IndexEntry);
+    builder.parameters.itemSize = sizeof(IndexParameter);
+    builder.properties.itemSize = sizeof(IndexProperty);
+    builder.strings.itemSize = 1;
+
+    FMOD_RESULT result = build(&builder, system, filename, L, stampsIndex);
+
+    free(builder.banks.items);
+    free(builder.entries.items);
+    free(builder.parameters.items);
+    free(builder.properties.items);
+    free(builder.strings.items);
+    free(builder.path);
+    free(builder.handles);
+
+    RETURN_IF_ERROR(result);
+
+    lua_pushboolean(L, 1);
+    lua_pushinteger(L, builder.missingPaths);
+
+    return 2;
+}
+
+/* Loaded index */
+
+struct luaFMOD_BankIndex {
+    void *data;
+    const IndexHeader *header;
+    const IndexBank *banks;
+    const IndexEntry *entries;
+    const u32 *byID;
+    const IndexParameter *parameters;
+    const IndexProperty *properties;
+    const char *strings;
+};
+
+#define SELF_TYPE luaFMOD_BankIndex
+
+#undef GET_SELF
+#define GET_SELF \
+    SELF_TYPE *self = (SELF_TYPE*)luaL_checkudata(L, 1, STRINGIZE(SELF_TYPE)); \
+    if (!self->data) return luaL_error(L, "bank index has been released")
+
+static int validate(luaFMOD_BankIndex *index, size_t size)
+{
+    const IndexHeader *header = index->header;
+
+    if (size < sizeof(*header) || header->magic != INDEX_MAGIC || header->version != INDEX_VERSION) {
+        return 0;
+    }
+
+    /* In 64 bits, so that huge counts cannot wrap on 32-bit platforms */
+    unsigned long long expected = sizeof(*header)
+        + (unsigned long long)header->bankCount * sizeof(IndexBank)
+        + (unsigned long long)header->entryCount * (sizeof(IndexEntry) + sizeof(u32))
+        + (unsigned long long)header->parameterCount * sizeof(IndexParameter)
+        + (unsigned long long)header->propertyCount * sizeof(IndexProperty)
+        + header->stringBytes;
+
+    if (size != expected || header->stringBytes == 0 || index->strings[NO_PATH] != '\0'
+        || index->strings[header->stringBytes - 1] != '\0') {
+        return 0;
+    }
+
+    for (u32 i = 0; i < header->entryCount; ++i) {
+        const IndexEntry *entry = &index->entries[i];
+
+        if (entry->path >= header->stringBytes
+            || entry->kind >= ENTRY_KIND_COUNT
+            || entry->bank >= header->bankCount
+            || index->byID[i] >= header->entryCount
+            || (unsigned long long)entry->firstParameter + entry->parameterCount > header->parameterCount
+            || (unsigned long long)entry->firstProperty + entry->propertyCount > header->propertyCount) {
+            return 0;
+        }
+    }
+
+    for (u32 i = 0; i < header->bankCount; ++i) {
+        if (index->banks[i].path >= header->stringBytes) {
+            return 0;
+        }
+    }
+
+    for (u32 i = 0; i < header->parameterCount; ++i) {
+        if (index->parameters[i].name >= header->stringBytes) {
+            return 0;
+        }
+    }
+
+    for (u32 i = 0; i < header->propertyCount; ++i) {
+        const IndexProperty *property = &index->properties[i];
+
+        if (property->name >= header->stringBytes
+            || (property->type == FMOD_STUDIO_USER_PROPERTY_TYPE_STRING
+                && property->value.stringvalue >= header->stringBytes)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int loadBankIndex(lua_State *L)
+{
+    const char *filename = luaL_checkstring(L, 1);
+
+    FILE *file = fopen(filename, "rb");
+
+    if (!file) {
+        return pushError(L, FMOD_ERR_FILE_NOTFOUND);
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    void *data = size > 0 ? malloc(size) : NULL;
+
+    if (!data || fread(data, 1, size, file) != (size_t)size) {
+        fclose(file);
+        free(data);
+
+        return pushError(L, FMOD_ERR_FILE_BAD);
+    }
+
+    fclose(file);
+
+    luaFMOD_BankIndex *index = lua_newuserdata(L, sizeof(*index));
+
+    const char *cursor = data;
+
+    index->data = data;
+    index->header = (const IndexHeader*)cursor;
+    cursor += sizeof(IndexHeader);
+
+    /* Only dereference the counts once we know the header is there */
+    if ((size_t)size >= sizeof(IndexHeader)) {
+        index->banks = (const IndexBank*)cursor;
+        cursor += index->header->bankCount * sizeof(IndexBank);
+        index->entries = (const IndexEntry*)cursor;
+        cursor += index->header->entryCount * sizeof(IndexEntry);
+        index->byID = (const u32*)cursor;
+        cursor += index->header->entryCount * sizeof(u32);
+        index->parameters = (const IndexParameter*)cursor;
+        cursor += index->header->parameterCount * sizeof(IndexParameter);
+        index->properties = (const IndexProperty*)cursor;
+        cursor += index->header->propertyCount * sizeof(IndexProperty);
+        index->strings = cursor;
+    }
+
+    if (!validate(index, (size_t)size)) {
+        free(data);
+        index->data = NULL;
+
+        return pushError(L, FMOD_ERR_FORMAT);
+    }
+
+    luaL_getmetatable(L, STRINGIZE(SELF_TYPE));
+    lua_setmetatable(L, -2);
+
+    return 1;
+}
+
+static const IndexEntry *findByPath(luaFMOD_BankIndex *index, const char *path)
+{
+    u32 low = 0;
+    u32 high = index->header->entryCount;
+
+    if (path[0] == '\0') {
+        return NULL;
+    }
+
+    while (low < high) {
+        u32 middle = low + (high - low) / 2;
+        int comparison = strcmp(index->strings + index->entries[middle].path, path);
+
+        if (comparison == 0) {
+            return &index->entries[middle];
+        } else if (comparison < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return NULL;
+}
+
+static const IndexEntry *findByID(luaFMOD_BankIndex *index, const FMOD_GUID *id)
+{
+    u32 low = 0;
+    u32 high = index->header->entryCount;
+
+    while (low < high) {
+        u32 middle = low + (high - low) / 2;
+        const IndexEntry *entry = &index->entries[index->byID[middle]];
+        int comparison = memcmp(&entry->id, id, sizeof(*id));
+
+        if (comparison == 0) {
+            return entry;
+        } else if (comparison < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return NULL;
+}
+
+/* Accepts a path string or a GUID struct */
+static const IndexEntry *checkEntry(lua_State *L, luaFMOD_BankIndex *index, int argument)
+{
+    if (lua_type(L, argument) == LUA_TSTRING) {
+        return findByPath(index, lua_tostring(L, argument));
+    } else {
+        return findByID(index, CHECK_STRUCT(L, argument, FMOD_GUID));
+    }
+}
+
+static int METHOD_NAME(__gc)(lua_State *L)
+{
+    SELF_TYPE *self = (SELF_TYPE*)luaL_checkudata(L, 1, STRINGIZE(SELF_TYPE));
+
+    free(self->data);
+    self->data = NULL;
+
+    return 0;
+}
+
+static int METHOD_NAME(release)(lua_State *L)
+{
+    return METHOD_NAME(__gc)(L);
+}
+
+/* getBankStamp(bankPathOrID)
+   Returns the stamp recorded for the bank, or nil if the bank is not in the index.
+*/
+static int METHOD_NAME(getBankStamp)(lua_State *L)
+{
+    GET_SELF;
+
+    const IndexEntry *entry = checkEntry(L, self, 2);
+
+    if (!entry || entry->kind != ENTRY_BANK) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    lua_pushnumber(L, self->banks[entry->bank].stamp);
+
+    return 1;
+}
+
+static void pushPath(lua_State *L, luaFMOD_BankIndex *index, u32 path)
+{
+    if (path == NO_PATH) {
+        lua_pushnil(L);
+    } else {
+        lua_pushstring(L, index->strings + path);
+    }
+}
+
+/* lookup(pathOrID)
+   Returns kind ("bank", "event", "bus" or "vca"), path, GUID and owning bank path, or
+   nil if there is no such object. Paths are nil if they were unknown when the index
+   was built.
+*/
+static int METHOD_NAME(lookup)(lua_State *L)
+{
+    GET_SELF;
+
+    const IndexEntry *entry = checkEntry(L, self, 2);
+
+    if (!entry) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    lua_pushstring(L, ENTRY_KINDS[entry->kind]);
+    pushPath(L, self, entry->path);
+    PUSH_STRUCT(L, FMOD_GUID, entry->id);
+    pushPath(L, self, self->banks[entry->bank].path);
+
+    return 4;
+}
+
+/* getParameter(eventPathOrID, name)
+   Returns minimum, maximum, default value, type, flags and ID, or nil.
+*/
+static int METHOD_NAME(getParameter)(lua_State *L)
+{
+    GET_SELF;
+
+    const IndexEntry *entry = checkEntry(L, self, 2);
+    const char *name = luaL_checkstring(L, 3);
+
+    if (entry) {
+        for (u32 i = 0; i < entry->parameterCount; ++i) {
+            const IndexParameter *parameter = &self->parameters[entry->firstParameter + i];
+
+            if (strcmp(self->strings + parameter->name, name) == 0) {
+                FMOD_STUDIO_PARAMETER_ID id = { parameter->id1, parameter->id2 };
+
+                lua_pushnumber(L, parameter->minimum);
+                lua_pushnumber(L, parameter->maximum);
+                lua_pushnumber(L, parameter->defaultvalue);
+                PUSH_CONSTANT(L, FMOD_STUDIO_PARAMETER_TYPE, parameter->type);
+                PUSH_CONSTANT(L, FMOD_STUDIO_PARAMETER_FLAGS, parameter->flags);
+                PUSH_STRUCT(L, FMOD_STUDIO_PARAMETER_ID, id);
+
+                return 6;
+            }
+        }
+    }
+
+    lua_pushnil(L);
+    return 1;
+}
+
+/* getParameterNames(eventPathOrID)
+   Returns an array of the event's parameter names, or nil.
+*/
+static int METHOD_NAME(getParameterNames)(lua_State *L)
+{
+    GET_SELF;
+
+    const IndexEntry *entry = checkEntry(L, self, 2);
+
+    if (!entry) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    lua_createtable(L, entry->parameterCount, 0);
+
+    for (u32 i = 0; i < entry->parameterCount; ++i) {
+        lua_pushstring(L, self->strings + self->parameters[entry->firstParameter + i].name);
+        lua_rawseti(L, -2, i + 1);
+    }
+
+    return 1;
+}
+
+/* getUserProperty(eventPathOrID, name)
+   Returns the property's value, or nil.
+*/
+static int METHOD_NAME(getUserProperty)(lua_State *L)
+{
+    GET_SELF;
+
+    const IndexEntry *entry = checkEntry(L, self, 2);
+    const char *name = luaL_checkstring(L, 3);
+
+    if (entry) {
+        for (u32 i = 0; i < entry->propertyCount; ++i) {
+            const IndexProperty *property = &self->properties[entry->firstProperty + i];
+
+            if (strcmp(self->strings + property->name, name) != 0) {
+                continue;
+            }
+
+            switch (property->type) {
+            case FMOD_STUDIO_USER_PROPERTY_TYPE_INTEGER:
+                lua_pushinteger(L, property->value.intvalue);
+                break;
+            case FMOD_STUDIO_USER_PROPERTY_TYPE_BOOLEAN:
+                lua_pushboolean(L, property->value.boolvalue);
+                break;
+            case FMOD_STUDIO_USER_PROPERTY_TYPE_FLOAT:
+                lua_pushnumber(L, property->value.floatvalue);
+                break;
+            case FMOD_STUDIO_USER_PROPERTY_TYPE_STRING:
+                lua_pushstring(L, self->strings + property->value.stringvalue);
+                break;
+            default:
+                lua_pushnil(L);
+                break;
+            }
+
+            return 1;
+        }
+    }
+
+    lua_pushnil(L);
+    return 1;
+}
+
+METHODS_TABLE_BEGIN
+    METHODS_TABLE_ENTRY(__gc)
+    METHODS_TABLE_ENTRY(release)
+    METHODS_TABLE_ENTRY(getBankStamp)
+    METHODS_TABLE_ENTRY(lookup)
+    METHODS_TABLE_ENTRY(getParameter)
+    METHODS_TABLE_ENTRY(getParameterNames)
+    METHODS_TABLE_ENTRY(getUserProperty)
+METHODS_TABLE_END
@@ -0,0 +1,14 @@
+#ifndef BANKINDEX_H
+#define BANKINDEX_H
+
+#include <fmod_studio.h>
+#include <lauxlib.h>
+
+typedef struct luaFMOD_BankIndex luaFMOD_BankIndex;
+
+int bankIndexBuild(lua_State *L, FMOD_STUDIO_SYSTEM *system, int filenameIndex, int stampsIndex);
+
+/* FMOD.Studio.loadBankIndex(filename) */
+int loadBankIndex(lua_State *L);
+
+#endif /* BANKINDEX_H */
@@ -0,0 +1,279 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bankloader.h"
+#include "common.h"
+#include "platform.h"
+#include "studiosystem.h"
+
+/* Batch bank loading. Every bank is issued as a non-blocking load so Studio can
+   work on them together, optionally after reading the files into memory on a
+   small pool of reader threads (Studio's own file loading uses a single thread).
+   The caller then waits here, driving update, until each bank is LOADED or ERROR.
+   If an update fails, every bank this call loaded is unloaded again before the
+   error is returned. If a callback run by an update raises an error, the banks
+   still finish loading and stay loaded, and the error is raised afterwards.
+*/
+
+#define POLL_INTERVAL 0.001
+
+typedef struct BankLoad {
+    const char *path;
+    char *data;
+    long length;
+    FMOD_STUDIO_BANK *bank;
+    FMOD_RESULT result;
+    double readTime;
+    double loadTime;
+    int done;
+} BankLoad;
+
+typedef struct ReaderPool {
+    BankLoad *loads;
+    long count;
+    volatile long next;
+    double start;
+} ReaderPool;
+
+static FMOD_RESULT readFile(BankLoad *load)
+{
+    FILE *file = fopen(load->path, "rb");
+
+    if (!file) {
+        return FMOD_ERR_FILE_NOTFOUND;
+    }
+
+    FMOD_RESULT result = FMOD_OK;
+
+    if (fseek(file, 0, SEEK_END) != 0 || (load->length = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        result = FMOD_ERR_FILE_BAD;
+    } else if (!(load->data = malloc(load->length > 0 ? load->length : 1))) {
+        result = FMOD_ERR_MEMORY;
+    } else if (fread(load->data, 1, load->length, file) != (size_t)load->length) {
+        free(load->data);
+        load->data = NULL;
+        result = FMOD_ERR_FILE_BAD;
+    }
+
+    fclose(file);
+
+    return result;
+}
+
+/* Runs on each reader thread and on the calling thread, taking files in turn */
+static void readerMain(void *userdata)
+{
+    ReaderPool *pool = userdata;
+
+    for (long i = atomicAdd(&pool->next, 1) - 1; i < pool->count; i = atomicAdd(&pool->next, 1) - 1) {
+        BankLoad *load = &pool->loads[i];
+
+        load->result = readFile(load);
+        load->readTime = platformGetTime() - pool->start;
+    }
+}
+
+static void readFiles(BankLoad *loads, int count, int readers, double start)
+{
+    ReaderPool pool = { loads, count, 0, start };
+    LUAFMOD_THREAD *threads[16];
+
+    int threadCount = readers - 1;
+
+    if (threadCount > count - 1) {
+        threadCount = count - 1;
+    }
+
+    if (threadCount > (int)(sizeof(threads) / sizeof(threads[0]))) {
+        threadCount = (int)(sizeof(threads) / sizeof(threads[0]));
+    }
+
+    int started = 0;
+
+    while (started < threadCount && (threads[started] = threadCreate(readerMain, &pool)) != NULL) {
+        started++;
+    }
+
+    readerMain(&pool);
+
+    for (int t = 0; t < started; ++t) {
+        threadJoin(threads[t]);
+    }
+}
+
+static void issueLoad(FMOD_STUDIO_SYSTEM *system, BankLoad *load, FMOD_STUDIO_LOAD_BANK_FLAGS flags, int inMemory)
+{
+    if (inMemory) {
+        if (load->result == FMOD_OK) {
+            /* FMOD_STUDIO_LOAD_MEMORY copies the buffer, so it can be freed straight away */
+            load->result = FMOD_Studio_System_LoadBankMemory(system, load->data, (int)load->length,
+                FMOD_STUDIO_LOAD_MEMORY, flags, &load->bank);
+        }
+
+        free(load->data);
+        load->data = NULL;
+    } else {
+        load->result = FMOD_Studio_System_LoadBankFile(system, load->path, flags, &load->bank);
+    }
+
+    if (load->result != FMOD_OK) {
+        load->done = 1;
+    }
+}
+
+/* Returns the number of banks still loading */
+static int pollLoads(BankLoad *loads, int count, double start)
+{
+    int pending = 0;
+
+    for (int i = 0; i < count; ++i) {
+        BankLoad *load = &loads[i];
+
+        if (load->done) {
+            continue;
+        }
+
+        FMOD_STUDIO_LOADING_STATE state = FMOD_STUDIO_LOADING_STATE_LOADING;
+        FMOD_RESULT result = FMOD_Studio_Bank_GetLoadingState(load->bank, &state);
+
+        if (result != FMOD_OK || state == FMOD_STUDIO_LOADING_STATE_ERROR) {
+            load->result = result != FMOD_OK ? result : FMOD_ERR_FILE_BAD;
+
+            /* Failed banks aren't returned, so unload them here */
+            FMOD_Studio_Bank_Unload(load->bank);
+        } else if (state != FMOD_STUDIO_LOADING_STATE_LOADED) {
+            pending++;
+            continue;
+        }
+
+        load->done = 1;
+        load->loadTime = platformGetTime() - start;
+    }
+
+    return pending;
+}
+
+/* Unloads the banks that loaded or are still loading */
+static void unloadAll(BankLoad *loads, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        if (loads[i].bank && loads[i].result == FMOD_OK) {
+            FMOD_Studio_Bank_Unload(loads[i].bank);
+        }
+    }
+}
+
+int bankLoaderRun(lua_State *L, FMOD_STUDIO_SYSTEM *system, int pathsIndex,
+    FMOD_STUDIO_LOAD_BANK_FLAGS flags, int readers)
+{
+    luaL_checktype(L, pathsIndex, LUA_TTABLE);
+
+    int count = (int)lua_objlen(L, pathsIndex);
+
+    /* Userdata rather than a STACKBUFFER, since update resets the scratch arena */
+    BankLoad *loads = lua_newuserdata(L, sizeof(BankLoad) * (count > 0 ? count : 1));
+
+    for (int i = 0; i < count; ++i) {
+        lua_rawgeti(L, pathsIndex, i + 1);
+
+        /* Only real strings stay referenced by the paths table once popped; a
+           number would be converted into a string nothing keeps alive */
+        if (lua_type(L, -1) != LUA_TSTRING) {
+            return luaL_argerror(L, pathsIndex, "paths must be strings");
+        }
+
+        const char *path = lua_tostring(L, -1);
+        lua_pop(L, 1);
+
+        BankLoad load = { path, NULL, 0, NULL, FMOD_OK, 0, 0, 0 };
+        loads[i] = load;
+    }
+
+    flags |= FMOD_STUDIO_LOAD_BANK_NONBLOCKING;
+
+    double start = platformGetTime();
+
+    if (readers > 0 && count > 0) {
+        readFiles(loads, count, readers, start);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        issueLoad(system, &loads[i], flags, readers > 0);
+    }
+
+    lua_pushnil(L);
+    int errorIndex = lua_gettop(L);
+
+    while (pollLoads(loads, count, start) > 0) {
+        /* Loading states are only published by update. A callback error doesn't stop
+           the wait; the first one is rethrown once the banks have loaded.
+        */
+        FMOD_RESULT result = FMOD_OK;
+
+        if (studioSystemProtectedUpdate(L, system, &result) != 0) {
+            if (lua_isnil(L, errorIndex)) {
+                lua_replace(L, errorIndex);
+            } else {
+                lua_pop(L, 1);
+            }
+        } else if (result != FMOD_OK) {
+            unloadAll(loads, count);
+            return pushError(L, result);
+        }
+
+        platformSleep(POLL_INTERVAL);
+    }
+
+    if (!lua_isnil(L, errorIndex)) {
+        lua_pushvalue(L, errorIndex);
+        return lua_error(L);
+    }
+
+    lua_createtable(L, count, 0);
+
+    for (int i = 0; i < count; ++i) {
+        BankLoad *load = &loads[i];
+
+        lua_createtable(L, 0, 4);
+
+        if (load->result == FMOD_OK) {
+            PUSH_HANDLE(L, FMOD_STUDIO_BANK, load->bank);
+            lua_setfield(L, -2, "bank");
+        }
+
+        lua_pushinteger(L, load->result);
+        lua_setfield(L, -2, "result");
+
+        lua_pushnumber(L, load->readTime);
+        lua_setfield(L, -2, "readTime");
+
+        lua_pushnumber(L, load->loadTime);
+        lua_setfield(L, -2, "loadTime");
+
+        lua_rawseti(L, -2, i + 1);
+    }
+
+    lua_pushnumber(L, platformGetTime() - start);
+
+    return 2;
+}
@@ -0,0 +1,13 @@
+#ifndef BANKLOADER_H
+#define BANKLOADER_H
+
+#include <fmod_studio.h>
+#include <lauxlib.h>
+
+/* Loads the banks named in the table at pathsIndex and pushes a table of results.
+   If readers is positive, files are read into memory on that many threads first.
+*/
+int bankLoaderRun(lua_State *L, FMOD_STUDIO_SYSTEM *system, int pathsIndex,
+    FMOD_STUDIO_LOAD_BANK_FLAGS flags, int readers);
+
+#endif /* BANKLOADER_H */
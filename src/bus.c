@@ -19,6 +19,7 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include "common.h"
+#include "shadow.h"
 
 #define SELF_TYPE FMOD_STUDIO_BUS
 
@@ -85,7 +86,14 @@ static int METHOD_NAME(setVolume)(lua_State *L)
 
     float volume = (float)luaL_checknumber(L, 2);
 
-    RETURN_STATUS(FMOD_Studio_Bus_SetVolume(self, volume));
+    if (shadowIsRedundant(L, self, SHADOW_VOLUME, &volume)) {
+        RETURN_STATUS(FMOD_OK);
+    }
+
+    FMOD_RESULT result = FMOD_Studio_Bus_SetVolume(self, volume);
+    shadowRecord(L, self, SHADOW_VOLUME, &volume, result);
+
+    RETURN_STATUS(result);
 }
 
 static int METHOD_NAME(getPaused)(lua_State *L)
@@ -105,8 +113,16 @@ static int METHOD_NAME(setPaused)(lua_State *L)
     GET_SELF;
 
     int paused = lua_toboolean(L, 2);
+    float shadowValue = (float)paused;
+
+    if (shadowIsRedundant(L, self, SHADOW_PAUSED, &shadowValue)) {
+        RETURN_STATUS(FMOD_OK);
+    }
+
+    FMOD_RESULT result = FMOD_Studio_Bus_SetPaused(self, paused);
+    shadowRecord(L, self, SHADOW_PAUSED, &shadowValue, result);
 
-    RETURN_STATUS(FMOD_Studio_Bus_SetPaused(self, paused));
+    RETURN_STATUS(result);
 }
 
 static int METHOD_NAME(getMute)(lua_State *L)
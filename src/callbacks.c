@@ -24,40 +24,33 @@ DEALINGS IN THE SOFTWARE.
 
 #include "callbacks.h"
 #include "common.h"
-#include "platform.h"
+#include "context.h"
 
-static LUAFMOD_CRITICAL_SECTION *sCriticalSection = NULL;
-static lua_State *sCallbackState = NULL;
-
-static FMOD_RESULT affirmCriticalSection()
-{
-    if (!sCriticalSection) {
-        sCriticalSection = criticalSectionCreate();
-
-        if (!sCriticalSection) {
-            return FMOD_ERR_MEMORY;
-        }
-    }
-
-    return FMOD_OK;
-}
+/* Callbacks run on FMOD threads in a separate lua_State, one per context, guarded
+   by the context's callback lock. Callback functions and userdata are copied into
+   that state when they are set.
+*/
 
 extern int LUAFMOD_EXPORT luaopen_luaFMOD(lua_State *L);
 
-static FMOD_RESULT affirmCallbackState(lua_State *L)
+static FMOD_RESULT affirmCallbackState(lua_State *L, luaFMOD_Context *context)
 {
-    if (!sCallbackState) {
+    if (!context->callbackState) {
         void *userdata = NULL;
         lua_Alloc alloc = lua_getallocf(L, &userdata);
 
-        sCallbackState = lua_newstate(alloc, userdata);
+        lua_State *callbackState = lua_newstate(alloc, userdata);
 
-        if (!sCallbackState) {
+        if (!callbackState) {
             return FMOD_ERR_MEMORY;
         }
 
-        luaL_openlibs(sCallbackState);
-        luaopen_luaFMOD(sCallbackState);
+        contextShare(callbackState, context);
+
+        luaL_openlibs(callbackState);
+        luaopen_luaFMOD(callbackState);
+
+        context->callbackState = callbackState;
     }
 
     return FMOD_OK;
@@ -66,28 +59,16 @@ static FMOD_RESULT affirmCallbackState(lua_State *L)
 #define CALLBACK_TABLE "luaFMOD_Callbacks"
 #define USERDATA_TABLE "luaFMOD_Userdata"
 
-static void affirmCallbacksTable()
+static void affirmTable(lua_State *L, const char *name)
 {
-    lua_getfield(sCallbackState, LUA_REGISTRYINDEX, CALLBACK_TABLE);
+    lua_getfield(L, LUA_REGISTRYINDEX, name);
 
-    if (lua_isnil(sCallbackState, -1)) {
-        lua_newtable(sCallbackState);
-        lua_setfield(sCallbackState, LUA_REGISTRYINDEX, CALLBACK_TABLE);
+    if (lua_isnil(L, -1)) {
+        lua_newtable(L);
+        lua_setfield(L, LUA_REGISTRYINDEX, name);
     }
 
-    lua_pop(sCallbackState, 1);
-}
-
-static void affirmUserdataTable()
-{
-    lua_getfield(sCallbackState, LUA_REGISTRYINDEX, USERDATA_TABLE);
-
-    if (lua_isnil(sCallbackState, -1)) {
-        lua_newtable(sCallbackState);
-        lua_setfield(sCallbackState, LUA_REGISTRYINDEX, USERDATA_TABLE);
-    }
-
-    lua_pop(sCallbackState, 1);
+    lua_pop(L, 1);
 }
 
 #define CHUNK_CAPACITY_DEFAULT 128
@@ -180,9 +161,22 @@ static void chunkListFree(ChunkList *chunkList)
 FMOD_RESULT F_CALLBACK eventCallback(FMOD_STUDIO_EVENT_CALLBACK_TYPE type, FMOD_STUDIO_EVENTINSTANCE *event,
     void *parameters)
 {
-    criticalSectionEnter(sCriticalSection);
+    luaFMOD_Context *context = NULL;
+
+    if (FMOD_Studio_EventInstance_GetUserData(event, (void**)&context) != FMOD_OK || !context) {
+        return FMOD_OK;
+    }
+
+    criticalSectionEnter(context->callbackLock);
 
-    lua_State *L = sCallbackState;
+    lua_State *L = context->callbackState;
+
+    if (!L) {
+        criticalSectionLeave(context->callbackLock);
+        return FMOD_OK;
+    }
+
+    int top = lua_gettop(L);
 
     lua_getfield(L, LUA_REGISTRYINDEX, CALLBACK_TABLE);
     lua_pushlightuserdata(L, event);
@@ -204,7 +198,9 @@ FMOD_RESULT F_CALLBACK eventCallback(FMOD_STUDIO_EVENT_CALLBACK_TYPE type, FMOD_
         }
     }
 
-    criticalSectionLeave(sCriticalSection);
+    lua_settop(L, top);
+
+    criticalSectionLeave(context->callbackLock);
 
     return FMOD_OK;
 }
@@ -219,47 +215,49 @@ int callbackPrepare(lua_State *L, int index, void *owner)
         return luaL_error(L, "Attempt to set a callback with at least one upvalue (%s)", upvalue);
     }
 
-    REQUIRE_OK(affirmCriticalSection());
+    luaFMOD_Context *context = contextGet(L);
 
-    criticalSectionEnter(sCriticalSection);
+    criticalSectionEnter(context->callbackLock);
 
 #define CHECK_RESULT(r) \
     do { \
         FMOD_RESULT _r = (r); \
         if (_r != FMOD_OK) { \
-            criticalSectionLeave(sCriticalSection); \
+            criticalSectionLeave(context->callbackLock); \
             REQUIRE_OK(_r); \
         } \
     } while (0)
 
-    CHECK_RESULT(affirmCallbackState(L));
+    CHECK_RESULT(affirmCallbackState(L, context));
 
-    affirmCallbacksTable();
+    lua_State *callbackState = context->callbackState;
+
+    affirmTable(callbackState, CALLBACK_TABLE);
 
     lua_pushvalue(L, index);
 
     ChunkList chunkList = { 0 };
 
     if (lua_dump(L, chunkListWrite, &chunkList) != 0) {
-        criticalSectionLeave(sCriticalSection);
+        criticalSectionLeave(context->callbackLock);
         return luaL_error(L, "Failed to dump callback");
     }
 
-    if (chunkListLoad(sCallbackState, &chunkList, "callback") != 0) {
-        criticalSectionLeave(sCriticalSection);
+    if (chunkListLoad(callbackState, &chunkList, "callback") != 0) {
+        criticalSectionLeave(context->callbackLock);
         return lua_error(L);
     }
 
     chunkListFree(&chunkList);
 
-    lua_getfield(sCallbackState, LUA_REGISTRYINDEX, CALLBACK_TABLE);
-    lua_pushlightuserdata(sCallbackState, owner);
-    lua_pushvalue(sCallbackState, -3);
-    lua_settable(sCallbackState, -3);
+    lua_getfield(callbackState, LUA_REGISTRYINDEX, CALLBACK_TABLE);
+    lua_pushlightuserdata(callbackState, owner);
+    lua_pushvalue(callbackState, -3);
+    lua_settable(callbackState, -3);
 
-    int reference = luaL_ref(sCallbackState, LUA_REGISTRYINDEX);
+    int reference = luaL_ref(callbackState, LUA_REGISTRYINDEX);
 
-    criticalSectionLeave(sCriticalSection);
+    criticalSectionLeave(context->callbackLock);
 
     return reference;
 }
@@ -387,31 +385,25 @@ int callbacks_checkUserData(lua_State *L, int index)
 
 int callbacks_setUserData(lua_State *L, int index, void *owner)
 {
-    REQUIRE_OK(affirmCriticalSection());
+    luaFMOD_Context *context = contextGet(L);
 
-    criticalSectionEnter(sCriticalSection);
+    criticalSectionEnter(context->callbackLock);
 
-#define CHECK_RESULT(r) \
-    do { \
-        FMOD_RESULT _r = (r); \
-        if (_r != FMOD_OK) { \
-            criticalSectionLeave(sCriticalSection); \
-            REQUIRE_OK(_r); \
-        } \
-    } while (0)
+    CHECK_RESULT(affirmCallbackState(L, context));
 
-    CHECK_RESULT(affirmCallbackState(L));
+    lua_State *callbackState = context->callbackState;
 
-    affirmUserdataTable();
+    affirmTable(callbackState, USERDATA_TABLE);
 
-    lua_getfield(sCallbackState, LUA_REGISTRYINDEX, USERDATA_TABLE);
-    lua_pushlightuserdata(sCallbackState, owner);
+    lua_getfield(callbackState, LUA_REGISTRYINDEX, USERDATA_TABLE);
+    lua_pushlightuserdata(callbackState, owner);
 
-    copyUserData(L, index, sCallbackState);
+    copyUserData(L, index, callbackState);
 
-    lua_settable(sCallbackState, -3);
+    lua_settable(callbackState, -3);
+    lua_pop(callbackState, 1);
 
-    criticalSectionLeave(sCriticalSection);
+    criticalSectionLeave(context->callbackLock);
 
     return 0;
 }
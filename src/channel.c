@@ -40,7 +40,13 @@ SET(Pan, float)
 SET_MULTI(MixLevelsOutput, float, float, float, float, float, float, float, float)
 GET_MULTI(DSPClock, DSP_CLOCK, DSP_CLOCK)
 PROPERTY_MULTI(Delay, DSP_CLOCK, DSP_CLOCK, FMOD_BOOL)
+CALL_MULTI(addFadePoint, AddFadePoint, DSP_CLOCK, float)
+CALL_MULTI(setFadePointRamp, SetFadePointRamp, DSP_CLOCK, float)
+CALL_MULTI(removeFadePoints, RemoveFadePoints, DSP_CLOCK, DSP_CLOCK)
+GET_CUSTOM(getFadePoints, FADE_POINTS, GetFadePoints)
 HANDLE_LIST(DSP, FMOD_DSP)
+CALL_MULTI(addDSP, AddDSP, int, (FMOD_DSP, HANDLE))
+CALL_MULTI(removeDSP, RemoveDSP, (FMOD_DSP, HANDLE))
 PROPERTY_INDEXED(DSPIndex, (FMOD_DSP, HANDLE), int)
 PROPERTY_MULTI(3DAttributes, (FMOD_VECTOR, STRUCT), (FMOD_VECTOR, STRUCT))
 PROPERTY_MULTI(3DMinMaxDistance, float, float)
@@ -96,17 +102,13 @@ METHODS_TABLE_BEGIN
   METHODS_TABLE_ENTRY(getDSPClock)
   METHODS_TABLE_ENTRY(setDelay)
   METHODS_TABLE_ENTRY(getDelay)
-#if 0
   METHODS_TABLE_ENTRY(addFadePoint)
   METHODS_TABLE_ENTRY(setFadePointRamp)
   METHODS_TABLE_ENTRY(removeFadePoints)
   METHODS_TABLE_ENTRY(getFadePoints)
-#endif
   METHODS_TABLE_ENTRY(getDSP)
-#if 0
   METHODS_TABLE_ENTRY(addDSP)
   METHODS_TABLE_ENTRY(removeDSP)
-#endif
   METHODS_TABLE_ENTRY(getNumDSPs)
   METHODS_TABLE_ENTRY(setDSPIndex)
   METHODS_TABLE_ENTRY(getDSPIndex)
@@ -0,0 +1,243 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+#include "platform.h"
+#include "studiosystem.h"
+
+#define SELF_TYPE FMOD_STUDIO_COMMANDREPLAY
+#define FMOD_PREFIX FMOD_Studio_CommandReplay_
+
+#include "templates.h"
+
+/* Commands longer than this are reported as truncated */
+#define MAX_COMMAND_STRING 65536
+
+static int METHOD_NAME(isValid)(lua_State *L)
+{
+    GET_SELF;
+
+    FMOD_BOOL valid = FMOD_Studio_CommandReplay_IsValid(self);
+
+    lua_pushboolean(L, valid);
+
+    return 1;
+}
+
+/* FMOD can't report the length, so the buffer grows until the string fits */
+static int METHOD_NAME(getCommandString)(lua_State *L)
+{
+    GET_SELF;
+
+    int index = luaL_checkint(L, 2);
+
+    for (int size = 256; ; size *= 2) {
+        STACKBUFFER_CREATE(char, buffer, size);
+
+        FMOD_RESULT result = FMOD_Studio_CommandReplay_GetCommandString(self, index, buffer, size);
+
+        if (result == FMOD_ERR_TRUNCATED && size < MAX_COMMAND_STRING) {
+            STACKBUFFER_RELEASE(buffer);
+            continue;
+        }
+
+        RETURN_IF_ERROR(result, STACKBUFFER_RELEASE(buffer););
+
+        lua_pushstring(L, buffer);
+
+        STACKBUFFER_RELEASE(buffer);
+
+        return 1;
+    }
+}
+
+static int METHOD_NAME(setBankPath)(lua_State *L)
+{
+    GET_SELF;
+
+    const char *path = luaL_checkstring(L, 2);
+
+    RETURN_STATUS(FMOD_Studio_CommandReplay_SetBankPath(self, path));
+}
+
+static int METHOD_NAME(start)(lua_State *L)
+{
+    GET_SELF;
+
+    RETURN_STATUS(FMOD_Studio_CommandReplay_Start(self));
+}
+
+static int METHOD_NAME(stop)(lua_State *L)
+{
+    GET_SELF;
+
+    RETURN_STATUS(FMOD_Studio_CommandReplay_Stop(self));
+}
+
+GET(System, (FMOD_STUDIO_SYSTEM, HANDLE))
+GET(Length, float)
+GET(CommandCount, int)
+GET_INDEXED(CommandAtTime, float, int)
+CALL_MULTI(seekToTime, SeekToTime, float)
+CALL_MULTI(seekToCommand, SeekToCommand, int)
+PROPERTY(Paused, FMOD_BOOL)
+GET_MULTI(PlaybackState, (FMOD_STUDIO_PLAYBACK_STATE, CONSTANT))
+GET_MULTI(CurrentCommand, int, float)
+
+static int METHOD_NAME(release)(lua_State *L)
+{
+    GET_SELF;
+
+    RETURN_STATUS(FMOD_Studio_CommandReplay_Release(self));
+}
+
+/* run([csvFilename], [maxFrames])
+   Starts the replay and drives Studio.System:update in a tight loop until it
+   finishes, which replays as fast as possible when the replay was loaded with
+   COMMANDREPLAY.FAST_FORWARD on a non-realtime output. Each frame is a full
+   update, so automation, awaits and the other per-update work run as they would
+   in a game. If csvFilename is given, one row per update is written with the
+   wall-clock update time and the Studio and core CPU usage, for comparing
+   performance between runs.
+   Returns the number of frames, the total update time and the longest update
+   time, in milliseconds. An error raised by a callback during an update stops
+   the replay and is rethrown.
+*/
+static int METHOD_NAME(run)(lua_State *L)
+{
+    GET_SELF;
+
+    const char *filename = luaL_optstring(L, 2, NULL);
+    int maxFrames = luaL_optint(L, 3, 0);
+
+    FMOD_STUDIO_SYSTEM *system = NULL;
+    RETURN_IF_ERROR(FMOD_Studio_CommandReplay_GetSystem(self, &system));
+
+    FILE *file = NULL;
+
+    if (filename) {
+        file = fopen(filename, "w");
+
+        if (!file) {
+            return luaL_error(L, "cannot open %s: %s", filename, strerror(errno));
+        }
+
+        fputs("frame,replayTime,command,updateMs,studioUpdate,dsp,stream,geometry,update,"
+            "convolution1,convolution2\n", file);
+    }
+
+    FMOD_RESULT result = FMOD_Studio_CommandReplay_Start(self);
+
+    int frames = 0;
+    double totalTime = 0;
+    double maxTime = 0;
+
+    while (result == FMOD_OK && (maxFrames <= 0 || frames < maxFrames)) {
+        double start = platformGetTime();
+        int status = studioSystemProtectedUpdate(L, system, &result);
+        double elapsed = (platformGetTime() - start) * 1000;
+
+        if (status != 0) {
+            FMOD_Studio_CommandReplay_Stop(self);
+
+            if (file) {
+                fclose(file);
+            }
+
+            return lua_error(L);
+        }
+
+        if (result != FMOD_OK) {
+            break;
+        }
+
+        frames++;
+        totalTime += elapsed;
+
+        if (elapsed > maxTime) {
+            maxTime = elapsed;
+        }
+
+        if (file) {
+            int command = 0;
+            float time = 0;
+            FMOD_Studio_CommandReplay_GetCurrentCommand(self, &command, &time);
+
+            FMOD_STUDIO_CPU_USAGE usage = { 0 };
+            FMOD_CPU_USAGE usageCore = { 0 };
+            FMOD_Studio_System_GetCPUUsage(system, &usage, &usageCore);
+
+            fprintf(file, "%d,%.4f,%d,%.4f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", frames, time, command,
+                elapsed, usage.update, usageCore.dsp, usageCore.stream, usageCore.geometry,
+                usageCore.update, usageCore.convolution1, usageCore.convolution2);
+        }
+
+        FMOD_STUDIO_PLAYBACK_STATE state = FMOD_STUDIO_PLAYBACK_STOPPED;
+        result = FMOD_Studio_CommandReplay_GetPlaybackState(self, &state);
+
+        if (state == FMOD_STUDIO_PLAYBACK_STOPPED) {
+            break;
+        }
+    }
+
+    if (file) {
+        fclose(file);
+    }
+
+    RETURN_IF_ERROR(result);
+
+    lua_pushinteger(L, frames);
+    lua_pushnumber(L, totalTime);
+    lua_pushnumber(L, maxTime);
+
+    return 3;
+}
+
+METHODS_TABLE_BEGIN
+    METHODS_TABLE_ENTRY(isValid)
+    METHODS_TABLE_ENTRY(getSystem)
+    METHODS_TABLE_ENTRY(getLength)
+    METHODS_TABLE_ENTRY(getCommandCount)
+    METHODS_TABLE_ENTRY(getCommandString)
+    METHODS_TABLE_ENTRY(getCommandAtTime)
+    METHODS_TABLE_ENTRY(setBankPath)
+    METHODS_TABLE_ENTRY(start)
+    METHODS_TABLE_ENTRY(stop)
+    METHODS_TABLE_ENTRY(seekToTime)
+    METHODS_TABLE_ENTRY(seekToCommand)
+    METHODS_TABLE_ENTRY(getPaused)
+    METHODS_TABLE_ENTRY(setPaused)
+    METHODS_TABLE_ENTRY(getPlaybackState)
+    METHODS_TABLE_ENTRY(getCurrentCommand)
+    METHODS_TABLE_ENTRY(release)
+    METHODS_TABLE_ENTRY(run)
+#if 0
+    METHODS_TABLE_ENTRY(getCommandInfo)
+    METHODS_TABLE_ENTRY(setFrameCallback)
+    METHODS_TABLE_ENTRY(setLoadBankCallback)
+    METHODS_TABLE_ENTRY(setCreateInstanceCallback)
+    METHODS_TABLE_ENTRY(getUserData)
+    METHODS_TABLE_ENTRY(setUserData)
+#endif
+METHODS_TABLE_END
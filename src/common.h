@@ -46,6 +46,26 @@ DEALINGS IN THE SOFTWARE.
         lua_setmetatable(L, -2); \
     } while(0)
 
+/* Objects stored in full userdata with an int released member. NEW_SELF pushes a
+   zeroed one. __gc starts with GET_SELF_FOR_GC, which returns if the object was
+   already released, and release calls __gc; files redefine GET_SELF as
+   GET_RELEASABLE_SELF so that other methods raise an error once it is released.
+*/
+#define NEW_SELF(L) ((SELF_TYPE*)newReleasable(L, sizeof(SELF_TYPE), STRINGIZE(SELF_TYPE)))
+
+#define GET_SELF_FOR_GC \
+    SELF_TYPE *self = (SELF_TYPE*)luaL_checkudata(L, 1, STRINGIZE(SELF_TYPE)); \
+    if (self->released) return 0
+
+#define GET_RELEASABLE_SELF(name) \
+    SELF_TYPE *self = (SELF_TYPE*)luaL_checkudata(L, 1, STRINGIZE(SELF_TYPE)); \
+    if (self->released) return luaL_error(L, name " has been released")
+
+void *newReleasable(lua_State *L, size_t size, const char *type);
+
+/* Returns nonzero if the value at index has the metatable registered as name */
+int hasMetatable(lua_State *L, int index, const char *name);
+
 #define IS_STRUCT(L, index, type) STRUCT_is(L, # type, index)
 #define CHECK_STRUCT(L, index, type) ((type*)STRUCT_todata(L, # type, index, STRUCT_REQUIRED))
 #define OPTIONAL_STRUCT(L, index, type) ((type*)STRUCT_todata(L, # type, index, STRUCT_OPTIONAL))
@@ -69,20 +89,19 @@ DEALINGS IN THE SOFTWARE.
     do { \
         FMOD_RESULT _result = (result); \
         if (_result != FMOD_OK) { \
-            return luaL_error(L, "FMOD error %d: %s", _result, FMOD_ErrorString(_result)); \
+            return raiseError(L, _result); \
         } \
     } while(0)
 
-/* If an FMOD error is encountered, return nil and the error code */
+/* If an FMOD error is encountered, return nil, the error message and the error code
+   (or just nil and the code in fast errors mode)
+*/
 #define RETURN_IF_ERROR(result, ...) \
     do { \
         FMOD_RESULT _result = (result); \
         if (_result != FMOD_OK) { \
             __VA_ARGS__ \
-            lua_pushnil(L); \
-            lua_pushfstring(L, "FMOD error %d: %s", _result, FMOD_ErrorString(_result)); \
-            lua_pushinteger(L, _result); \
-            return 3; \
+            return pushError(L, _result); \
         } \
     } while(0)
 
@@ -128,11 +147,35 @@ typedef struct {
 #define STRUCT_REQUIRED 1
 #define STRUCT_OPTIONAL 0
 
+/* Result codes below this have an interned message and their own error counter */
+#define ERROR_RESULT_SLOTS 128
+
+/* FMOD_OK is never counted, so its slot counts the codes without their own */
+#define ERROR_OTHER_SLOT 0
+
+int pushError(lua_State *L, FMOD_RESULT result);
+int raiseError(lua_State *L, FMOD_RESULT result);
+
+/* For results kept to be returned later: counted once when they are stored, then
+   pushed like pushError as often as they are read */
+void countStoredError(lua_State *L, FMOD_RESULT result);
+int pushStoredError(lua_State *L, FMOD_RESULT result);
+
 void *stackBufferSelect(lua_State *L, StackBufferInfo *info);
 void stackBufferRelease(lua_State *L, void *pointer, StackBufferInfo *info);
+void stackBufferReset(lua_State *L);
 
 typedef const char * luaFMOD_Buffer;
 
+/* Gets an object's ID and path; see pushDetailedList */
+typedef FMOD_RESULT (*DetailedListGetter)(void *handle, FMOD_GUID *id, char *path, int size, int *retrieved);
+
+/* Pushes parallel arrays of handles, paths and IDs, and returns 3. Paths are fetched
+   into one scratch buffer, which only grows when FMOD reports truncation.
+*/
+int pushDetailedList(lua_State *L, const char *handleType, void **handles, int count,
+    DetailedListGetter getter);
+
 int STRUCT_new(lua_State *L, const char *metatable, size_t size);
 int STRUCT_newref(lua_State *L, const char *metatable, int parentIndex, const void *data);
 int STRUCT_is(lua_State *L, const char *metatable, int index);
@@ -18,7 +18,9 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 DEALINGS IN THE SOFTWARE.
 */
 
+#include "automation.h"
 #include "common.h"
+#include "instancequery.h"
 
 int getOptionalConstant(lua_State *L, int index, const char *metatable, int defaultValue)
 {
@@ -396,6 +398,32 @@ ENUM_TABLE_BEGIN(FMOD_DEBUG_MODE)
     TABLE_ENTRY(CALLBACK)
 TABLE_END
 
+#undef TABLE_VALUE_PREFIX
+#define TABLE_VALUE_PREFIX FMOD_OUTPUTTYPE_
+
+ENUM_TABLE_BEGIN(FMOD_OUTPUTTYPE)
+    TABLE_ENTRY(AUTODETECT)
+    TABLE_ENTRY(UNKNOWN)
+    TABLE_ENTRY(NOSOUND)
+    TABLE_ENTRY(WAVWRITER)
+    TABLE_ENTRY(NOSOUND_NRT)
+    TABLE_ENTRY(WAVWRITER_NRT)
+    TABLE_ENTRY(WASAPI)
+    TABLE_ENTRY(ASIO)
+    TABLE_ENTRY(PULSEAUDIO)
+    TABLE_ENTRY(ALSA)
+    TABLE_ENTRY(COREAUDIO)
+    TABLE_ENTRY(AUDIOTRACK)
+    TABLE_ENTRY(OPENSL)
+    TABLE_ENTRY(AUDIOOUT)
+    TABLE_ENTRY(AUDIO3D)
+    TABLE_ENTRY(WEBAUDIO)
+    TABLE_ENTRY(NNAUDIO)
+    TABLE_ENTRY(WINSONIC)
+    TABLE_ENTRY(AAUDIO)
+    TABLE_ENTRY(AUDIOWORKLET)
+TABLE_END
+
 #undef TABLE_VALUE_PREFIX
 #define TABLE_VALUE_PREFIX FMOD_SPEAKERMODE_
 
@@ -467,6 +495,63 @@ ENUM_TABLE_BEGIN(FMOD_SOUND_FORMAT)
     TABLE_ENTRY(BITSTREAM)
 TABLE_END
 
+#undef TABLE_VALUE_PREFIX
+#define TABLE_VALUE_PREFIX FMOD_OPENSTATE_
+
+ENUM_TABLE_BEGIN(FMOD_OPENSTATE)
+    TABLE_ENTRY(READY)
+    TABLE_ENTRY(LOADING)
+    TABLE_ENTRY(ERROR)
+    TABLE_ENTRY(CONNECTING)
+    TABLE_ENTRY(BUFFERING)
+    TABLE_ENTRY(SEEKING)
+    TABLE_ENTRY(PLAYING)
+    TABLE_ENTRY(SETPOSITION)
+TABLE_END
+
+#undef TABLE_VALUE_PREFIX
+#define TABLE_VALUE_PREFIX FMOD_DSP_TYPE_
+
+ENUM_TABLE_BEGIN(FMOD_DSP_TYPE)
+    TABLE_ENTRY(UNKNOWN)
+    TABLE_ENTRY(MIXER)
+    TABLE_ENTRY(OSCILLATOR)
+    TABLE_ENTRY(LOWPASS)
+    TABLE_ENTRY(ITLOWPASS)
+    TABLE_ENTRY(HIGHPASS)
+    TABLE_ENTRY(ECHO)
+    TABLE_ENTRY(FADER)
+    TABLE_ENTRY(FLANGE)
+    TABLE_ENTRY(DISTORTION)
+    TABLE_ENTRY(NORMALIZE)
+    TABLE_ENTRY(LIMITER)
+    TABLE_ENTRY(PARAMEQ)
+    TABLE_ENTRY(PITCHSHIFT)
+    TABLE_ENTRY(CHORUS)
+    TABLE_ENTRY(VSTPLUGIN)
+    TABLE_ENTRY(WINAMPPLUGIN)
+    TABLE_ENTRY(ITECHO)
+    TABLE_ENTRY(COMPRESSOR)
+    TABLE_ENTRY(SFXREVERB)
+    TABLE_ENTRY(LOWPASS_SIMPLE)
+    TABLE_ENTRY(DELAY)
+    TABLE_ENTRY(TREMOLO)
+    TABLE_ENTRY(LADSPAPLUGIN)
+    TABLE_ENTRY(SEND)
+    TABLE_ENTRY(RETURN)
+    TABLE_ENTRY(HIGHPASS_SIMPLE)
+    TABLE_ENTRY(PAN)
+    TABLE_ENTRY(THREE_EQ)
+    TABLE_ENTRY(FFT)
+    TABLE_ENTRY(LOUDNESS_METER)
+    TABLE_ENTRY(ENVELOPEFOLLOWER)
+    TABLE_ENTRY(CONVOLUTIONREVERB)
+    TABLE_ENTRY(CHANNELMIX)
+    TABLE_ENTRY(TRANSCEIVER)
+    TABLE_ENTRY(OBJECTPAN)
+    TABLE_ENTRY(MULTIBAND_EQ)
+TABLE_END
+
 #undef TABLE_VALUE_PREFIX
 #define TABLE_VALUE_PREFIX FMOD_STUDIO_INIT_
 
@@ -536,6 +621,16 @@ FLAGS_TABLE_BEGIN(FMOD_STUDIO_COMMANDCAPTURE_FLAGS)
     TABLE_ENTRY(SKIP_INITIAL_STATE)
 TABLE_END
 
+#undef TABLE_VALUE_PREFIX
+#define TABLE_VALUE_PREFIX FMOD_STUDIO_COMMANDREPLAY_
+
+FLAGS_TABLE_BEGIN(FMOD_STUDIO_COMMANDREPLAY_FLAGS)
+    TABLE_ENTRY(NORMAL)
+    TABLE_ENTRY(SKIP_CLEANUP)
+    TABLE_ENTRY(FAST_FORWARD)
+    TABLE_ENTRY(SKIP_BANK_LOAD)
+TABLE_END
+
 #undef TABLE_VALUE_PREFIX
 #define TABLE_VALUE_PREFIX FMOD_STUDIO_LOADING_STATE_
 
@@ -612,6 +707,27 @@ ENUM_TABLE_BEGIN(FMOD_STUDIO_STOP_MODE)
     TABLE_ENTRY(IMMEDIATE)
 TABLE_END
 
+#undef TABLE_VALUE_PREFIX
+#define TABLE_VALUE_PREFIX luaFMOD_QUERY_
+
+FLAGS_TABLE_BEGIN(luaFMOD_QUERY_FIELDS)
+    TABLE_ENTRY(PLAYBACK_STATE)
+    TABLE_ENTRY(TIMELINE_POSITION)
+    TABLE_ENTRY(VIRTUAL)
+    TABLE_ENTRY(VOLUME)
+    TABLE_ENTRY(ALL)
+TABLE_END
+
+#undef TABLE_VALUE_PREFIX
+#define TABLE_VALUE_PREFIX luaFMOD_AUTOMATION_CURVE_
+
+ENUM_TABLE_BEGIN(luaFMOD_AUTOMATION_CURVE)
+    TABLE_ENTRY(LINEAR)
+    TABLE_ENTRY(EXPONENTIAL)
+    TABLE_ENTRY(SINE)
+    TABLE_ENTRY(TABLE)
+TABLE_END
+
 void createConstantTables(lua_State *L)
 {
     /* The FMOD table should be on top of the stack, so define FMOD constants first */
@@ -620,10 +736,13 @@ void createConstantTables(lua_State *L)
     TABLE_CREATE(FMOD_TIMEUNIT, "TIMEUNIT");
     TABLE_CREATE(FMOD_MODE, "MODE");
     TABLE_CREATE(FMOD_DEBUG_MODE, "DEBUG_MODE");
+    TABLE_CREATE(FMOD_OUTPUTTYPE, "OUTPUTTYPE");
     TABLE_CREATE(FMOD_SPEAKERMODE, "SPEAKERMODE");
     TABLE_CREATE(FMOD_CHANNELORDER, "CHANNELORDER");
     TABLE_CREATE(FMOD_SOUND_TYPE, "SOUND_TYPE");
     TABLE_CREATE(FMOD_SOUND_FORMAT, "SOUND_FORMAT");
+    TABLE_CREATE(FMOD_OPENSTATE, "OPENSTATE");
+    TABLE_CREATE(FMOD_DSP_TYPE, "DSP_TYPE");
 
     /* Get the FMOD.Studio table */
     lua_getfield(L, -1, "Studio");
@@ -633,6 +752,7 @@ void createConstantTables(lua_State *L)
     TABLE_CREATE(FMOD_STUDIO_PARAMETER_FLAGS, "PARAMETER_FLAGS");
     TABLE_CREATE(FMOD_STUDIO_LOAD_BANK_FLAGS, "LOAD_BANK");
     TABLE_CREATE(FMOD_STUDIO_COMMANDCAPTURE_FLAGS, "COMMANDCAPTURE");
+    TABLE_CREATE(FMOD_STUDIO_COMMANDREPLAY_FLAGS, "COMMANDREPLAY");
     TABLE_CREATE(FMOD_STUDIO_LOADING_STATE, "LOADING_STATE");
     TABLE_CREATE(FMOD_STUDIO_LOAD_MEMORY_MODE, "LOAD_MEMORY_MODE");
     TABLE_CREATE(FMOD_STUDIO_PARAMETER_TYPE, "PARAMETER_TYPE");
@@ -640,6 +760,8 @@ void createConstantTables(lua_State *L)
     TABLE_CREATE(FMOD_STUDIO_EVENT_PROPERTY, "EVENT_PROPERTY");
     TABLE_CREATE(FMOD_STUDIO_PLAYBACK_STATE, "PLAYBACK_STATE");
     TABLE_CREATE(FMOD_STUDIO_STOP_MODE, "STOP");
+    TABLE_CREATE(luaFMOD_QUERY_FIELDS, "QUERY");
+    TABLE_CREATE(luaFMOD_AUTOMATION_CURVE, "AUTOMATION_CURVE");
 
     /* Tidy up the FMOD.Studio table */
     lua_pop(L, 1);
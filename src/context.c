@@ -0,0 +1,113 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+
+#include "await.h"
+#include "context.h"
+#include "nonblocking.h"
+
+static int sContextKey;
+
+/* Frees what the closing state owned, leaving only what FMOD threads can still
+   reach: the lock and the nonblocking queue. Sequencers, automations and
+   programmer sound resolvers are userdata whose __gc frees them as the state
+   closes.
+*/
+static int anchorCollect(lua_State *L)
+{
+    luaFMOD_Context *context = *(luaFMOD_Context**)lua_touserdata(L, 1);
+
+    criticalSectionEnter(context->callbackLock);
+
+    if (context->callbackState) {
+        lua_close(context->callbackState);
+        context->callbackState = NULL;
+    }
+
+    criticalSectionLeave(context->callbackLock);
+
+    if (context->awaits) {
+        awaitListFree(context->awaits);
+        context->awaits = NULL;
+    }
+
+    if (context->nonblocking) {
+        nonblockingClose(context->nonblocking);
+    }
+
+    context->programmerSoundResolvers = NULL;
+    context->automations = NULL;
+    context->sequencers = NULL;
+
+    return 0;
+}
+
+luaFMOD_Context *contextGet(lua_State *L)
+{
+    lua_pushlightuserdata(L, &sContextKey);
+    lua_rawget(L, LUA_REGISTRYINDEX);
+
+    luaFMOD_Context **anchor = lua_touserdata(L, -1);
+    int isAnchor = lua_type(L, -1) == LUA_TUSERDATA;
+
+    lua_pop(L, 1);
+
+    if (anchor) {
+        return isAnchor ? *anchor : (luaFMOD_Context*)anchor;
+    }
+
+    luaFMOD_Context *context = calloc(1, sizeof(*context));
+
+    if (!context) {
+        luaL_error(L, "out of memory");
+        return NULL;
+    }
+
+    context->callbackLock = criticalSectionCreate();
+
+    if (!context->callbackLock) {
+        free(context);
+        luaL_error(L, "out of memory");
+        return NULL;
+    }
+
+    /* The anchor's __gc runs when the state closes */
+    lua_pushlightuserdata(L, &sContextKey);
+
+    anchor = lua_newuserdata(L, sizeof(*anchor));
+    *anchor = context;
+
+    lua_createtable(L, 0, 1);
+    lua_pushcfunction(L, anchorCollect);
+    lua_setfield(L, -2, "__gc");
+    lua_setmetatable(L, -2);
+
+    lua_rawset(L, LUA_REGISTRYINDEX);
+
+    return context;
+}
+
+void contextShare(lua_State *L, luaFMOD_Context *context)
+{
+    lua_pushlightuserdata(L, &sContextKey);
+    lua_pushlightuserdata(L, context);
+    lua_rawset(L, LUA_REGISTRYINDEX);
+}
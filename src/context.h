@@ -0,0 +1,40 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include <lauxlib.h>
+
+#include "common.h"
+#include "platform.h"
+
+typedef struct AwaitList AwaitList;
+typedef struct NonblockingQueue NonblockingQueue;
+
+/* State owned by one Lua universe (a main lua_State and its coroutines), so that
+   several independent states can use the binding from different threads.
+   Contexts are referenced from FMOD callbacks, so they are never freed; when the
+   owning state closes, the callback state is closed, callbacks are ignored and
+   everything no FMOD thread can reach is freed.
+*/
+typedef struct luaFMOD_Context {
+    /* Guards callbackState, which is used from FMOD threads */
+    LUAFMOD_CRITICAL_SECTION *callbackLock;
+    lua_State *callbackState;
+
+    /* Errors returned to Lua, counted by FMOD_RESULT; ERROR_OTHER_SLOT counts the rest */
+    volatile long errorCounts[ERROR_RESULT_SLOTS];
+    int fastErrors;
+
+    AwaitList *awaits;
+    struct luaFMOD_Automation *automations;
+    NonblockingQueue *nonblocking;
+    struct luaFMOD_ProgrammerSoundResolver *programmerSoundResolvers;
+    struct luaFMOD_Sequencer *sequencers;
+} luaFMOD_Context;
+
+/* Returns the context for L, creating it on first use */
+luaFMOD_Context *contextGet(lua_State *L);
+
+/* Makes L (a state created for callbacks) share the context of its owner */
+void contextShare(lua_State *L, luaFMOD_Context *context);
+
+#endif /* CONTEXT_H */
@@ -18,7 +18,13 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 DEALINGS IN THE SOFTWARE.
 */
 
+#include <string.h>
+
 #include "common.h"
+#include "dspeffects.h"
+#include "nonblocking.h"
+#include "platform.h"
+#include "sequencer.h"
 
 #define SELF_TYPE FMOD_SYSTEM
 
@@ -49,9 +55,10 @@ static int METHOD_NAME(init)(lua_State *L)
     int maxchannels = luaL_checkint(L, 2);
     int flags = CHECK_CONSTANT(L, 3, FMOD_INITFLAGS);
 
-    /* TODO extradriverdata? */
+    /* For the WAVWRITER outputs, extradriverdata is the output filename */
+    void *extradriverdata = (void*)luaL_optstring(L, 4, NULL);
 
-    REQUIRE_OK(FMOD_System_Init(self, maxchannels, flags, NULL));
+    REQUIRE_OK(FMOD_System_Init(self, maxchannels, flags, extradriverdata));
 
     return 0;
 }
@@ -65,11 +72,40 @@ static int METHOD_NAME(close)(lua_State *L)
     return 0;
 }
 
+static int METHOD_NAME(setOutput)(lua_State *L)
+{
+    GET_SELF;
+
+    int output = CHECK_CONSTANT(L, 2, FMOD_OUTPUTTYPE);
+
+    RETURN_STATUS(FMOD_System_SetOutput(self, output));
+}
+
+static int METHOD_NAME(getOutput)(lua_State *L)
+{
+    GET_SELF;
+
+    FMOD_OUTPUTTYPE output;
+    RETURN_IF_ERROR(FMOD_System_GetOutput(self, &output));
+
+    PUSH_CONSTANT(L, FMOD_OUTPUTTYPE, output);
+
+    return 1;
+}
+
 static int METHOD_NAME(update)(lua_State *L)
 {
     GET_SELF;
 
     REQUIRE_OK(FMOD_System_Update(self));
+    stackBufferReset(L);
+
+    int errors = nonblockingPumpResults(L);
+    sequencerUpdateAll(L);
+
+    if (errors > 0) {
+        return lua_error(L);
+    }
 
     return 0;
 }
@@ -106,9 +142,41 @@ static int METHOD_NAME(createSound)(lua_State *L)
         exinfo->cbsize = sizeof(*exinfo);
     }
 
+    int nonblocking = (mode & FMOD_NONBLOCKING) != 0;
+
+    if (!nonblocking && !lua_isnoneornil(L, 5)) {
+        return luaL_argerror(L, 5, "completion callback requires FMOD_NONBLOCKING");
+    }
+
+    FMOD_CREATESOUNDEXINFO localExinfo;
+
+    if (nonblocking) {
+        if (!lua_isnoneornil(L, 5)) {
+            luaL_checktype(L, 5, LUA_TFUNCTION);
+        }
+
+        /* A copy, so the caller's struct keeps its own callback and userdata */
+        if (exinfo) {
+            localExinfo = *exinfo;
+        } else {
+            memset(&localExinfo, 0, sizeof(localExinfo));
+            localExinfo.cbsize = sizeof(localExinfo);
+        }
+
+        exinfo = &localExinfo;
+
+        RETURN_IF_ERROR(nonblockingPrepare(L, exinfo));
+    }
+
+    double startTime = platformGetTime();
+
     FMOD_SOUND *sound = NULL;
     RETURN_IF_ERROR(FMOD_System_CreateSound(self, name_or_data, mode, exinfo, &sound));
 
+    if (nonblocking) {
+        nonblockingRegister(L, sound, startTime, 5);
+    }
+
     PUSH_HANDLE(L, FMOD_SOUND, sound);
 
     return 1;
@@ -157,18 +225,402 @@ static int METHOD_NAME(getMasterChannelGroup)(lua_State *L)
     return 1;
 }
 
+/* Sets parameters on dsp from a table of name = value pairs. Names are matched
+   against the DSP's parameter descriptions. Doesn't raise errors.
+*/
+static FMOD_RESULT setParametersByName(lua_State *L, FMOD_DSP *dsp, int tableIndex)
+{
+    int count = 0;
+    FMOD_RESULT result = FMOD_DSP_GetNumParameters(dsp, &count);
+
+    lua_pushnil(L);
+
+    while (result == FMOD_OK && lua_next(L, tableIndex) != 0) {
+        const char *name = lua_type(L, -2) == LUA_TSTRING ? lua_tostring(L, -2) : NULL;
+
+        result = FMOD_ERR_INVALID_PARAM;
+
+        for (int i = 0; name && i < count; ++i) {
+            FMOD_DSP_PARAMETER_DESC *desc = NULL;
+
+            if (FMOD_DSP_GetParameterInfo(dsp, i, &desc) != FMOD_OK || strcmp(desc->name, name) != 0) {
+                continue;
+            }
+
+            if (desc->type == FMOD_DSP_PARAMETER_TYPE_FLOAT && lua_type(L, -1) == LUA_TNUMBER) {
+                result = FMOD_DSP_SetParameterFloat(dsp, i, (float)lua_tonumber(L, -1));
+            } else if (desc->type == FMOD_DSP_PARAMETER_TYPE_INT && lua_type(L, -1) == LUA_TNUMBER) {
+                result = FMOD_DSP_SetParameterInt(dsp, i, (int)lua_tointeger(L, -1));
+            } else if (desc->type == FMOD_DSP_PARAMETER_TYPE_BOOL && lua_type(L, -1) == LUA_TBOOLEAN) {
+                result = FMOD_DSP_SetParameterBool(dsp, i, lua_toboolean(L, -1));
+            }
+
+            break;
+        }
+
+        lua_pop(L, 1);
+    }
+
+    if (result != FMOD_OK) {
+        /* Stopped early; pop the key */
+        lua_pop(L, 1);
+    }
+
+    return result;
+}
+
+/* createDSP(name, [parameters])
+   Creates one of the built-in effects ("gain", "biquad" or "limiter"). parameters is
+   an optional table of parameter name = value pairs, e.g. { Frequency = 800 }.
+*/
+static int METHOD_NAME(createDSP)(lua_State *L)
+{
+    GET_SELF;
+
+    const char *name = luaL_checkstring(L, 2);
+
+    if (!lua_isnoneornil(L, 3)) {
+        luaL_checktype(L, 3, LUA_TTABLE);
+    }
+
+    const FMOD_DSP_DESCRIPTION *description = dspEffectFind(name);
+
+    if (!description) {
+        return luaL_argerror(L, 2, lua_pushfstring(L, "unknown effect '%s'", name));
+    }
+
+    FMOD_DSP *dsp = NULL;
+    RETURN_IF_ERROR(FMOD_System_CreateDSP(self, description, &dsp));
+
+    if (!lua_isnoneornil(L, 3)) {
+        RETURN_IF_ERROR(setParametersByName(L, dsp, 3), FMOD_DSP_Release(dsp););
+    }
+
+    PUSH_HANDLE(L, FMOD_DSP, dsp);
+
+    return 1;
+}
+
+static int METHOD_NAME(createDSPByType)(lua_State *L)
+{
+    GET_SELF;
+
+    FMOD_DSP_TYPE type = CHECK_CONSTANT(L, 2, FMOD_DSP_TYPE);
+
+    FMOD_DSP *dsp = NULL;
+    RETURN_IF_ERROR(FMOD_System_CreateDSPByType(self, type, &dsp));
+
+    PUSH_HANDLE(L, FMOD_DSP, dsp);
+
+    return 1;
+}
+
+/* createSequencer([lookahead]) */
+static int METHOD_NAME(createSequencer)(lua_State *L)
+{
+    GET_SELF;
+
+    int lookahead = luaL_optinteger(L, 2, 2);
+
+    return sequencerCreate(L, self, lookahead);
+}
+
+typedef struct FadeTarget {
+    void *handle;
+    int isGroup;
+    unsigned long long parentclock;
+} FadeTarget;
+
+/* Returns 1 for a ChannelGroup, 0 for a Channel and -1 for anything else. */
+static int channelControlKind(lua_State *L, int index)
+{
+    int kind = -1;
+
+    if (lua_type(L, index) == LUA_TUSERDATA && lua_getmetatable(L, index)) {
+        luaL_getmetatable(L, "FMOD_CHANNEL");
+        luaL_getmetatable(L, "FMOD_CHANNELGROUP");
+
+        if (lua_rawequal(L, -3, -2)) {
+            kind = 0;
+        } else if (lua_rawequal(L, -3, -1)) {
+            kind = 1;
+        }
+
+        lua_pop(L, 3);
+    }
+
+    return kind;
+}
+
+/* Checks that the target is still valid and stores its base clock, so that every target
+   can be checked before any fade points are changed.
+*/
+static FMOD_RESULT resolveFadeTarget(FadeTarget *target, int relative)
+{
+    unsigned long long dspclock = 0;
+    FMOD_RESULT result = target->isGroup
+        ? FMOD_ChannelGroup_GetDSPClock(target->handle, &dspclock, &target->parentclock)
+        : FMOD_Channel_GetDSPClock(target->handle, &dspclock, &target->parentclock);
+
+    if (!relative) {
+        target->parentclock = 0;
+    }
+
+    return result;
+}
+
+static FMOD_RESULT addFadeCurve(const FadeTarget *target, int count, const unsigned long long *clocks,
+    const float *volumes)
+{
+    unsigned long long parentclock = target->parentclock;
+
+    if (target->isGroup) {
+        FMOD_CHANNELGROUP *group = target->handle;
+
+        FMOD_RESULT result = FMOD_ChannelGroup_RemoveFadePoints(group,
+            parentclock + clocks[0], parentclock + clocks[count - 1]);
+
+        for (int i = 0; i < count && result == FMOD_OK; ++i) {
+            result = FMOD_ChannelGroup_AddFadePoint(group, parentclock + clocks[i], volumes[i]);
+        }
+
+        return result;
+    } else {
+        FMOD_CHANNEL *channel = target->handle;
+
+        FMOD_RESULT result = FMOD_Channel_RemoveFadePoints(channel,
+            parentclock + clocks[0], parentclock + clocks[count - 1]);
+
+        for (int i = 0; i < count && result == FMOD_OK; ++i) {
+            result = FMOD_Channel_AddFadePoint(channel, parentclock + clocks[i], volumes[i]);
+        }
+
+        return result;
+    }
+}
+
+/* Applies one fade curve to an array of Channels and ChannelGroups. points is an array
+   of { dspclock, volume } pairs, sorted by dspclock; if relative is true, each dspclock
+   is an offset from the target's parent DSP clock. Existing fade points within the
+   curve's range are replaced. The mixer is locked for the duration, so every target
+   picks up the curve in the same mix block.
+*/
+static int METHOD_NAME(addFadePoints)(lua_State *L)
+{
+    GET_SELF;
+
+    luaL_checktype(L, 2, LUA_TTABLE);
+    luaL_checktype(L, 3, LUA_TTABLE);
+    int relative = lua_toboolean(L, 4);
+
+    int targetCount = (int)lua_objlen(L, 2);
+    int pointCount = (int)lua_objlen(L, 3);
+
+    if (pointCount == 0) {
+        return luaL_argerror(L, 3, "at least one fade point is required");
+    }
+
+    /* Validate everything first, so that no errors are raised while buffers are live */
+    for (int i = 1; i <= targetCount; ++i) {
+        lua_rawgeti(L, 2, i);
+
+        if (channelControlKind(L, -1) < 0) {
+            return luaL_argerror(L, 2, lua_pushfstring(L, "element %d is not a Channel or ChannelGroup", i));
+        }
+
+        lua_pop(L, 1);
+    }
+
+    double previousClock = 0;
+
+    for (int i = 1; i <= pointCount; ++i) {
+        lua_rawgeti(L, 3, i);
+
+        if (!lua_istable(L, -1)) {
+            return luaL_argerror(L, 3, lua_pushfstring(L, "element %d is not a { dspclock, volume } pair", i));
+        }
+
+        lua_rawgeti(L, -1, 1);
+        lua_rawgeti(L, -2, 2);
+
+        if (!lua_isnumber(L, -2) || !lua_isnumber(L, -1) || lua_tonumber(L, -2) < 0) {
+            return luaL_argerror(L, 3, lua_pushfstring(L, "element %d is not a { dspclock, volume } pair", i));
+        }
+
+        if (i > 1 && lua_tonumber(L, -2) < previousClock) {
+            return luaL_argerror(L, 3, lua_pushfstring(L, "element %d is not sorted by dspclock", i));
+        }
+
+        previousClock = lua_tonumber(L, -2);
+        lua_pop(L, 3);
+    }
+
+    STACKBUFFER_CREATE(FadeTarget, targets, targetCount);
+    STACKBUFFER_CREATE(unsigned long long, clocks, pointCount);
+    STACKBUFFER_CREATE(float, volumes, pointCount);
+
+    for (int i = 0; i < targetCount; ++i) {
+        lua_rawgeti(L, 2, i + 1);
+        targets[i].isGroup = channelControlKind(L, -1);
+        targets[i].handle = *(void **)lua_touserdata(L, -1);
+        lua_pop(L, 1);
+    }
+
+    for (int i = 0; i < pointCount; ++i) {
+        lua_rawgeti(L, 3, i + 1);
+        lua_rawgeti(L, -1, 1);
+        lua_rawgeti(L, -2, 2);
+        clocks[i] = (unsigned long long)lua_tonumber(L, -2);
+        volumes[i] = (float)lua_tonumber(L, -1);
+        lua_pop(L, 3);
+    }
+
+    FMOD_RESULT result = FMOD_System_LockDSP(self);
+
+    if (result == FMOD_OK) {
+        /* Nothing is changed unless every target is valid */
+        for (int i = 0; i < targetCount && result == FMOD_OK; ++i) {
+            result = resolveFadeTarget(&targets[i], relative);
+        }
+
+        for (int i = 0; i < targetCount && result == FMOD_OK; ++i) {
+            result = addFadeCurve(&targets[i], pointCount, clocks, volumes);
+        }
+
+        FMOD_System_UnlockDSP(self);
+    }
+
+    STACKBUFFER_RELEASE(volumes);
+    STACKBUFFER_RELEASE(clocks);
+    STACKBUFFER_RELEASE(targets);
+
+    RETURN_STATUS(result);
+}
+
+static int METHOD_NAME(createGeometry)(lua_State *L)
+{
+    GET_SELF;
+
+    int maxPolygons = luaL_checkinteger(L, 2);
+    int maxVertices = luaL_checkinteger(L, 3);
+
+    FMOD_GEOMETRY *geometry = NULL;
+    RETURN_IF_ERROR(FMOD_System_CreateGeometry(self, maxPolygons, maxVertices, &geometry));
+
+    PUSH_HANDLE(L, FMOD_GEOMETRY, geometry);
+
+    return 1;
+}
+
+static int METHOD_NAME(setGeometrySettings)(lua_State *L)
+{
+    GET_SELF;
+
+    float maxWorldSize = (float)luaL_checknumber(L, 2);
+
+    RETURN_STATUS(FMOD_System_SetGeometrySettings(self, maxWorldSize));
+}
+
+static int METHOD_NAME(getGeometrySettings)(lua_State *L)
+{
+    GET_SELF;
+
+    float maxWorldSize = 0;
+    RETURN_IF_ERROR(FMOD_System_GetGeometrySettings(self, &maxWorldSize));
+
+    lua_pushnumber(L, maxWorldSize);
+
+    return 1;
+}
+
+static int METHOD_NAME(getGeometryOcclusion)(lua_State *L)
+{
+    GET_SELF;
+
+    FMOD_VECTOR *listener = CHECK_STRUCT(L, 2, FMOD_VECTOR);
+    FMOD_VECTOR *source = CHECK_STRUCT(L, 3, FMOD_VECTOR);
+
+    float direct = 0;
+    float reverb = 0;
+    RETURN_IF_ERROR(FMOD_System_GetGeometryOcclusion(self, listener, source, &direct, &reverb));
+
+    lua_pushnumber(L, direct);
+    lua_pushnumber(L, reverb);
+
+    return 2;
+}
+
+/* setGeometryTransforms(geometries, values)
+   Moves many geometry objects in one call. values is a flat array holding either
+   3 numbers per geometry (position) or 9 (position, forward, up).
+*/
+static int METHOD_NAME(setGeometryTransforms)(lua_State *L)
+{
+    luaL_checkudata(L, 1, STRINGIZE(SELF_TYPE));
+
+    luaL_checktype(L, 2, LUA_TTABLE);
+    luaL_checktype(L, 3, LUA_TTABLE);
+
+    int geometryCount = (int)lua_objlen(L, 2);
+    int valueCount = (int)lua_objlen(L, 3);
+
+    int stride = geometryCount > 0 ? valueCount / geometryCount : 3;
+
+    luaL_argcheck(L, (stride == 3 || stride == 9) && stride * geometryCount == valueCount, 3,
+        "expected 3 or 9 values per geometry");
+
+    FMOD_RESULT result = FMOD_OK;
+
+    for (int i = 0; i < geometryCount && result == FMOD_OK; ++i) {
+        lua_rawgeti(L, 2, i + 1);
+        FMOD_GEOMETRY *geometry = CHECK_HANDLE(L, -1, FMOD_GEOMETRY);
+        lua_pop(L, 1);
+
+        float values[9];
+
+        for (int v = 0; v < stride; ++v) {
+            lua_rawgeti(L, 3, i * stride + v + 1);
+            values[v] = (float)lua_tonumber(L, -1);
+            lua_pop(L, 1);
+        }
+
+        FMOD_VECTOR position = { values[0], values[1], values[2] };
+        result = FMOD_Geometry_SetPosition(geometry, &position);
+
+        if (result == FMOD_OK && stride == 9) {
+            FMOD_VECTOR forward = { values[3], values[4], values[5] };
+            FMOD_VECTOR up = { values[6], values[7], values[8] };
+
+            result = FMOD_Geometry_SetRotation(geometry, &forward, &up);
+        }
+    }
+
+    RETURN_STATUS(result);
+}
+
 FUNCTION_TABLE_BEGIN(SystemStaticFunctions)
     METHODS_TABLE_ENTRY(create)
 FUNCTION_TABLE_END
 
 METHODS_TABLE_BEGIN
     METHODS_TABLE_ENTRY(release)
+    METHODS_TABLE_ENTRY(setOutput)
+    METHODS_TABLE_ENTRY(getOutput)
     METHODS_TABLE_ENTRY(setSoftwareFormat)
     METHODS_TABLE_ENTRY(init)
     METHODS_TABLE_ENTRY(close)
     METHODS_TABLE_ENTRY(update)
     METHODS_TABLE_ENTRY(createSound)
+    METHODS_TABLE_ENTRY(createDSP)
+    METHODS_TABLE_ENTRY(createDSPByType)
     METHODS_TABLE_ENTRY(playSound)
     METHODS_TABLE_ENTRY(createChannelGroup)
     METHODS_TABLE_ENTRY(getMasterChannelGroup)
+    METHODS_TABLE_ENTRY(addFadePoints)
+    METHODS_TABLE_ENTRY(createSequencer)
+    METHODS_TABLE_ENTRY(createGeometry)
+    METHODS_TABLE_ENTRY(setGeometrySettings)
+    METHODS_TABLE_ENTRY(getGeometrySettings)
+    METHODS_TABLE_ENTRY(getGeometryOcclusion)
+    METHODS_TABLE_ENTRY(setGeometryTransforms)
 METHODS_TABLE_END
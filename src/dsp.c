@@ -25,6 +25,61 @@ DEALINGS IN THE SOFTWARE.
 
 #include "templates.h"
 
+static int METHOD_NAME(release)(lua_State *L)
+{
+    GET_SELF;
+
+    RETURN_STATUS(FMOD_DSP_Release(self));
+}
+
+static int METHOD_NAME(getParameterFloat)(lua_State *L)
+{
+    GET_SELF;
+
+    int index = luaL_checkinteger(L, 2);
+
+    float value = 0;
+    char valuestr[FMOD_DSP_GETPARAM_VALUESTR_LENGTH];
+    RETURN_IF_ERROR(FMOD_DSP_GetParameterFloat(self, index, &value, valuestr, sizeof(valuestr)));
+
+    lua_pushnumber(L, value);
+    lua_pushstring(L, valuestr);
+
+    return 2;
+}
+
+static int METHOD_NAME(getParameterInt)(lua_State *L)
+{
+    GET_SELF;
+
+    int index = luaL_checkinteger(L, 2);
+
+    int value = 0;
+    char valuestr[FMOD_DSP_GETPARAM_VALUESTR_LENGTH];
+    RETURN_IF_ERROR(FMOD_DSP_GetParameterInt(self, index, &value, valuestr, sizeof(valuestr)));
+
+    lua_pushinteger(L, value);
+    lua_pushstring(L, valuestr);
+
+    return 2;
+}
+
+static int METHOD_NAME(getParameterBool)(lua_State *L)
+{
+    GET_SELF;
+
+    int index = luaL_checkinteger(L, 2);
+
+    FMOD_BOOL value = 0;
+    char valuestr[FMOD_DSP_GETPARAM_VALUESTR_LENGTH];
+    RETURN_IF_ERROR(FMOD_DSP_GetParameterBool(self, index, &value, valuestr, sizeof(valuestr)));
+
+    lua_pushboolean(L, value);
+    lua_pushstring(L, valuestr);
+
+    return 2;
+}
+
 GET(SystemObject, (FMOD_SYSTEM, HANDLE))
 GET(NumInputs, int)
 GET(NumOutputs, int)
@@ -37,11 +92,13 @@ GET(NumParameters, int)
 GET(Idle, FMOD_BOOL)
 PROPERTY_MULTI(MeteringEnabled, FMOD_BOOL, FMOD_BOOL)
 GET_MULTI(CPUUsage, unsigned, unsigned)
+SET_INDEXED(ParameterFloat, int, float)
+SET_INDEXED(ParameterInt, int, int)
+SET_INDEXED(ParameterBool, int, FMOD_BOOL)
+GET(Type, (FMOD_DSP_TYPE, CONSTANT))
 
 METHODS_TABLE_BEGIN
-#if 0
     METHODS_TABLE_ENTRY(release)
-#endif
     METHODS_TABLE_ENTRY(getSystemObject)
 #if 0
     METHODS_TABLE_ENTRY(addInput)
@@ -63,13 +120,17 @@ METHODS_TABLE_BEGIN
     METHODS_TABLE_ENTRY(getChannelFormat)
     METHODS_TABLE_ENTRY(getOutputChannelFormat)
     METHODS_TABLE_ENTRY(reset)
+#endif
     METHODS_TABLE_ENTRY(setParameterFloat)
     METHODS_TABLE_ENTRY(setParameterInt)
     METHODS_TABLE_ENTRY(setParameterBool)
+#if 0
     METHODS_TABLE_ENTRY(setParameterData)
+#endif
     METHODS_TABLE_ENTRY(getParameterFloat)
     METHODS_TABLE_ENTRY(getParameterInt)
     METHODS_TABLE_ENTRY(getParameterBool)
+#if 0
     METHODS_TABLE_ENTRY(getParameterData)
 #endif
     METHODS_TABLE_ENTRY(getNumParameters)
@@ -78,8 +139,8 @@ METHODS_TABLE_BEGIN
     METHODS_TABLE_ENTRY(getDataParameterIndex)
     METHODS_TABLE_ENTRY(showConfigDialog)
     METHODS_TABLE_ENTRY(getInfo)
-    METHODS_TABLE_ENTRY(getType)
 #endif
+    METHODS_TABLE_ENTRY(getType)
     METHODS_TABLE_ENTRY(getIdle)
 #if 0
     METHODS_TABLE_ENTRY(setUserData)
@@ -0,0 +1,641 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fmod.h>
+
+#include "dspeffects.h"
+#include "simd.h"
+
+/* Built-in effects for System:createDSP. They run entirely on the mixer thread; Lua
+   only sets parameters. Parameter changes are picked up at the start of the next block,
+   and gain changes are ramped across the block to avoid zipper noise.
+
+   The inner loops use the simd.h lanes. Gain runs along the whole interleaved buffer.
+   The biquad recursion and the limiter depend on the previous frame, so they run
+   across the channels of each frame instead; stereo mostly takes the scalar tail.
+*/
+
+#define DB_TO_LINEAR(db) powf(10.0f, (db) / 20.0f)
+
+/* Static forms of FMOD_DSP_INIT_PARAMDESC_*, so that every description is complete
+   before any thread can look one up
+*/
+#define PARAMDESC_FLOAT(name, label, description, min, max, defaultval) \
+    { FMOD_DSP_PARAMETER_TYPE_FLOAT, name, label, description, \
+        .floatdesc = { min, max, defaultval, { FMOD_DSP_PARAMETER_FLOAT_MAPPING_TYPE_AUTO } } }
+
+#define PARAMDESC_INT(name, label, description, min, max, defaultval, goestoinf, valuenames) \
+    { FMOD_DSP_PARAMETER_TYPE_INT, name, label, description, \
+        .intdesc = { min, max, defaultval, goestoinf, valuenames } }
+
+#define DESCRIPTION_COMMON(effectName, parameters) \
+    .pluginsdkversion = FMOD_PLUGIN_SDK_VERSION, \
+    .name = effectName, \
+    .version = 0x00010000, \
+    .numinputbuffers = 1, \
+    .numoutputbuffers = 1, \
+    .release = releaseState, \
+    .shouldiprocess = skipWhenIdle, \
+    .numparameters = sizeof(parameters) / sizeof(parameters[0]), \
+    .paramdesc = parameters
+
+static void printValue(char *valuestr, const char *format, float value)
+{
+    if (valuestr) {
+        snprintf(valuestr, FMOD_DSP_GETPARAM_VALUESTR_LENGTH, format, value);
+    }
+}
+
+static FMOD_RESULT F_CALL skipWhenIdle(FMOD_DSP_STATE *dsp_state, FMOD_BOOL inputsidle,
+    unsigned int length, FMOD_CHANNELMASK inmask, int inchannels, FMOD_SPEAKERMODE speakermode)
+{
+    return inputsidle ? FMOD_ERR_DSP_DONTPROCESS : FMOD_OK;
+}
+
+static FMOD_RESULT F_CALL releaseState(FMOD_DSP_STATE *dsp_state)
+{
+    free(dsp_state->plugindata);
+    return FMOD_OK;
+}
+
+/* Gain */
+
+enum { GAIN_PARAM_GAIN, GAIN_NUM_PARAMETERS };
+
+typedef struct GainState {
+    float gainDB;
+    float target;
+    float current;
+} GainState;
+
+static FMOD_DSP_PARAMETER_DESC sGainGain =
+    PARAMDESC_FLOAT("Gain", "dB", "Gain in dB. -80 is silence.", -80.0f, 24.0f, 0.0f);
+static FMOD_DSP_PARAMETER_DESC *sGainParameters[GAIN_NUM_PARAMETERS] = { &sGainGain };
+
+static FMOD_RESULT F_CALL gainCreate(FMOD_DSP_STATE *dsp_state)
+{
+    GainState *state = calloc(1, sizeof(*state));
+
+    if (!state) {
+        return FMOD_ERR_MEMORY;
+    }
+
+    state->target = state->current = 1.0f;
+
+    dsp_state->plugindata = state;
+    return FMOD_OK;
+}
+
+static FMOD_RESULT F_CALL gainRead(FMOD_DSP_STATE *dsp_state, float *inbuffer, float *outbuffer,
+    unsigned int length, int inchannels, int *outchannels)
+{
+    GainState *state = dsp_state->plugindata;
+
+    float current = state->current;
+    float target = state->target;
+    unsigned int count = length * inchannels;
+
+    if (current == target) {
+        Lanes gain = SPLAT(target);
+        unsigned int i = 0;
+
+        for (; i + LANES <= count; i += LANES) {
+            STORE(outbuffer + i, MUL(LOAD(inbuffer + i), gain));
+        }
+
+        for (; i < count; ++i) {
+            outbuffer[i] = inbuffer[i] * target;
+        }
+    } else {
+        float step = (target - current) / length;
+
+        for (unsigned int frame = 0; frame < length; ++frame) {
+            float gain = current + step * frame;
+            Lanes gains = SPLAT(gain);
+            float *in = inbuffer + frame * inchannels;
+            float *out = outbuffer + frame * inchannels;
+            int channel = 0;
+
+            for (; channel + LANES <= inchannels; channel += LANES) {
+                STORE(out + channel, MUL(LOAD(in + channel), gains));
+            }
+
+            for (; channel < inchannels; ++channel) {
+                out[channel] = in[channel] * gain;
+            }
+        }
+
+        state->current = target;
+    }
+
+    return FMOD_OK;
+}
+
+static FMOD_RESULT F_CALL gainSetFloat(FMOD_DSP_STATE *dsp_state, int index, float value)
+{
+    GainState *state = dsp_state->plugindata;
+
+    if (index != GAIN_PARAM_GAIN) {
+        return FMOD_ERR_INVALID_PARAM;
+    }
+
+    state->gainDB = value;
+    state->target = value <= -80.0f ? 0.0f : DB_TO_LINEAR(value);
+
+    return FMOD_OK;
+}
+
+static FMOD_RESULT F_CALL gainGetFloat(FMOD_DSP_STATE *dsp_state, int index, float *value, char *valuestr)
+{
+    GainState *state = dsp_state->plugindata;
+
+    if (index != GAIN_PARAM_GAIN) {
+        return FMOD_ERR_INVALID_PARAM;
+    }
+
+    *value = state->gainDB;
+    printValue(valuestr, "%.1f", *value);
+
+    return FMOD_OK;
+}
+
+/* Biquad (RBJ cookbook filters, transposed direct form II) */
+
+enum {
+    BIQUAD_PARAM_TYPE,
+    BIQUAD_PARAM_FREQUENCY,
+    BIQUAD_PARAM_Q,
+    BIQUAD_PARAM_GAIN,
+    BIQUAD_NUM_PARAMETERS
+};
+
+enum {
+    BIQUAD_LOWPASS,
+    BIQUAD_HIGHPASS,
+    BIQUAD_BANDPASS,
+    BIQUAD_NOTCH,
+    BIQUAD_PEAKING,
+    BIQUAD_LOWSHELF,
+    BIQUAD_HIGHSHELF,
+    BIQUAD_NUM_TYPES
+};
+
+static const char *sBiquadTypeNames[BIQUAD_NUM_TYPES] = {
+    "Lowpass", "Highpass", "Bandpass", "Notch", "Peaking", "Low shelf", "High shelf"
+};
+
+typedef struct BiquadState {
+    int type;
+    float frequency;
+    float q;
+    float gainDB;
+    int dirty;
+
+    float b0, b1, b2, a1, a2;
+    float z1[FMOD_MAX_CHANNEL_WIDTH];
+    float z2[FMOD_MAX_CHANNEL_WIDTH];
+} BiquadState;
+
+static FMOD_DSP_PARAMETER_DESC sBiquadType =
+    PARAMDESC_INT("Type", "", "Filter type.", 0, BIQUAD_NUM_TYPES - 1, BIQUAD_LOWPASS, 0, sBiquadTypeNames);
+static FMOD_DSP_PARAMETER_DESC sBiquadFrequency =
+    PARAMDESC_FLOAT("Frequency", "Hz", "Cutoff or centre frequency.", 20.0f, 22000.0f, 1000.0f);
+static FMOD_DSP_PARAMETER_DESC sBiquadQ =
+    PARAMDESC_FLOAT("Q", "", "Resonance.", 0.1f, 10.0f, 0.707f);
+static FMOD_DSP_PARAMETER_DESC sBiquadGain =
+    PARAMDESC_FLOAT("Gain", "dB", "Gain for peaking and shelf filters.", -24.0f, 24.0f, 0.0f);
+static FMOD_DSP_PARAMETER_DESC *sBiquadParameters[BIQUAD_NUM_PARAMETERS] = {
+    &sBiquadType, &sBiquadFrequency, &sBiquadQ, &sBiquadGain
+};
+
+static FMOD_RESULT F_CALL biquadCreate(FMOD_DSP_STATE *dsp_state)
+{
+    BiquadState *state = calloc(1, sizeof(*state));
+
+    if (!state) {
+        return FMOD_ERR_MEMORY;
+    }
+
+    state->type = BIQUAD_LOWPASS;
+    state->frequency = 1000.0f;
+    state->q = 0.707f;
+    state->dirty = 1;
+
+    dsp_state->plugindata = state;
+    return FMOD_OK;
+}
+
+static FMOD_RESULT F_CALL biquadReset(FMOD_DSP_STATE *dsp_state)
+{
+    BiquadState *state = dsp_state->plugindata;
+
+    memset(state->z1, 0, sizeof(state->z1));
+    memset(state->z2, 0, sizeof(state->z2));
+
+    return FMOD_OK;
+}
+
+static void biquadUpdateCoefficients(BiquadState *state, int sampleRate)
+{
+    float nyquist = sampleRate * 0.5f;
+    float frequency = state->frequency < nyquist * 0.99f ? state->frequency : nyquist * 0.99f;
+
+    float w0 = 2.0f * 3.14159265f * frequency / sampleRate;
+    float cosw0 = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * state->q);
+    float A = powf(10.0f, state->gainDB / 40.0f);
+
+    float b0 = 1, b1 = 0, b2 = 0, a0 = 1, a1 = 0, a2 = 0;
+
+    switch (state->type) {
+    case BIQUAD_LOWPASS:
+        b0 = (1 - cosw0) / 2; b1 = 1 - cosw0; b2 = (1 - cosw0) / 2;
+        a0 = 1 + alpha; a1 = -2 * cosw0; a2 = 1 - alpha;
+        break;
+    case BIQUAD_HIGHPASS:
+        b0 = (1 + cosw0) / 2; b1 = -(1 + cosw0); b2 = (1 + cosw0) / 2;
+        a0 = 1 + alpha; a1 = -2 * cosw0; a2 = 1 - alpha;
+        break;
+    case BIQUAD_BANDPASS:
+        b0 = alpha; b1 = 0; b2 = -alpha;
+        a0 = 1 + alpha; a1 = -2 * cosw0; a2 = 1 - alpha;
+        break;
+    case BIQUAD_NOTCH:
+        b0 = 1; b1 = -2 * cosw0; b2 = 1;
+        a0 = 1 + alpha; a1 = -2 * cosw0; a2 = 1 - alpha;
+        break;
+    case BIQUAD_PEAKING:
+        b0 = 1 + alpha * A; b1 = -2 * cosw0; b2 = 1 - alpha * A;
+        a0 = 1 + alpha / A; a1 = -2 * cosw0; a2 = 1 - alpha / A;
+        break;
+    case BIQUAD_LOWSHELF: {
+        float s = 2 * sqrtf(A) * alpha;
+        b0 = A * ((A + 1) - (A - 1) * cosw0 + s);
+        b1 = 2 * A * ((A - 1) - (A + 1) * cosw0);
+        b2 = A * ((A + 1) - (A - 1) * cosw0 - s);
+        a0 = (A + 1) + (A - 1) * cosw0 + s;
+        a1 = -2 * ((A - 1) + (A + 1) * cosw0);
+        a2 = (A + 1) + (A - 1) * cosw0 - s;
+        break;
+    }
+    case BIQUAD_HIGHSHELF: {
+        float s = 2 * sqrtf(A) * alpha;
+        b0 = A * ((A + 1) + (A - 1) * cosw0 + s);
+        b1 = -2 * A * ((A - 1) + (A + 1) * cosw0);
+        b2 = A * ((A + 1) + (A - 1) * cosw0 - s);
+        a0 = (A + 1) - (A - 1) * cosw0 + s;
+        a1 = 2 * ((A - 1) - (A + 1) * cosw0);
+        a2 = (A + 1) - (A - 1) * cosw0 - s;
+        break;
+    }
+    }
+
+    state->b0 = b0 / a0;
+    state->b1 = b1 / a0;
+    state->b2 = b2 / a0;
+    state->a1 = a1 / a0;
+    state->a2 = a2 / a0;
+}
+
+static FMOD_RESULT F_CALL biquadRead(FMOD_DSP_STATE *dsp_state, float *inbuffer, float *outbuffer,
+    unsigned int length, int inchannels, int *outchannels)
+{
+    BiquadState *state = dsp_state->plugindata;
+
+    if (state->dirty) {
+        int sampleRate = 48000;
+        FMOD_DSP_GETSAMPLERATE(dsp_state, &sampleRate);
+
+        state->dirty = 0;
+        biquadUpdateCoefficients(state, sampleRate);
+    }
+
+    const float b0 = state->b0, b1 = state->b1, b2 = state->b2;
+    const float a1 = state->a1, a2 = state->a2;
+    const Lanes vb0 = SPLAT(b0), vb1 = SPLAT(b1), vb2 = SPLAT(b2);
+    const Lanes va1 = SPLAT(a1), va2 = SPLAT(a2);
+
+    /* The recursion runs along each channel, so keep every channel's state in
+       registers-friendly local arrays and process all channels of a frame together.
+    */
+    float z1[FMOD_MAX_CHANNEL_WIDTH];
+    float z2[FMOD_MAX_CHANNEL_WIDTH];
+
+    memcpy(z1, state->z1, sizeof(float) * inchannels);
+    memcpy(z2, state->z2, sizeof(float) * inchannels);
+
+    for (unsigned int frame = 0; frame < length; ++frame) {
+        const float *in = inbuffer + frame * inchannels;
+        float *out = outbuffer + frame * inchannels;
+
+        int channel = 0;
+
+        for (; channel + LANES <= inchannels; channel += LANES) {
+            Lanes x = LOAD(in + channel);
+            Lanes y = ADD(MUL(vb0, x), LOAD(z1 + channel));
+
+            STORE(z1 + channel, ADD(SUB(MUL(vb1, x), MUL(va1, y)), LOAD(z2 + channel)));
+            STORE(z2 + channel, SUB(MUL(vb2, x), MUL(va2, y)));
+
+            STORE(out + channel, y);
+        }
+
+        for (; channel < inchannels; ++channel) {
+            float x = in[channel];
+            float y = b0 * x + z1[channel];
+
+            z1[channel] = b1 * x - a1 * y + z2[channel];
+            z2[channel] = b2 * x - a2 * y;
+
+            out[channel] = y;
+        }
+    }
+
+    memcpy(state->z1, z1, sizeof(float) * inchannels);
+    memcpy(state->z2, z2, sizeof(float) * inchannels);
+
+    return FMOD_OK;
+}
+
+static FMOD_RESULT F_CALL biquadSetFloat(FMOD_DSP_STATE *dsp_state, int index, float value)
+{
+    BiquadState *state = dsp_state->plugindata;
+
+    switch (index) {
+    case BIQUAD_PARAM_FREQUENCY:
+        state->frequency = value;
+        break;
+    case BIQUAD_PARAM_Q:
+        state->q = value;
+        break;
+    case BIQUAD_PARAM_GAIN:
+        state->gainDB = value;
+        break;
+    default:
+        return FMOD_ERR_INVALID_PARAM;
+    }
+
+    state->dirty = 1;
+    return FMOD_OK;
+}
+
+static FMOD_RESULT F_CALL biquadGetFloat(FMOD_DSP_STATE *dsp_state, int index, float *value, char *valuestr)
+{
+    BiquadState *state = dsp_state->plugindata;
+
+    switch (index) {
+    case BIQUAD_PARAM_FREQUENCY:
+        *value = state->frequency;
+        break;
+    case BIQUAD_PARAM_Q:
+        *value = state->q;
+        break;
+    case BIQUAD_PARAM_GAIN:
+        *value = state->gainDB;
+        break;
+    default:
+        return FMOD_ERR_INVALID_PARAM;
+    }
+
+    printValue(valuestr, "%.2f", *value);
+    return FMOD_OK;
+}
+
+static FMOD_RESULT F_CALL biquadSetInt(FMOD_DSP_STATE *dsp_state, int index, int value)
+{
+    BiquadState *state = dsp_state->plugindata;
+
+    if (index != BIQUAD_PARAM_TYPE || value < 0 || value >= BIQUAD_NUM_TYPES) {
+        return FMOD_ERR_INVALID_PARAM;
+    }
+
+    state->type = value;
+    state->dirty = 1;
+
+    return FMOD_OK;
+}
+
+static FMOD_RESULT F_CALL biquadGetInt(FMOD_DSP_STATE *dsp_state, int index, int *value, char *valuestr)
+{
+    BiquadState *state = dsp_state->plugindata;
+
+    if (index != BIQUAD_PARAM_TYPE) {
+        return FMOD_ERR_INVALID_PARAM;
+    }
+
+    *value = state->type;
+
+    if (valuestr) {
+        snprintf(valuestr, FMOD_DSP_GETPARAM_VALUESTR_LENGTH, "%s", sBiquadTypeNames[state->type]);
+    }
+
+    return FMOD_OK;
+}
+
+/* Limiter (peak, instant attack, exponential release) */
+
+enum { LIMITER_PARAM_CEILING, LIMITER_PARAM_RELEASE, LIMITER_NUM_PARAMETERS };
+
+typedef struct LimiterState {
+    float ceilingDB;
+    float releaseMS;
+    float ceiling;
+    float envelope;
+} LimiterState;
+
+static FMOD_DSP_PARAMETER_DESC sLimiterCeiling =
+    PARAMDESC_FLOAT("Ceiling", "dB", "Maximum output level.", -12.0f, 0.0f, 0.0f);
+static FMOD_DSP_PARAMETER_DESC sLimiterRelease =
+    PARAMDESC_FLOAT("Release", "ms", "Release time.", 1.0f, 1000.0f, 50.0f);
+static FMOD_DSP_PARAMETER_DESC *sLimiterParameters[LIMITER_NUM_PARAMETERS] = {
+    &sLimiterCeiling, &sLimiterRelease
+};
+
+static FMOD_RESULT F_CALL limiterCreate(FMOD_DSP_STATE *dsp_state)
+{
+    LimiterState *state = calloc(1, sizeof(*state));
+
+    if (!state) {
+        return FMOD_ERR_MEMORY;
+    }
+
+    state->ceilingDB = 0.0f;
+    state->releaseMS = 50.0f;
+    state->ceiling = 1.0f;
+    state->envelope = 1.0f;
+
+    dsp_state->plugindata = state;
+    return FMOD_OK;
+}
+
+static FMOD_RESULT F_CALL limiterReset(FMOD_DSP_STATE *dsp_state)
+{
+    LimiterState *state = dsp_state->plugindata;
+    state->envelope = 1.0f;
+    return FMOD_OK;
+}
+
+static FMOD_RESULT F_CALL limiterRead(FMOD_DSP_STATE *dsp_state, float *inbuffer, float *outbuffer,
+    unsigned int length, int inchannels, int *outchannels)
+{
+    LimiterState *state = dsp_state->plugindata;
+
+    int sampleRate = 48000;
+    FMOD_DSP_GETSAMPLERATE(dsp_state, &sampleRate);
+
+    const float ceiling = state->ceiling;
+    const float releaseCoefficient = expf(-1.0f / (state->releaseMS * 0.001f * sampleRate));
+
+    float envelope = state->envelope;
+
+    for (unsigned int frame = 0; frame < length; ++frame) {
+        const float *in = inbuffer + frame * inchannels;
+        float *out = outbuffer + frame * inchannels;
+
+        Lanes peaks = SPLAT(0.0f);
+        int channel = 0;
+
+        for (; channel + LANES <= inchannels; channel += LANES) {
+            peaks = MAX(peaks, ABS(LOAD(in + channel)));
+        }
+
+        float peak = horizontalMax(peaks);
+
+        for (; channel < inchannels; ++channel) {
+            float magnitude = fabsf(in[channel]);
+            peak = magnitude > peak ? magnitude : peak;
+        }
+
+        float required = peak > ceiling ? ceiling / peak : 1.0f;
+
+        if (required < envelope) {
+            envelope = required;
+        } else {
+            envelope = required + (envelope - required) * releaseCoefficient;
+        }
+
+        Lanes envelopes = SPLAT(envelope);
+
+        for (channel = 0; channel + LANES <= inchannels; channel += LANES) {
+            STORE(out + channel, MUL(LOAD(in + channel), envelopes));
+        }
+
+        for (; channel < inchannels; ++channel) {
+            out[channel] = in[channel] * envelope;
+        }
+    }
+
+    state->envelope = envelope;
+
+    return FMOD_OK;
+}
+
+static FMOD_RESULT F_CALL limiterSetFloat(FMOD_DSP_STATE *dsp_state, int index, float value)
+{
+    LimiterState *state = dsp_state->plugindata;
+
+    switch (index) {
+    case LIMITER_PARAM_CEILING:
+        state->ceilingDB = value;
+        state->ceiling = DB_TO_LINEAR(value);
+        break;
+    case LIMITER_PARAM_RELEASE:
+        state->releaseMS = value;
+        break;
+    default:
+        return FMOD_ERR_INVALID_PARAM;
+    }
+
+    return FMOD_OK;
+}
+
+static FMOD_RESULT F_CALL limiterGetFloat(FMOD_DSP_STATE *dsp_state, int index, float *value, char *valuestr)
+{
+    LimiterState *state = dsp_state->plugindata;
+
+    switch (index) {
+    case LIMITER_PARAM_CEILING:
+        *value = state->ceilingDB;
+        break;
+    case LIMITER_PARAM_RELEASE:
+        *value = state->releaseMS;
+        break;
+    default:
+        return FMOD_ERR_INVALID_PARAM;
+    }
+
+    printValue(valuestr, "%.1f", *value);
+    return FMOD_OK;
+}
+
+/* Registry */
+
+static FMOD_DSP_DESCRIPTION sGainDescription = {
+    DESCRIPTION_COMMON("luaFMOD Gain", sGainParameters),
+    .create = gainCreate,
+    .read = gainRead,
+    .setparameterfloat = gainSetFloat,
+    .getparameterfloat = gainGetFloat,
+};
+
+static FMOD_DSP_DESCRIPTION sBiquadDescription = {
+    DESCRIPTION_COMMON("luaFMOD Biquad", sBiquadParameters),
+    .create = biquadCreate,
+    .reset = biquadReset,
+    .read = biquadRead,
+    .setparameterfloat = biquadSetFloat,
+    .getparameterfloat = biquadGetFloat,
+    .setparameterint = biquadSetInt,
+    .getparameterint = biquadGetInt,
+};
+
+static FMOD_DSP_DESCRIPTION sLimiterDescription = {
+    DESCRIPTION_COMMON("luaFMOD Limiter", sLimiterParameters),
+    .create = limiterCreate,
+    .reset = limiterReset,
+    .read = limiterRead,
+    .setparameterfloat = limiterSetFloat,
+    .getparameterfloat = limiterGetFloat,
+};
+
+static const struct {
+    const char *name;
+    FMOD_DSP_DESCRIPTION *description;
+} sEffects[] = {
+    { "gain", &sGainDescription },
+    { "biquad", &sBiquadDescription },
+    { "limiter", &sLimiterDescription },
+};
+
+const FMOD_DSP_DESCRIPTION *dspEffectFind(const char *name)
+{
+    for (size_t i = 0; i < sizeof(sEffects) / sizeof(sEffects[0]); ++i) {
+        if (strcmp(sEffects[i].name, name) == 0) {
+            return sEffects[i].description;
+        }
+    }
+
+    return NULL;
+}
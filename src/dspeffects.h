@@ -0,0 +1,9 @@
+#ifndef DSPEFFECTS_H
+#define DSPEFFECTS_H
+
+#include <fmod_dsp.h>
+
+/* Returns the description of a built-in effect, or NULL if there is no such effect */
+const FMOD_DSP_DESCRIPTION *dspEffectFind(const char *name);
+
+#endif /* DSPEFFECTS_H */
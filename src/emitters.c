@@ -0,0 +1,636 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "emitters.h"
+#include "shadow.h"
+
+/* A registry of potential 3D emitters that only keeps event instances alive
+   for emitters within range of a listener. Positions are stored as separate
+   float arrays and bucketed into a spatial hash grid on each update, so the
+   range test only visits emitters in cells near a listener. Emitters are
+   identified by their slot index, which stays valid until removal.
+
+   Releasing or collecting the manager stops and releases the instances it holds,
+   including pooled ones.
+*/
+
+#define EMITTER_USED 0x1
+#define MIN_GRID_SIZE 64
+
+typedef struct PooledInstance {
+    FMOD_STUDIO_EVENTDESCRIPTION *description;
+    FMOD_STUDIO_EVENTINSTANCE *instance;
+} PooledInstance;
+
+struct luaFMOD_EmitterManager {
+    FMOD_STUDIO_SYSTEM *system;
+    int released;
+    float cellSize;
+    float hysteresis;
+
+    int capacity;
+    int slotCount;
+    int freeCount;
+
+    float *x;
+    float *y;
+    float *z;
+    float *maxDistance;
+    FMOD_STUDIO_EVENTDESCRIPTION **descriptions;
+    FMOD_STUDIO_EVENTINSTANCE **instances;
+    unsigned char *flags;
+    unsigned char *wanted;
+    int *freeSlots;
+    unsigned int *cells;
+    int *sorted;
+
+    unsigned int gridSize;
+    int *gridStart;
+
+    PooledInstance *pool;
+    int poolCount;
+    int poolSize;
+
+    int active;
+    int culled;
+    int started;
+    int stopped;
+    int reused;
+    double startedTotal;
+    double stoppedTotal;
+    FMOD_RESULT lastError;
+};
+
+#define SELF_TYPE luaFMOD_EmitterManager
+
+#undef GET_SELF
+#define GET_SELF GET_RELEASABLE_SELF("emitter manager")
+
+static int growArray(void **array, int capacity, size_t itemSize)
+{
+    void *items = realloc(*array, capacity * itemSize);
+
+    if (!items) {
+        return 0;
+    }
+
+    *array = items;
+
+    return 1;
+}
+
+static int reserve(luaFMOD_EmitterManager *manager, int required)
+{
+    if (required <= manager->capacity) {
+        return 1;
+    }
+
+    int capacity = manager->capacity ? manager->capacity * 2 : 64;
+
+    while (capacity < required) {
+        capacity *= 2;
+    }
+
+    if (!growArray((void**)&manager->x, capacity, sizeof(float))
+        || !growArray((void**)&manager->y, capacity, sizeof(float))
+        || !growArray((void**)&manager->z, capacity, sizeof(float))
+        || !growArray((void**)&manager->maxDistance, capacity, sizeof(float))
+        || !growArray((void**)&manager->descriptions, capacity, sizeof(void*))
+        || !growArray((void**)&manager->instances, capacity, sizeof(void*))
+        || !growArray((void**)&manager->flags, capacity, sizeof(unsigned char))
+        || !growArray((void**)&manager->wanted, capacity, sizeof(unsigned char))
+        || !growArray((void**)&manager->freeSlots, capacity, sizeof(int))
+        || !growArray((void**)&manager->cells, capacity, sizeof(unsigned int))
+        || !growArray((void**)&manager->sorted, capacity, sizeof(int))) {
+        return 0;
+    }
+
+    manager->capacity = capacity;
+
+    return 1;
+}
+
+static unsigned int cellHash(int cx, int cy, int cz, unsigned int gridSize)
+{
+    unsigned int hash = (unsigned int)cx * 73856093u ^ (unsigned int)cy * 19349663u
+        ^ (unsigned int)cz * 83492791u;
+
+    return hash & (gridSize - 1);
+}
+
+static int cellCoordinate(float value, float cellSize)
+{
+    return (int)floorf(value / cellSize);
+}
+
+static void recordError(luaFMOD_EmitterManager *manager, FMOD_RESULT result)
+{
+    if (result != FMOD_OK) {
+        manager->lastError = result;
+    }
+}
+
+/* Buckets every used slot into the grid with a counting sort. */
+static int buildGrid(luaFMOD_EmitterManager *manager)
+{
+    unsigned int gridSize = MIN_GRID_SIZE;
+
+    while (gridSize < (unsigned int)manager->slotCount * 2) {
+        gridSize *= 2;
+    }
+
+    if (gridSize != manager->gridSize) {
+        if (!growArray((void**)&manager->gridStart, gridSize + 1, sizeof(int))) {
+            return 0;
+        }
+
+        manager->gridSize = gridSize;
+    }
+
+    memset(manager->gridStart, 0, (gridSize + 1) * sizeof(int));
+
+    for (int i = 0; i < manager->slotCount; ++i) {
+        if (manager->flags[i] & EMITTER_USED) {
+            unsigned int cell = cellHash(cellCoordinate(manager->x[i], manager->cellSize),
+                cellCoordinate(manager->y[i], manager->cellSize),
+                cellCoordinate(manager->z[i], manager->cellSize), gridSize);
+
+            manager->cells[i] = cell;
+            manager->gridStart[cell + 1]++;
+        }
+    }
+
+    for (unsigned int cell = 0; cell < gridSize; ++cell) {
+        manager->gridStart[cell + 1] += manager->gridStart[cell];
+    }
+
+    /* Fill using gridStart as a cursor, then shift it back */
+    for (int i = 0; i < manager->slotCount; ++i) {
+        if (manager->flags[i] & EMITTER_USED) {
+            manager->sorted[manager->gridStart[manager->cells[i]]++] = i;
+        }
+    }
+
+    for (unsigned int cell = gridSize; cell > 0; --cell) {
+        manager->gridStart[cell] = manager->gridStart[cell - 1];
+    }
+
+    manager->gridStart[0] = 0;
+
+    return 1;
+}
+
+static void testEmitter(luaFMOD_EmitterManager *manager, int i, const FMOD_VECTOR *listener)
+{
+    float range = manager->maxDistance[i];
+
+    if (manager->instances[i]) {
+        range += manager->hysteresis;
+    }
+
+    float dx = manager->x[i] - listener->x;
+    float dy = manager->y[i] - listener->y;
+    float dz = manager->z[i] - listener->z;
+
+    if (dx * dx + dy * dy + dz * dz <= range * range) {
+        manager->wanted[i] = 1;
+    }
+}
+
+static void markInRange(luaFMOD_EmitterManager *manager, const FMOD_VECTOR *listener, float range)
+{
+    float cellSize = manager->cellSize;
+
+    int minX = cellCoordinate(listener->x - range, cellSize);
+    int maxX = cellCoordinate(listener->x + range, cellSize);
+    int minY = cellCoordinate(listener->y - range, cellSize);
+    int maxY = cellCoordinate(listener->y + range, cellSize);
+    int minZ = cellCoordinate(listener->z - range, cellSize);
+    int maxZ = cellCoordinate(listener->z + range, cellSize);
+
+    double cellCount = ((double)maxX - minX + 1) * ((double)maxY - minY + 1) * ((double)maxZ - minZ + 1);
+
+    /* Visiting more cells than there are emitters is slower than testing them all */
+    if (cellCount > manager->slotCount) {
+        for (int i = 0; i < manager->slotCount; ++i) {
+            if (manager->flags[i] & EMITTER_USED) {
+                testEmitter(manager, i, listener);
+            }
+        }
+
+        return;
+    }
+
+    for (int cx = minX; cx <= maxX; ++cx) {
+        for (int cy = minY; cy <= maxY; ++cy) {
+            for (int cz = minZ; cz <= maxZ; ++cz) {
+                unsigned int cell = cellHash(cx, cy, cz, manager->gridSize);
+
+                for (int s = manager->gridStart[cell]; s < manager->gridStart[cell + 1]; ++s) {
+                    testEmitter(manager, manager->sorted[s], listener);
+                }
+            }
+        }
+    }
+}
+
+static void setPosition(lua_State *L, luaFMOD_EmitterManager *manager, int i)
+{
+    FMOD_3D_ATTRIBUTES attributes = {
+        { manager->x[i], manager->y[i], manager->z[i] },
+        { 0, 0, 0 },
+        { 0, 0, 1 },
+        { 0, 1, 0 },
+    };
+
+    FMOD_RESULT result = FMOD_Studio_EventInstance_Set3DAttributes(manager->instances[i], &attributes);
+
+    /* Instances are handed out by getInstance, so keep the shadow cache in step */
+    shadowRecord(L, manager->instances[i], SHADOW_ATTRIBUTES, (const float*)&attributes, result);
+    recordError(manager, result);
+}
+
+static void startEmitter(lua_State *L, luaFMOD_EmitterManager *manager, int i)
+{
+    FMOD_STUDIO_EVENTINSTANCE *instance = NULL;
+
+    for (int p = manager->poolCount - 1; p >= 0; --p) {
+        if (manager->pool[p].description == manager->descriptions[i]) {
+            instance = manager->pool[p].instance;
+            manager->pool[p] = manager->pool[--manager->poolCount];
+            manager->reused++;
+            break;
+        }
+    }
+
+    if (!instance) {
+        FMOD_RESULT result = FMOD_Studio_EventDescription_CreateInstance(manager->descriptions[i], &instance);
+
+        if (result != FMOD_OK) {
+            recordError(manager, result);
+            return;
+        }
+    }
+
+    manager->instances[i] = instance;
+
+    setPosition(L, manager, i);
+    recordError(manager, FMOD_Studio_EventInstance_Start(instance));
+
+    manager->started++;
+}
+
+static void stopEmitter(lua_State *L, luaFMOD_EmitterManager *manager, int i, FMOD_STUDIO_STOP_MODE mode)
+{
+    FMOD_STUDIO_EVENTINSTANCE *instance = manager->instances[i];
+
+    shadowForget(L, instance);
+
+    recordError(manager, FMOD_Studio_EventInstance_Stop(instance, mode));
+
+    if (manager->poolCount < manager->poolSize) {
+        manager->pool[manager->poolCount].description = manager->descriptions[i];
+        manager->pool[manager->poolCount].instance = instance;
+        manager->poolCount++;
+    } else {
+        recordError(manager, FMOD_Studio_EventInstance_Release(instance));
+    }
+
+    manager->instances[i] = NULL;
+    manager->stopped++;
+}
+
+int emitterManagerCreate(lua_State *L, FMOD_STUDIO_SYSTEM *system, float cellSize, int poolSize)
+{
+    luaL_argcheck(L, cellSize > 0, 2, "cell size must be positive");
+    luaL_argcheck(L, poolSize >= 0, 3, "pool size must not be negative");
+
+    luaFMOD_EmitterManager *manager = NEW_SELF(L);
+
+    if (poolSize > 0) {
+        manager->pool = malloc(poolSize * sizeof(PooledInstance));
+
+        if (!manager->pool) {
+            return luaL_error(L, "out of memory");
+        }
+    }
+
+    manager->system = system;
+    manager->cellSize = cellSize;
+    manager->poolSize = poolSize;
+    manager->lastError = FMOD_OK;
+
+    return 1;
+}
+
+static int METHOD_NAME(__gc)(lua_State *L)
+{
+    GET_SELF_FOR_GC;
+
+    self->released = 1;
+
+    for (int i = 0; i < self->slotCount; ++i) {
+        if (self->instances[i]) {
+            shadowForget(L, self->instances[i]);
+            FMOD_Studio_EventInstance_Stop(self->instances[i], FMOD_STUDIO_STOP_IMMEDIATE);
+            FMOD_Studio_EventInstance_Release(self->instances[i]);
+        }
+    }
+
+    for (int p = 0; p < self->poolCount; ++p) {
+        FMOD_Studio_EventInstance_Release(self->pool[p].instance);
+    }
+
+    free(self->x);
+    free(self->y);
+    free(self->z);
+    free(self->maxDistance);
+    free(self->descriptions);
+    free(self->instances);
+    free(self->flags);
+    free(self->wanted);
+    free(self->freeSlots);
+    free(self->cells);
+    free(self->sorted);
+    free(self->gridStart);
+    free(self->pool);
+
+    return 0;
+}
+
+/* Stops and releases every instance the manager holds. */
+static int METHOD_NAME(release)(lua_State *L)
+{
+    return METHOD_NAME(__gc)(L);
+}
+
+static int checkEmitter(lua_State *L, luaFMOD_EmitterManager *manager, int index)
+{
+    int id = luaL_checkint(L, index);
+
+    luaL_argcheck(L, 1 <= id && id <= manager->slotCount && (manager->flags[id - 1] & EMITTER_USED),
+        index, "invalid emitter id");
+
+    return id - 1;
+}
+
+/* add(description, x, y, z)
+   Registers an emitter and returns its id. The audible range is taken from the
+   description's maximum distance.
+*/
+static int METHOD_NAME(add)(lua_State *L)
+{
+    GET_SELF;
+
+    FMOD_STUDIO_EVENTDESCRIPTION *description = CHECK_HANDLE(L, 2, FMOD_STUDIO_EVENTDESCRIPTION);
+    float x = (float)luaL_checknumber(L, 3);
+    float y = (float)luaL_checknumber(L, 4);
+    float z = (float)luaL_checknumber(L, 5);
+
+    float minDistance = 0;
+    float maxDistance = 0;
+    RETURN_IF_ERROR(FMOD_Studio_EventDescription_GetMinMaxDistance(description, &minDistance, &maxDistance));
+
+    int i = 0;
+
+    if (self->freeCount > 0) {
+        i = self->freeSlots[--self->freeCount];
+    } else {
+        if (!reserve(self, self->slotCount + 1)) {
+            return luaL_error(L, "out of memory");
+        }
+
+        i = self->slotCount++;
+    }
+
+    self->x[i] = x;
+    self->y[i] = y;
+    self->z[i] = z;
+    self->maxDistance[i] = maxDistance;
+    self->descriptions[i] = description;
+    self->instances[i] = NULL;
+    self->flags[i] = EMITTER_USED;
+    self->wanted[i] = 0;
+
+    lua_pushinteger(L, i + 1);
+
+    return 1;
+}
+
+/* remove(id)
+   Unregisters an emitter, stopping its instance immediately if it has one.
+*/
+static int METHOD_NAME(remove)(lua_State *L)
+{
+    GET_SELF;
+
+    int i = checkEmitter(L, self, 2);
+
+    if (self->instances[i]) {
+        stopEmitter(L, self, i, FMOD_STUDIO_STOP_IMMEDIATE);
+    }
+
+    self->flags[i] = 0;
+    self->freeSlots[self->freeCount++] = i;
+
+    return 0;
+}
+
+static int METHOD_NAME(setPosition)(lua_State *L)
+{
+    GET_SELF;
+
+    int i = checkEmitter(L, self, 2);
+
+    self->x[i] = (float)luaL_checknumber(L, 3);
+    self->y[i] = (float)luaL_checknumber(L, 4);
+    self->z[i] = (float)luaL_checknumber(L, 5);
+
+    return 0;
+}
+
+/* getInstance(id)
+   Returns the emitter's event instance, or nil if it is culled.
+*/
+static int METHOD_NAME(getInstance)(lua_State *L)
+{
+    GET_SELF;
+
+    int i = checkEmitter(L, self, 2);
+
+    if (self->instances[i]) {
+        PUSH_HANDLE(L, FMOD_STUDIO_EVENTINSTANCE, self->instances[i]);
+    } else {
+        lua_pushnil(L);
+    }
+
+    return 1;
+}
+
+/* setHysteresis(distance)
+   Active emitters are kept until they are this far beyond their maximum
+   distance, so emitters near the edge of range don't restart every update.
+*/
+static int METHOD_NAME(setHysteresis)(lua_State *L)
+{
+    GET_SELF;
+
+    float hysteresis = (float)luaL_checknumber(L, 2);
+
+    luaL_argcheck(L, hysteresis >= 0, 2, "hysteresis must not be negative");
+
+    self->hysteresis = hysteresis;
+
+    return 0;
+}
+
+/* update()
+   Starts instances for emitters that have come within range of any listener,
+   stops those that have left range and moves the rest. Call once per frame,
+   after the listener attributes have been set.
+*/
+static int METHOD_NAME(update)(lua_State *L)
+{
+    GET_SELF;
+
+    int numListeners = 0;
+    REQUIRE_OK(FMOD_Studio_System_GetNumListeners(self->system, &numListeners));
+
+    FMOD_VECTOR listeners[FMOD_MAX_LISTENERS];
+
+    for (int l = 0; l < numListeners && l < FMOD_MAX_LISTENERS; ++l) {
+        FMOD_3D_ATTRIBUTES attributes;
+        REQUIRE_OK(FMOD_Studio_System_GetListenerAttributes(self->system, l, &attributes, NULL));
+
+        listeners[l] = attributes.position;
+    }
+
+    if (!buildGrid(self)) {
+        return luaL_error(L, "out of memory");
+    }
+
+    float range = 0;
+
+    for (int i = 0; i < self->slotCount; ++i) {
+        self->wanted[i] = 0;
+
+        if ((self->flags[i] & EMITTER_USED) && self->maxDistance[i] > range) {
+            range = self->maxDistance[i];
+        }
+    }
+
+    range += self->hysteresis;
+
+    for (int l = 0; l < numListeners && l < FMOD_MAX_LISTENERS; ++l) {
+        markInRange(self, &listeners[l], range);
+    }
+
+    self->active = 0;
+    self->culled = 0;
+    self->started = 0;
+    self->stopped = 0;
+    self->reused = 0;
+
+    for (int i = 0; i < self->slotCount; ++i) {
+        if (!(self->flags[i] & EMITTER_USED)) {
+            continue;
+        }
+
+        if (self->wanted[i]) {
+            if (self->instances[i]) {
+                setPosition(L, self, i);
+            } else {
+                startEmitter(L, self, i);
+            }
+        } else if (self->instances[i]) {
+            stopEmitter(L, self, i, FMOD_STUDIO_STOP_ALLOWFADEOUT);
+        }
+
+        if (self->instances[i]) {
+            self->active++;
+        } else {
+            self->culled++;
+        }
+    }
+
+    self->startedTotal += self->started;
+    self->stoppedTotal += self->stopped;
+
+    return 0;
+}
+
+/* Returns a table of counts. active, culled, started, stopped and reused
+   describe the last update; startedTotal and stoppedTotal accumulate.
+*/
+static int METHOD_NAME(getStats)(lua_State *L)
+{
+    GET_SELF;
+
+    lua_createtable(L, 0, 10);
+
+    lua_pushinteger(L, self->slotCount - self->freeCount);
+    lua_setfield(L, -2, "emitters");
+
+    lua_pushinteger(L, self->active);
+    lua_setfield(L, -2, "active");
+
+    lua_pushinteger(L, self->culled);
+    lua_setfield(L, -2, "culled");
+
+    lua_pushinteger(L, self->started);
+    lua_setfield(L, -2, "started");
+
+    lua_pushinteger(L, self->stopped);
+    lua_setfield(L, -2, "stopped");
+
+    lua_pushinteger(L, self->reused);
+    lua_setfield(L, -2, "reused");
+
+    lua_pushinteger(L, self->poolCount);
+    lua_setfield(L, -2, "pooled");
+
+    lua_pushnumber(L, self->startedTotal);
+    lua_setfield(L, -2, "startedTotal");
+
+    lua_pushnumber(L, self->stoppedTotal);
+    lua_setfield(L, -2, "stoppedTotal");
+
+    lua_pushinteger(L, self->lastError);
+    lua_setfield(L, -2, "lastError");
+
+    return 1;
+}
+
+METHODS_TABLE_BEGIN
+    METHODS_TABLE_ENTRY(__gc)
+    METHODS_TABLE_ENTRY(release)
+    METHODS_TABLE_ENTRY(add)
+    METHODS_TABLE_ENTRY(remove)
+    METHODS_TABLE_ENTRY(setPosition)
+    METHODS_TABLE_ENTRY(getInstance)
+    METHODS_TABLE_ENTRY(setHysteresis)
+    METHODS_TABLE_ENTRY(update)
+    METHODS_TABLE_ENTRY(getStats)
+METHODS_TABLE_END
@@ -0,0 +1,11 @@
+#ifndef EMITTERS_H
+#define EMITTERS_H
+
+#include <fmod_studio.h>
+#include <lauxlib.h>
+
+typedef struct luaFMOD_EmitterManager luaFMOD_EmitterManager;
+
+int emitterManagerCreate(lua_State *L, FMOD_STUDIO_SYSTEM *system, float cellSize, int poolSize);
+
+#endif /* EMITTERS_H */
@@ -19,6 +19,7 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include "common.h"
+#include "shadow.h"
 
 #define SELF_TYPE FMOD_STUDIO_EVENTDESCRIPTION
 
@@ -414,6 +415,8 @@ static int METHOD_NAME(releaseAllInstances)(lua_State *L)
 {
     GET_SELF;
 
+    shadowForgetAll(L);
+
     RETURN_STATUS(FMOD_Studio_EventDescription_ReleaseAllInstances(self));
 }
 
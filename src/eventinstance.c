@@ -20,6 +20,9 @@ DEALINGS IN THE SOFTWARE.
 
 #include "callbacks.h"
 #include "common.h"
+#include "context.h"
+#include "parametercache.h"
+#include "shadow.h"
 #include <stdlib.h>
 
 #define SELF_TYPE FMOD_STUDIO_EVENTINSTANCE
@@ -67,7 +70,14 @@ static int METHOD_NAME(setVolume)(lua_State *L)
 
     float volume = (float)luaL_checknumber(L, 2);
 
-    RETURN_STATUS(FMOD_Studio_EventInstance_SetVolume(self, volume));
+    if (shadowIsRedundant(L, self, SHADOW_VOLUME, &volume)) {
+        RETURN_STATUS(FMOD_OK);
+    }
+
+    FMOD_RESULT result = FMOD_Studio_EventInstance_SetVolume(self, volume);
+    shadowRecord(L, self, SHADOW_VOLUME, &volume, result);
+
+    RETURN_STATUS(result);
 }
 
 static int METHOD_NAME(getPitch)(lua_State *L)
@@ -90,7 +100,14 @@ static int METHOD_NAME(setPitch)(lua_State *L)
 
     float pitch = (float)luaL_checknumber(L, 2);
 
-    RETURN_STATUS(FMOD_Studio_EventInstance_SetPitch(self, pitch));
+    if (shadowIsRedundant(L, self, SHADOW_PITCH, &pitch)) {
+        RETURN_STATUS(FMOD_OK);
+    }
+
+    FMOD_RESULT result = FMOD_Studio_EventInstance_SetPitch(self, pitch);
+    shadowRecord(L, self, SHADOW_PITCH, &pitch, result);
+
+    RETURN_STATUS(result);
 }
 
 static int METHOD_NAME(get3DAttributes)(lua_State *L)
@@ -111,7 +128,15 @@ static int METHOD_NAME(set3DAttributes)(lua_State *L)
 
     FMOD_3D_ATTRIBUTES *attributes = CHECK_STRUCT(L, 2, FMOD_3D_ATTRIBUTES);
 
-    RETURN_STATUS(FMOD_Studio_EventInstance_Set3DAttributes(self, attributes));
+    /* The shadow compares the four vectors as 12 consecutive floats */
+    if (shadowIsRedundant(L, self, SHADOW_ATTRIBUTES, (const float*)attributes)) {
+        RETURN_STATUS(FMOD_OK);
+    }
+
+    FMOD_RESULT result = FMOD_Studio_EventInstance_Set3DAttributes(self, attributes);
+    shadowRecord(L, self, SHADOW_ATTRIBUTES, (const float*)attributes, result);
+
+    RETURN_STATUS(result);
 }
 
 static int METHOD_NAME(getListenerMask)(lua_State *L)
@@ -200,8 +225,16 @@ static int METHOD_NAME(setPaused)(lua_State *L)
     GET_SELF;
 
     int paused = lua_toboolean(L, 2);
+    float shadowValue = (float)paused;
+
+    if (shadowIsRedundant(L, self, SHADOW_PAUSED, &shadowValue)) {
+        RETURN_STATUS(FMOD_OK);
+    }
+
+    FMOD_RESULT result = FMOD_Studio_EventInstance_SetPaused(self, paused);
+    shadowRecord(L, self, SHADOW_PAUSED, &shadowValue, result);
 
-    RETURN_STATUS(FMOD_Studio_EventInstance_SetPaused(self, paused));
+    RETURN_STATUS(result);
 }
 
 static int METHOD_NAME(start)(lua_State *L)
@@ -283,6 +316,8 @@ static int METHOD_NAME(release)(lua_State *L)
 {
     GET_SELF;
 
+    shadowForget(L, self);
+
     RETURN_STATUS(FMOD_Studio_EventInstance_Release(self));
 }
 
@@ -298,15 +333,44 @@ static int METHOD_NAME(isVirtual)(lua_State *L)
     return 1;
 }
 
+/* The name-based parameter methods go through the parameter cache, which maps
+   the name (and label) strings to an ID (and label value) for the ID-based API.
+   Names that can't be cached, or stale entries, fall back to the name-based call.
+*/
+static int lookupParameter(lua_State *L, FMOD_STUDIO_EVENTINSTANCE *self, int labelIndex,
+    FMOD_STUDIO_EVENTDESCRIPTION **description, FMOD_STUDIO_PARAMETER_ID *id, float *labelValue)
+{
+    return FMOD_Studio_EventInstance_GetDescription(self, description) == FMOD_OK
+        && parameterCacheLookup(L, NULL, *description, 2, labelIndex, id, labelValue);
+}
+
 static int METHOD_NAME(getParameterByName)(lua_State *L)
 {
     GET_SELF;
 
     const char *name = luaL_checkstring(L, 2);
 
+    FMOD_STUDIO_EVENTDESCRIPTION *description = NULL;
+    FMOD_STUDIO_PARAMETER_ID id;
+    float labelValue = 0;
+
     float value = 0;
     float finalvalue = 0;
-    RETURN_IF_ERROR(FMOD_Studio_EventInstance_GetParameterByName(self, name, &value, &finalvalue));
+    FMOD_RESULT result = FMOD_ERR_EVENT_NOTFOUND;
+
+    if (lookupParameter(L, self, 0, &description, &id, &labelValue)) {
+        result = FMOD_Studio_EventInstance_GetParameterByID(self, id, &value, &finalvalue);
+
+        if (PARAMETER_CACHE_STALE(result)) {
+            parameterCacheForget(L, NULL, description, 2, 0);
+        }
+    }
+
+    if (PARAMETER_CACHE_STALE(result)) {
+        result = FMOD_Studio_EventInstance_GetParameterByName(self, name, &value, &finalvalue);
+    }
+
+    RETURN_IF_ERROR(result);
 
     lua_pushnumber(L, value);
     lua_pushnumber(L, finalvalue);
@@ -322,6 +386,27 @@ static int METHOD_NAME(setParameterByName)(lua_State *L)
     float value = (float)luaL_checknumber(L, 3);
     int ignoreseekspeed = lua_toboolean(L, 4);
 
+    FMOD_STUDIO_EVENTDESCRIPTION *description = NULL;
+    FMOD_STUDIO_PARAMETER_ID id;
+    float labelValue = 0;
+
+    if (lookupParameter(L, self, 0, &description, &id, &labelValue)) {
+        if (!ignoreseekspeed && shadowIsRedundantParameter(L, self, id, value)) {
+            RETURN_STATUS(FMOD_OK);
+        }
+
+        FMOD_RESULT result = FMOD_Studio_EventInstance_SetParameterByID(self, id, value, ignoreseekspeed);
+        shadowRecordParameter(L, self, id, value, result);
+
+        if (!PARAMETER_CACHE_STALE(result)) {
+            RETURN_STATUS(result);
+        }
+
+        parameterCacheForget(L, NULL, description, 2, 0);
+    }
+
+    shadowForgetParameters(L, self);
+
     RETURN_STATUS(FMOD_Studio_EventInstance_SetParameterByName(self, name, value, ignoreseekspeed));
 }
 
@@ -333,6 +418,27 @@ static int METHOD_NAME(setParameterByNameWithLabel)(lua_State *L)
     const char *label = luaL_checkstring(L, 3);
     int ignoreseekspeed = lua_toboolean(L, 4);
 
+    FMOD_STUDIO_EVENTDESCRIPTION *description = NULL;
+    FMOD_STUDIO_PARAMETER_ID id;
+    float labelValue = 0;
+
+    if (lookupParameter(L, self, 3, &description, &id, &labelValue)) {
+        if (!ignoreseekspeed && shadowIsRedundantParameter(L, self, id, labelValue)) {
+            RETURN_STATUS(FMOD_OK);
+        }
+
+        FMOD_RESULT result = FMOD_Studio_EventInstance_SetParameterByID(self, id, labelValue, ignoreseekspeed);
+        shadowRecordParameter(L, self, id, labelValue, result);
+
+        if (!PARAMETER_CACHE_STALE(result)) {
+            RETURN_STATUS(result);
+        }
+
+        parameterCacheForget(L, NULL, description, 2, 3);
+    }
+
+    shadowForgetParameters(L, self);
+
     RETURN_STATUS(FMOD_Studio_EventInstance_SetParameterByNameWithLabel(self, name, label, ignoreseekspeed));
 }
 
@@ -360,7 +466,15 @@ static int METHOD_NAME(setParameterByID)(lua_State *L)
     float value = (float)luaL_checknumber(L, 3);
     int ignoreseekspeed = lua_toboolean(L, 4);
 
-    RETURN_STATUS(FMOD_Studio_EventInstance_SetParameterByID(self, *id, value, ignoreseekspeed));
+    /* Skipping a write with ignoreseekspeed could leave a seek in progress */
+    if (!ignoreseekspeed && shadowIsRedundantParameter(L, self, *id, value)) {
+        RETURN_STATUS(FMOD_OK);
+    }
+
+    FMOD_RESULT result = FMOD_Studio_EventInstance_SetParameterByID(self, *id, value, ignoreseekspeed);
+    shadowRecordParameter(L, self, *id, value, result);
+
+    RETURN_STATUS(result);
 }
 
 static int METHOD_NAME(setParameterByIDWithLabel)(lua_State *L)
@@ -371,6 +485,8 @@ static int METHOD_NAME(setParameterByIDWithLabel)(lua_State *L)
     const char *label = luaL_checkstring(L, 3);
     int ignoreseekspeed = lua_toboolean(L, 4);
 
+    shadowForgetParameters(L, self);
+
     RETURN_STATUS(FMOD_Studio_EventInstance_SetParameterByIDWithLabel(self, *id, label, ignoreseekspeed));
 }
 
@@ -391,6 +507,8 @@ static int METHOD_NAME(setParametersByIDs)(lua_State *L)
         free(ids); \
     } while(0)
 
+    shadowForgetParameters(L, self);
+
     RETURN_IF_ERROR(FMOD_Studio_EventInstance_SetParametersByIDs(self, ids, values, count, ignoreseekspeed), CLEANUP; );
 
     CLEANUP;
@@ -413,6 +531,9 @@ static int METHOD_NAME(setCallback)(lua_State *L)
 
     int reference = callbackPrepare(L, 2, self);
 
+    /* eventCallback finds the callback state through the instance's FMOD userdata */
+    RETURN_IF_ERROR(FMOD_Studio_EventInstance_SetUserData(self, contextGet(L)));
+
     RETURN_STATUS(FMOD_Studio_EventInstance_SetCallback(self, eventCallback, FMOD_STUDIO_EVENT_CALLBACK_ALL));
 
     /*  TODO
@@ -449,7 +570,7 @@ static int METHOD_NAME(setUserData)(lua_State *L)
     callbacks_checkUserData(L, 2);
     callbacks_setUserData(L, 2, self);
 
-    /* RETURN_STATUS(FMOD_Studio_EventInstance_SetUserData(self, something)); */
+    /* The FMOD userdata is reserved for the context; see setCallback */
 
     RETURN_STATUS(FMOD_OK);
 }
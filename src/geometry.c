@@ -0,0 +1,251 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include "common.h"
+
+#define SELF_TYPE FMOD_GEOMETRY
+#define FMOD_PREFIX FMOD_Geometry_
+
+#include "templates.h"
+
+static int METHOD_NAME(release)(lua_State *L)
+{
+    GET_SELF;
+
+    RETURN_STATUS(FMOD_Geometry_Release(self));
+}
+
+/* Reads the value for polygon index from the array at tableIndex, or the shared
+   value if tableIndex holds a single value.
+*/
+static float perPolygonNumber(lua_State *L, int tableIndex, int index)
+{
+    if (lua_type(L, tableIndex) == LUA_TTABLE) {
+        lua_rawgeti(L, tableIndex, index);
+        float value = (float)lua_tonumber(L, -1);
+        lua_pop(L, 1);
+        return value;
+    } else {
+        return (float)lua_tonumber(L, tableIndex);
+    }
+}
+
+static int perPolygonBool(lua_State *L, int tableIndex, int index)
+{
+    if (lua_type(L, tableIndex) == LUA_TTABLE) {
+        lua_rawgeti(L, tableIndex, index);
+        int value = lua_toboolean(L, -1);
+        lua_pop(L, 1);
+        return value;
+    } else {
+        return lua_toboolean(L, tableIndex);
+    }
+}
+
+/* Required arguments take numbers; optional ones take booleans and may be nil */
+static void checkPerPolygon(lua_State *L, int index, int polygonCount, int optional)
+{
+    if (lua_type(L, index) == LUA_TTABLE) {
+        luaL_argcheck(L, (int)lua_objlen(L, index) == polygonCount, index,
+            "expected one value per polygon");
+    } else if (optional) {
+        if (!lua_isnoneornil(L, index)) {
+            luaL_checktype(L, index, LUA_TBOOLEAN);
+        }
+    } else {
+        luaL_checknumber(L, index);
+    }
+}
+
+/* addPolygons(vertices, sizes, directOcclusion, reverbOcclusion, [doubleSided])
+   Adds many polygons in one call. vertices is a flat array of x, y, z coordinates
+   for every vertex of every polygon, in order. sizes is either the vertex count
+   shared by every polygon (e.g. 3 for triangles) or an array with one count per
+   polygon. The occlusion and doubleSided arguments are either a single value for
+   every polygon or an array with one value per polygon.
+   Returns the index of the first polygon added and the number of polygons added.
+*/
+static int METHOD_NAME(addPolygons)(lua_State *L)
+{
+    GET_SELF;
+
+    luaL_checktype(L, 2, LUA_TTABLE);
+
+    int coordinateCount = (int)lua_objlen(L, 2);
+    luaL_argcheck(L, coordinateCount % 3 == 0, 2, "vertex coordinate count must be a multiple of 3");
+
+    int vertexCount = coordinateCount / 3;
+    int uniformSize = 0;
+    int polygonCount = 0;
+
+    if (lua_type(L, 3) == LUA_TTABLE) {
+        polygonCount = (int)lua_objlen(L, 3);
+
+        int total = 0;
+
+        for (int i = 1; i <= polygonCount; ++i) {
+            lua_rawgeti(L, 3, i);
+            int size = (int)lua_tointeger(L, -1);
+            lua_pop(L, 1);
+
+            luaL_argcheck(L, size >= 3, 3, "polygons need at least 3 vertices");
+            total += size;
+        }
+
+        luaL_argcheck(L, total == vertexCount, 3, "sizes don't match the vertex count");
+    } else {
+        uniformSize = luaL_checkint(L, 3);
+
+        luaL_argcheck(L, uniformSize >= 3, 3, "polygons need at least 3 vertices");
+        luaL_argcheck(L, vertexCount % uniformSize == 0, 3, "sizes don't match the vertex count");
+
+        polygonCount = vertexCount / uniformSize;
+    }
+
+    checkPerPolygon(L, 4, polygonCount, 0);
+    checkPerPolygon(L, 5, polygonCount, 0);
+    checkPerPolygon(L, 6, polygonCount, 1);
+
+    STACKBUFFER_CREATE(FMOD_VECTOR, vertices, vertexCount);
+
+    for (int v = 0; v < vertexCount; ++v) {
+        lua_rawgeti(L, 2, v * 3 + 1);
+        lua_rawgeti(L, 2, v * 3 + 2);
+        lua_rawgeti(L, 2, v * 3 + 3);
+
+        vertices[v].x = (float)lua_tonumber(L, -3);
+        vertices[v].y = (float)lua_tonumber(L, -2);
+        vertices[v].z = (float)lua_tonumber(L, -1);
+
+        lua_pop(L, 3);
+    }
+
+    FMOD_RESULT result = FMOD_OK;
+    int firstIndex = -1;
+    int added = 0;
+    int vertex = 0;
+
+    for (int p = 1; p <= polygonCount && result == FMOD_OK; ++p) {
+        int size = uniformSize;
+
+        if (!size) {
+            lua_rawgeti(L, 3, p);
+            size = (int)lua_tointeger(L, -1);
+            lua_pop(L, 1);
+        }
+
+        int polygonIndex = 0;
+
+        result = FMOD_Geometry_AddPolygon(self, perPolygonNumber(L, 4, p), perPolygonNumber(L, 5, p),
+            perPolygonBool(L, 6, p), size, &vertices[vertex], &polygonIndex);
+
+        if (result == FMOD_OK) {
+            if (added++ == 0) {
+                firstIndex = polygonIndex;
+            }
+
+            vertex += size;
+        }
+    }
+
+    STACKBUFFER_RELEASE(vertices);
+
+    RETURN_IF_ERROR(result);
+
+    lua_pushinteger(L, firstIndex);
+    lua_pushinteger(L, added);
+
+    return 2;
+}
+
+GET(NumPolygons, int)
+GET_MULTI(MaxPolygons, int, int)
+GET_INDEXED(PolygonNumVertices, int, int)
+
+static int METHOD_NAME(setPolygonVertex)(lua_State *L)
+{
+    GET_SELF;
+
+    int index = luaL_checkinteger(L, 2);
+    int vertexIndex = luaL_checkinteger(L, 3);
+    FMOD_VECTOR *vertex = CHECK_STRUCT(L, 4, FMOD_VECTOR);
+
+    RETURN_STATUS(FMOD_Geometry_SetPolygonVertex(self, index, vertexIndex, vertex));
+}
+
+static int METHOD_NAME(getPolygonVertex)(lua_State *L)
+{
+    GET_SELF;
+
+    int index = luaL_checkinteger(L, 2);
+    int vertexIndex = luaL_checkinteger(L, 3);
+
+    FMOD_VECTOR vertex;
+    RETURN_IF_ERROR(FMOD_Geometry_GetPolygonVertex(self, index, vertexIndex, &vertex));
+
+    PUSH_STRUCT(L, FMOD_VECTOR, vertex);
+
+    return 1;
+}
+
+static int METHOD_NAME(setPolygonAttributes)(lua_State *L)
+{
+    GET_SELF;
+
+    int index = luaL_checkinteger(L, 2);
+    float directOcclusion = (float)luaL_checknumber(L, 3);
+    float reverbOcclusion = (float)luaL_checknumber(L, 4);
+    FMOD_BOOL doubleSided = lua_toboolean(L, 5);
+
+    RETURN_STATUS(FMOD_Geometry_SetPolygonAttributes(self, index, directOcclusion, reverbOcclusion,
+        doubleSided));
+}
+
+GET_INDEXED_MULTI(PolygonAttributes, float, float, FMOD_BOOL)
+PROPERTY(Active, FMOD_BOOL)
+PROPERTY_MULTI(Rotation, (FMOD_VECTOR, STRUCT), (FMOD_VECTOR, STRUCT))
+PROPERTY_MULTI(Position, (FMOD_VECTOR, STRUCT))
+PROPERTY_MULTI(Scale, (FMOD_VECTOR, STRUCT))
+
+METHODS_TABLE_BEGIN
+    METHODS_TABLE_ENTRY(release)
+    METHODS_TABLE_ENTRY(addPolygons)
+    METHODS_TABLE_ENTRY(getNumPolygons)
+    METHODS_TABLE_ENTRY(getMaxPolygons)
+    METHODS_TABLE_ENTRY(getPolygonNumVertices)
+    METHODS_TABLE_ENTRY(setPolygonVertex)
+    METHODS_TABLE_ENTRY(getPolygonVertex)
+    METHODS_TABLE_ENTRY(setPolygonAttributes)
+    METHODS_TABLE_ENTRY(getPolygonAttributes)
+    METHODS_TABLE_ENTRY(setActive)
+    METHODS_TABLE_ENTRY(getActive)
+    METHODS_TABLE_ENTRY(setRotation)
+    METHODS_TABLE_ENTRY(getRotation)
+    METHODS_TABLE_ENTRY(setPosition)
+    METHODS_TABLE_ENTRY(getPosition)
+    METHODS_TABLE_ENTRY(setScale)
+    METHODS_TABLE_ENTRY(getScale)
+#if 0
+    METHODS_TABLE_ENTRY(addPolygon)
+    METHODS_TABLE_ENTRY(save)
+    METHODS_TABLE_ENTRY(setUserData)
+    METHODS_TABLE_ENTRY(getUserData)
+#endif
+METHODS_TABLE_END
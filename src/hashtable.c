@@ -0,0 +1,144 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashtable.h"
+
+#define SLOT(table, type, i) ((char*)(table)->slots + (size_t)(i) * (type)->slotSize)
+
+unsigned int hashPointer(const void *pointer)
+{
+    size_t value = (size_t)pointer;
+
+    value ^= value >> 16;
+    value *= 0x45D9F3Bu;
+
+    return (unsigned int)(value ^ (value >> 16));
+}
+
+/* Returns the slot holding key, or the empty slot where it belongs */
+static void *probe(const HashTable *table, const HashTableType *type, unsigned int hash, const void *key)
+{
+    unsigned int mask = table->size - 1;
+    unsigned int i = hash & mask;
+
+    while (type->used(SLOT(table, type, i)) && !(key && type->matches(SLOT(table, type, i), key))) {
+        i = (i + 1) & mask;
+    }
+
+    return SLOT(table, type, i);
+}
+
+void *hashTableFind(const HashTable *table, const HashTableType *type, unsigned int hash, const void *key)
+{
+    if (table->size == 0) {
+        return NULL;
+    }
+
+    void *slot = probe(table, type, hash, key);
+
+    return type->used(slot) ? slot : NULL;
+}
+
+static int grow(HashTable *table, const HashTableType *type)
+{
+    unsigned int size = table->size ? table->size * 2 : type->minSize;
+    void *slots = calloc(size, type->slotSize);
+
+    if (!slots) {
+        return 0;
+    }
+
+    HashTable old = *table;
+
+    table->slots = slots;
+    table->size = size;
+
+    for (unsigned int i = 0; i < old.size; ++i) {
+        void *slot = SLOT(&old, type, i);
+
+        if (type->used(slot)) {
+            memcpy(probe(table, type, type->hash(slot), NULL), slot, type->slotSize);
+        }
+    }
+
+    free(old.slots);
+
+    return 1;
+}
+
+void *hashTableInsert(HashTable *table, const HashTableType *type, unsigned int hash)
+{
+    if ((unsigned int)(table->count + 1) * 2 > table->size && !grow(table, type)) {
+        return NULL;
+    }
+
+    table->count++;
+
+    return probe(table, type, hash, NULL);
+}
+
+void hashTableRemove(HashTable *table, const HashTableType *type, void *slot)
+{
+    unsigned int mask = table->size - 1;
+    unsigned int gap = (unsigned int)(((char*)slot - (char*)table->slots) / type->slotSize);
+    unsigned int i = gap;
+
+    while (1) {
+        i = (i + 1) & mask;
+
+        void *next = SLOT(table, type, i);
+
+        if (!type->used(next)) {
+            break;
+        }
+
+        unsigned int home = type->hash(next) & mask;
+
+        /* Move it if its home isn't cyclically between the gap and its slot */
+        if (((i - home) & mask) >= ((i - gap) & mask)) {
+            memcpy(SLOT(table, type, gap), next, type->slotSize);
+            gap = i;
+        }
+    }
+
+    memset(SLOT(table, type, gap), 0, type->slotSize);
+    table->count--;
+}
+
+void hashTableClear(HashTable *table, const HashTableType *type)
+{
+    if (table->slots) {
+        memset(table->slots, 0, table->size * type->slotSize);
+    }
+
+    table->count = 0;
+}
+
+void hashTableFree(HashTable *table)
+{
+    free(table->slots);
+
+    table->slots = NULL;
+    table->size = 0;
+    table->count = 0;
+}
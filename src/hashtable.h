@@ -0,0 +1,50 @@
+#ifndef HASHTABLE_H
+#define HASHTABLE_H
+
+#include <stddef.h>
+
+/* An open addressing hash table over slots of a caller-defined struct, with
+   linear probing and backward shift deletion. A zeroed slot is empty, and the
+   table grows to stay at most half full.
+*/
+typedef struct HashTable {
+    void *slots;
+    unsigned int size;
+    int count;
+} HashTable;
+
+typedef struct HashTableType {
+    size_t slotSize;
+    unsigned int minSize;
+
+    /* Returns nonzero if the slot holds an entry */
+    int (*used)(const void *slot);
+
+    /* Returns the hash the entry in a used slot was inserted with */
+    unsigned int (*hash)(const void *slot);
+
+    /* Returns nonzero if the entry in a used slot has the key */
+    int (*matches)(const void *slot, const void *key);
+} HashTableType;
+
+#define HASH_SLOT_AT(table, type, i) (((type*)(table).slots) + (i))
+
+unsigned int hashPointer(const void *pointer);
+
+/* Returns the slot holding key, or NULL */
+void *hashTableFind(const HashTable *table, const HashTableType *type, unsigned int hash, const void *key);
+
+/* Returns the empty slot for a new entry with the given hash, which the caller
+   fills in, or NULL if out of memory. The entry is counted already.
+*/
+void *hashTableInsert(HashTable *table, const HashTableType *type, unsigned int hash);
+
+/* Empties the slot; a later entry from its probe run may move into it */
+void hashTableRemove(HashTable *table, const HashTableType *type, void *slot);
+
+/* Removes every entry, keeping the slots allocated */
+void hashTableClear(HashTable *table, const HashTableType *type);
+
+void hashTableFree(HashTable *table);
+
+#endif /* HASHTABLE_H */
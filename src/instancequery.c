@@ -0,0 +1,273 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include "common.h"
+#include "instancequery.h"
+#include "recordarray.h"
+
+/* A reusable array of per-instance state records, filled by
+   FMOD.Studio.queryInstances. Polling a large set of instances costs one
+   binding call and, once the array has grown to size, no allocation.
+   getRecords reads them all back into reusable per-field arrays.
+*/
+
+typedef struct InstanceRecord {
+    FMOD_RESULT result;
+    int state;
+    int position;
+    int virtualState;
+    float volume;
+} InstanceRecord;
+
+struct luaFMOD_InstanceQuery {
+    RecordArray records;
+    int fields;
+};
+
+#define SELF_TYPE luaFMOD_InstanceQuery
+
+#undef GET_SELF
+#define GET_SELF \
+    SELF_TYPE *self = (SELF_TYPE*)luaL_checkudata(L, 1, STRINGIZE(SELF_TYPE))
+
+static void queryRecord(FMOD_STUDIO_EVENTINSTANCE *instance, int fields, InstanceRecord *record)
+{
+    FMOD_RESULT result = FMOD_OK;
+
+    record->state = FMOD_STUDIO_PLAYBACK_STOPPED;
+    record->position = 0;
+    record->virtualState = 0;
+    record->volume = 0;
+
+    if (fields & luaFMOD_QUERY_PLAYBACK_STATE) {
+        FMOD_STUDIO_PLAYBACK_STATE state = FMOD_STUDIO_PLAYBACK_STOPPED;
+        result = FMOD_Studio_EventInstance_GetPlaybackState(instance, &state);
+        record->state = state;
+    }
+
+    if (result == FMOD_OK && (fields & luaFMOD_QUERY_TIMELINE_POSITION)) {
+        result = FMOD_Studio_EventInstance_GetTimelinePosition(instance, &record->position);
+    }
+
+    if (result == FMOD_OK && (fields & luaFMOD_QUERY_VIRTUAL)) {
+        FMOD_BOOL virtualState = 0;
+        result = FMOD_Studio_EventInstance_IsVirtual(instance, &virtualState);
+        record->virtualState = virtualState;
+    }
+
+    if (result == FMOD_OK && (fields & luaFMOD_QUERY_VOLUME)) {
+        float volume = 0;
+        result = FMOD_Studio_EventInstance_GetVolume(instance, &volume, &record->volume);
+    }
+
+    record->result = result;
+}
+
+int queryInstances(lua_State *L)
+{
+    luaL_checktype(L, 1, LUA_TTABLE);
+    int fields = CHECK_CONSTANT(L, 2, luaFMOD_QUERY_FIELDS);
+
+    luaFMOD_InstanceQuery *query = recordArrayPushOwner(L, STRINGIZE(SELF_TYPE), sizeof(*query), 3);
+
+    int count = (int)lua_objlen(L, 1);
+
+    if (!recordArrayReserve(&query->records, count, sizeof(InstanceRecord))) {
+        return luaL_error(L, "out of memory allocating %d instance records", count);
+    }
+
+    query->records.count = 0;
+    query->fields = fields;
+
+    for (int i = 0; i < count; ++i) {
+        lua_rawgeti(L, 1, i + 1);
+        FMOD_STUDIO_EVENTINSTANCE *instance = CHECK_HANDLE(L, -1, FMOD_STUDIO_EVENTINSTANCE);
+        lua_pop(L, 1);
+
+        InstanceRecord *record = RECORD_AT(query->records, InstanceRecord, i);
+
+        queryRecord(instance, fields, record);
+        query->records.count = i + 1;
+
+        if (record->result != FMOD_OK) {
+            countStoredError(L, record->result);
+        }
+    }
+
+    return 1;
+}
+
+static int METHOD_NAME(__gc)(lua_State *L)
+{
+    GET_SELF;
+
+    recordArrayFree(&self->records);
+
+    return 0;
+}
+
+static int METHOD_NAME(getCount)(lua_State *L)
+{
+    GET_SELF;
+
+    lua_pushinteger(L, self->records.count);
+
+    return 1;
+}
+
+/* getRecord(i)
+   Returns the playback state as an integer code (the FMOD_STUDIO_PLAYBACK_STATE
+   value: PLAYING 0, SUSTAINING 1, STOPPED 2, STARTING 3, STOPPING 4), the timeline position in
+   milliseconds, the virtual flag and the final volume. Fields that were not
+   queried are returned as nil. If the instance could not be queried (for
+   example because it has been released) returns nil, message, code.
+   No garbage is created.
+*/
+static int METHOD_NAME(getRecord)(lua_State *L)
+{
+    GET_SELF;
+
+    InstanceRecord *record = recordArrayCheck(L, &self->records, 2, sizeof(InstanceRecord));
+
+    /* Counted by queryInstances */
+    if (record->result != FMOD_OK) {
+        return pushStoredError(L, record->result);
+    }
+
+    if (self->fields & luaFMOD_QUERY_PLAYBACK_STATE) {
+        lua_pushinteger(L, record->state);
+    } else {
+        lua_pushnil(L);
+    }
+
+    if (self->fields & luaFMOD_QUERY_TIMELINE_POSITION) {
+        lua_pushinteger(L, record->position);
+    } else {
+        lua_pushnil(L);
+    }
+
+    if (self->fields & luaFMOD_QUERY_VIRTUAL) {
+        lua_pushboolean(L, record->virtualState);
+    } else {
+        lua_pushnil(L);
+    }
+
+    if (self->fields & luaFMOD_QUERY_VOLUME) {
+        lua_pushnumber(L, record->volume);
+    } else {
+        lua_pushnil(L);
+    }
+
+    return 4;
+}
+
+/* Sets out[name] to an array of the field from every record, reusing the array
+   already there, or removes it if field was not queried. A field of 0 is the
+   result code.
+*/
+static void fillField(lua_State *L, int out, const char *name, const luaFMOD_InstanceQuery *query, int field)
+{
+    int count = query->records.count;
+
+    if (field && !(query->fields & field)) {
+        lua_pushnil(L);
+        lua_setfield(L, out, name);
+        return;
+    }
+
+    lua_getfield(L, out, name);
+
+    if (!lua_istable(L, -1)) {
+        lua_pop(L, 1);
+        lua_createtable(L, count, 0);
+        lua_pushvalue(L, -1);
+        lua_setfield(L, out, name);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const InstanceRecord *record = RECORD_AT(query->records, InstanceRecord, i);
+
+        switch (field) {
+        case luaFMOD_QUERY_PLAYBACK_STATE:
+            lua_pushinteger(L, record->state);
+            break;
+        case luaFMOD_QUERY_TIMELINE_POSITION:
+            lua_pushinteger(L, record->position);
+            break;
+        case luaFMOD_QUERY_VIRTUAL:
+            lua_pushboolean(L, record->virtualState);
+            break;
+        case luaFMOD_QUERY_VOLUME:
+            lua_pushnumber(L, record->volume);
+            break;
+        default:
+            lua_pushinteger(L, record->result);
+            break;
+        }
+
+        lua_rawseti(L, -2, i + 1);
+    }
+
+    /* Clear what a longer fill left behind */
+    for (int i = (int)lua_objlen(L, -1); i > count; --i) {
+        lua_pushnil(L);
+        lua_rawseti(L, -2, i);
+    }
+
+    lua_pop(L, 1);
+}
+
+/* getRecords([out])
+   Reads every record at once into arrays in out, or in a new table if out is
+   nil, and returns it. out.result holds each record's FMOD_RESULT code (0 if it
+   was queried), and out.state, out.position, out.virtual and out.volume hold
+   the queried fields as getRecord returns them; fields that were not queried
+   are removed. Records that could not be queried hold STOPPED, 0, false and 0.
+   Passing the same out table on every poll reuses its arrays, so no garbage is
+   created once they have grown to size.
+*/
+static int METHOD_NAME(getRecords)(lua_State *L)
+{
+    GET_SELF;
+
+    if (lua_isnoneornil(L, 2)) {
+        lua_createtable(L, 0, 5);
+    } else {
+        luaL_checktype(L, 2, LUA_TTABLE);
+        lua_pushvalue(L, 2);
+    }
+
+    int out = lua_gettop(L);
+
+    fillField(L, out, "result", self, 0);
+    fillField(L, out, "state", self, luaFMOD_QUERY_PLAYBACK_STATE);
+    fillField(L, out, "position", self, luaFMOD_QUERY_TIMELINE_POSITION);
+    fillField(L, out, "virtual", self, luaFMOD_QUERY_VIRTUAL);
+    fillField(L, out, "volume", self, luaFMOD_QUERY_VOLUME);
+
+    return 1;
+}
+
+METHODS_TABLE_BEGIN
+    METHODS_TABLE_ENTRY(__gc)
+    METHODS_TABLE_ENTRY(getCount)
+    METHODS_TABLE_ENTRY(getRecord)
+    METHODS_TABLE_ENTRY(getRecords)
+METHODS_TABLE_END
@@ -0,0 +1,20 @@
+#ifndef INSTANCEQUERY_H
+#define INSTANCEQUERY_H
+
+#include <lauxlib.h>
+
+typedef struct luaFMOD_InstanceQuery luaFMOD_InstanceQuery;
+
+/* Field selection for FMOD.Studio.queryInstances */
+typedef int luaFMOD_QUERY_FIELDS;
+
+#define luaFMOD_QUERY_PLAYBACK_STATE    0x00000001
+#define luaFMOD_QUERY_TIMELINE_POSITION 0x00000002
+#define luaFMOD_QUERY_VIRTUAL           0x00000004
+#define luaFMOD_QUERY_VOLUME            0x00000008
+#define luaFMOD_QUERY_ALL               0x0000000F
+
+/* FMOD.Studio.queryInstances(instances, fields, [out]) */
+int queryInstances(lua_State *L);
+
+#endif /* INSTANCEQUERY_H */
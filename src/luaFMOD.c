@@ -18,28 +18,377 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 DEALINGS IN THE SOFTWARE.
 */
 
+#include <string.h>
+
+#include "attributesarray.h"
+#include "await.h"
+#include "bankindex.h"
 #include "common.h"
+#include "context.h"
+#include "instancequery.h"
 #include "platform.h"
 #include "logging.h"
+#include "parametercache.h"
+#include "shadow.h"
+
+/* Scratch arena backing STACKBUFFERs that outgrow their fixed buffer.
+   One arena lives in the registry of each Lua state (coroutines share it)
+   and is used strictly LIFO, so allocation is a pointer bump. When a request
+   doesn't fit a new block is chained on; once the arena drains the chain is
+   collapsed into a single block sized to the high-water mark, so steady-state
+   calls never touch the allocator. */
+#define ARENA_ALIGNMENT 16
+#define ARENA_ALIGN(size) (((size) + (ARENA_ALIGNMENT - 1)) & ~(size_t)(ARENA_ALIGNMENT - 1))
+#define ARENA_MINIMUM_BLOCK 4096
+#define ARENA_HEADER_SIZE ARENA_ALIGN(sizeof(ArenaBlock))
+#define ARENA_BLOCK_DATA(block) ((char*)(block) + ARENA_HEADER_SIZE)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *previous;
+    size_t capacity;
+    size_t used;
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *top;
+    lua_Alloc alloc;
+    void *allocUserdata;
+    size_t capacity;
+    size_t used;
+    size_t highWater;
+    size_t trimThreshold;
+    unsigned int allocations;
+    unsigned int growths;
+    unsigned int trims;
+} ScratchArena;
+
+static int sScratchArenaKey;
+
+static ArenaBlock *arenaBlockCreate(ScratchArena *arena, size_t capacity)
+{
+    ArenaBlock *block = arena->alloc(arena->allocUserdata, NULL, 0, ARENA_HEADER_SIZE + capacity);
+
+    if (block) {
+        block->previous = arena->top;
+        block->capacity = capacity;
+        block->used = 0;
+
+        arena->top = block;
+        arena->capacity += capacity;
+        arena->growths++;
+    }
+
+    return block;
+}
+
+static void arenaBlockFree(ScratchArena *arena)
+{
+    ArenaBlock *block = arena->top;
+
+    arena->top = block->previous;
+    arena->capacity -= block->capacity;
+    arena->used -= block->used;
+
+    arena->alloc(arena->allocUserdata, block, ARENA_HEADER_SIZE + block->capacity, 0);
+}
+
+static int arenaCollect(lua_State *L)
+{
+    ScratchArena *arena = lua_touserdata(L, 1);
+
+    while (arena->top) {
+        arenaBlockFree(arena);
+    }
+
+    return 0;
+}
+
+static ScratchArena *arenaGet(lua_State *L)
+{
+    lua_pushlightuserdata(L, &sScratchArenaKey);
+    lua_rawget(L, LUA_REGISTRYINDEX);
+
+    ScratchArena *arena = lua_touserdata(L, -1);
+
+    lua_pop(L, 1);
+
+    if (!arena) {
+        arena = lua_newuserdata(L, sizeof(*arena));
+        memset(arena, 0, sizeof(*arena));
+        arena->alloc = lua_getallocf(L, &arena->allocUserdata);
+
+        lua_createtable(L, 0, 1);
+        lua_pushcfunction(L, arenaCollect);
+        lua_setfield(L, -2, "__gc");
+        lua_setmetatable(L, -2);
+
+        lua_pushlightuserdata(L, &sScratchArenaKey);
+        lua_insert(L, -2);
+        lua_rawset(L, LUA_REGISTRYINDEX);
+    }
+
+    return arena;
+}
+
+/* Called once the arena has fully drained */
+static void arenaSettle(ScratchArena *arena)
+{
+    if (arena->trimThreshold > 0 && arena->capacity > arena->trimThreshold) {
+        while (arena->top) {
+            arenaBlockFree(arena);
+        }
+
+        arena->highWater = 0;
+        arena->trims++;
+    } else if (arena->top && arena->top->previous) {
+        while (arena->top) {
+            arenaBlockFree(arena);
+        }
+
+        arenaBlockCreate(arena, ARENA_ALIGN(arena->highWater));
+    }
+}
 
 void *stackBufferSelect(lua_State *L, StackBufferInfo *info)
 {
     if (info->size <= sizeof(info->fixedBuffer)) {
         return info->fixedBuffer;
-    } else {
-        void *userdata = NULL;
-        lua_Alloc alloc = lua_getallocf(L, &userdata);
-        return alloc(userdata, NULL, 0, info->size);
     }
+
+    ScratchArena *arena = arenaGet(L);
+    size_t size = ARENA_ALIGN(info->size);
+    ArenaBlock *block = arena->top;
+
+    if (!block || block->capacity - block->used < size) {
+        size_t capacity = block ? block->capacity * 2 : ARENA_MINIMUM_BLOCK;
+
+        if (capacity < size) {
+            capacity = size;
+        }
+
+        if (block && block->used == 0) {
+            arenaBlockFree(arena);
+        }
+
+        block = arenaBlockCreate(arena, capacity);
+
+        if (!block) {
+            luaL_error(L, "out of memory allocating %d byte scratch buffer", (int)info->size);
+            return NULL;
+        }
+    }
+
+    void *pointer = ARENA_BLOCK_DATA(block) + block->used;
+
+    block->used += size;
+    arena->used += size;
+    arena->allocations++;
+
+    if (arena->used > arena->highWater) {
+        arena->highWater = arena->used;
+    }
+
+    return pointer;
 }
 
 void stackBufferRelease(lua_State *L, void *pointer, StackBufferInfo *info)
 {
-    if (pointer != info->fixedBuffer) {
-        void *userdata = NULL;
-        lua_Alloc alloc = lua_getallocf(L, &userdata);
-        alloc(userdata, pointer, info->size, 0);
+    if (pointer == info->fixedBuffer || pointer == NULL) {
+        return;
+    }
+
+    ScratchArena *arena = arenaGet(L);
+
+    /* Releasing rewinds to the pointer, which also reclaims anything above it
+       that was skipped by an error unwinding past its release */
+    while (arena->top) {
+        ArenaBlock *block = arena->top;
+        char *data = ARENA_BLOCK_DATA(block);
+
+        if ((char*)pointer >= data && (char*)pointer < data + block->capacity) {
+            size_t offset = (char*)pointer - data;
+
+            arena->used -= block->used - offset;
+            block->used = offset;
+            break;
+        }
+
+        if (!block->previous) {
+            break;
+        }
+
+        arenaBlockFree(arena);
+    }
+
+    if (arena->used == 0) {
+        arenaSettle(arena);
+    }
+}
+
+void stackBufferReset(lua_State *L)
+{
+    ScratchArena *arena = arenaGet(L);
+
+    if (arena->used > 0) {
+        for (ArenaBlock *block = arena->top; block; block = block->previous) {
+            block->used = 0;
+        }
+
+        arena->used = 0;
+        arenaSettle(arena);
+    }
+}
+
+/* The address of this is the registry key for the interned error messages */
+static int sErrorMessagesKey;
+
+static void createErrorMessages(lua_State *L)
+{
+    lua_pushlightuserdata(L, &sErrorMessagesKey);
+    lua_createtable(L, ERROR_RESULT_SLOTS, 0);
+
+    for (int result = 1; result < ERROR_RESULT_SLOTS; ++result) {
+        lua_pushfstring(L, "FMOD error %d: %s", result, FMOD_ErrorString((FMOD_RESULT)result));
+        lua_rawseti(L, -2, result);
+    }
+
+    lua_rawset(L, LUA_REGISTRYINDEX);
+}
+
+static luaFMOD_Context *countError(lua_State *L, FMOD_RESULT result)
+{
+    luaFMOD_Context *context = contextGet(L);
+
+    int slot = (result > 0 && result < ERROR_RESULT_SLOTS) ? result : ERROR_OTHER_SLOT;
+    atomicAdd(&context->errorCounts[slot], 1);
+
+    return context;
+}
+
+static void pushErrorMessage(lua_State *L, FMOD_RESULT result)
+{
+    if (result > 0 && result < ERROR_RESULT_SLOTS) {
+        lua_pushlightuserdata(L, &sErrorMessagesKey);
+        lua_rawget(L, LUA_REGISTRYINDEX);
+        lua_rawgeti(L, -1, result);
+        lua_remove(L, -2);
+    } else {
+        lua_pushfstring(L, "FMOD error %d: %s", result, FMOD_ErrorString(result));
+    }
+}
+
+void *newReleasable(lua_State *L, size_t size, const char *type)
+{
+    void *object = lua_newuserdata(L, size);
+    memset(object, 0, size);
+
+    luaL_getmetatable(L, type);
+    lua_setmetatable(L, -2);
+
+    return object;
+}
+
+static int pushErrorValues(lua_State *L, luaFMOD_Context *context, FMOD_RESULT result)
+{
+    lua_pushnil(L);
+
+    if (context->fastErrors) {
+        lua_pushinteger(L, result);
+        return 2;
     }
+
+    pushErrorMessage(L, result);
+    lua_pushinteger(L, result);
+
+    return 3;
+}
+
+int hasMetatable(lua_State *L, int index, const char *name)
+{
+    if (!lua_getmetatable(L, index)) {
+        return 0;
+    }
+
+    luaL_getmetatable(L, name);
+    int result = lua_rawequal(L, -1, -2);
+    lua_pop(L, 2);
+
+    return result;
+}
+
+int pushError(lua_State *L, FMOD_RESULT result)
+{
+    return pushErrorValues(L, countError(L, result), result);
+}
+
+void countStoredError(lua_State *L, FMOD_RESULT result)
+{
+    countError(L, result);
+}
+
+int pushStoredError(lua_State *L, FMOD_RESULT result)
+{
+    return pushErrorValues(L, contextGet(L), result);
+}
+
+int raiseError(lua_State *L, FMOD_RESULT result)
+{
+    countError(L, result);
+
+    luaL_where(L, 1);
+    pushErrorMessage(L, result);
+    lua_concat(L, 2);
+
+    return lua_error(L);
+}
+
+int pushDetailedList(lua_State *L, const char *handleType, void **handles, int count,
+    DetailedListGetter getter)
+{
+    StackBufferInfo pathInfo = { 256 };
+    char *path = stackBufferSelect(L, &pathInfo);
+
+    lua_createtable(L, count, 0);
+    lua_createtable(L, count, 0);
+    lua_createtable(L, count, 0);
+
+    for (int i = 0; i < count; ++i) {
+        FMOD_GUID id;
+        int retrieved = 0;
+
+        FMOD_RESULT result = getter(handles[i], &id, path, (int)pathInfo.size, &retrieved);
+
+        if (result == FMOD_ERR_TRUNCATED) {
+            /* Grow to fit; later paths will usually fit too */
+            result = getter(handles[i], &id, NULL, 0, &retrieved);
+
+            if (result == FMOD_OK) {
+                stackBufferRelease(L, path, &pathInfo);
+
+                pathInfo.size = retrieved;
+                path = stackBufferSelect(L, &pathInfo);
+
+                result = getter(handles[i], &id, path, (int)pathInfo.size, &retrieved);
+            }
+        }
+
+        RETURN_IF_ERROR(result, stackBufferRelease(L, path, &pathInfo); lua_pop(L, 3););
+
+        *(void**)lua_newuserdata(L, sizeof(void*)) = handles[i];
+        luaL_getmetatable(L, handleType);
+        lua_setmetatable(L, -2);
+        lua_rawseti(L, -4, i + 1);
+
+        lua_pushstring(L, path);
+        lua_rawseti(L, -3, i + 1);
+
+        PUSH_STRUCT(L, FMOD_GUID, id);
+        lua_rawseti(L, -2, i + 1);
+    }
+
+    stackBufferRelease(L, path, &pathInfo);
+
+    return 3;
 }
 
 static int Debug_Initialize(lua_State *L)
@@ -61,8 +410,189 @@ static int Debug_Initialize(lua_State *L)
     return 0;
 }
 
+static int Scratch_GetStats(lua_State *L)
+{
+    ScratchArena *arena = arenaGet(L);
+
+    lua_createtable(L, 0, 7);
+
+    lua_pushinteger(L, (lua_Integer)arena->capacity);
+    lua_setfield(L, -2, "capacity");
+
+    lua_pushinteger(L, (lua_Integer)arena->used);
+    lua_setfield(L, -2, "used");
+
+    lua_pushinteger(L, (lua_Integer)arena->highWater);
+    lua_setfield(L, -2, "highWater");
+
+    lua_pushinteger(L, (lua_Integer)arena->trimThreshold);
+    lua_setfield(L, -2, "trimThreshold");
+
+    lua_pushinteger(L, arena->allocations);
+    lua_setfield(L, -2, "allocations");
+
+    lua_pushinteger(L, arena->growths);
+    lua_setfield(L, -2, "growths");
+
+    lua_pushinteger(L, arena->trims);
+    lua_setfield(L, -2, "trims");
+
+    return 1;
+}
+
+static int Scratch_SetTrimThreshold(lua_State *L)
+{
+    lua_Integer threshold = luaL_checkinteger(L, 1);
+
+    luaL_argcheck(L, threshold >= 0, 1, "threshold must not be negative");
+
+    ScratchArena *arena = arenaGet(L);
+
+    arena->trimThreshold = (size_t)threshold;
+
+    if (arena->used == 0) {
+        arenaSettle(arena);
+    }
+
+    return 0;
+}
+
+/* Returns 1 if the value at index has a methods table metatable for plain pointer
+   handles (not a struct, constant or garbage collected object), and pushes its
+   type name.
+*/
+static int pushHandleTypeName(lua_State *L, int index)
+{
+    if (lua_type(L, index) != LUA_TUSERDATA || !lua_getmetatable(L, index)) {
+        return 0;
+    }
+
+    lua_getfield(L, -1, "__index");
+    int isMethodsTable = lua_rawequal(L, -1, -2);
+    lua_pop(L, 1);
+
+    lua_getfield(L, -1, "__gc");
+    int isCollected = !lua_isnil(L, -1);
+    lua_pop(L, 1);
+
+    lua_getfield(L, -1, "__name");
+    lua_remove(L, -2);
+
+    if (!isMethodsTable || isCollected || !lua_isstring(L, -1)) {
+        lua_pop(L, 1);
+        return 0;
+    }
+
+    return 1;
+}
+
+/* exportHandle(handle)
+   Returns the handle's pointer as a light userdata and its type name. Both can be
+   passed between Lua states (e.g. worker threads) and turned back into a handle
+   with importHandle.
+*/
+static int exportHandle(lua_State *L)
+{
+    if (!pushHandleTypeName(L, 1)) {
+        return luaL_argerror(L, 1, "expected an FMOD handle");
+    }
+
+    lua_pushlightuserdata(L, *(void**)lua_touserdata(L, 1));
+    lua_insert(L, -2);
+
+    return 2;
+}
+
+/* importHandle(pointer, typeName) */
+static int importHandle(lua_State *L)
+{
+    luaL_checktype(L, 1, LUA_TLIGHTUSERDATA);
+    const char *typeName = luaL_checkstring(L, 2);
+
+    void *pointer = lua_touserdata(L, 1);
+
+    *(void**)lua_newuserdata(L, sizeof(pointer)) = pointer;
+    luaL_getmetatable(L, typeName);
+
+    if (lua_isnil(L, -1)) {
+        return luaL_argerror(L, 2, "unknown handle type");
+    }
+
+    lua_setmetatable(L, -2);
+
+    if (!pushHandleTypeName(L, -1)) {
+        return luaL_argerror(L, 2, "not a handle type");
+    }
+
+    lua_pop(L, 1);
+
+    return 1;
+}
+
+/* Error_SetFastMode(enabled)
+   In fast mode, failed calls return nil and the FMOD_RESULT code without a message.
+*/
+static int Error_SetFastMode(lua_State *L)
+{
+    contextGet(L)->fastErrors = lua_toboolean(L, 1);
+
+    return 0;
+}
+
+/* Returns a table mapping each FMOD_RESULT code returned or raised as an error
+   since the last reset to the number of times it happened. Codes too large for a
+   counter of their own are counted together under "other".
+*/
+static int Error_GetCounts(lua_State *L)
+{
+    luaFMOD_Context *context = contextGet(L);
+
+    lua_newtable(L);
+
+    for (int slot = 1; slot < ERROR_RESULT_SLOTS; ++slot) {
+        long count = context->errorCounts[slot];
+
+        if (count > 0) {
+            lua_pushnumber(L, (lua_Number)count);
+            lua_rawseti(L, -2, slot);
+        }
+    }
+
+    if (context->errorCounts[ERROR_OTHER_SLOT] > 0) {
+        lua_pushnumber(L, (lua_Number)context->errorCounts[ERROR_OTHER_SLOT]);
+        lua_setfield(L, -2, "other");
+    }
+
+    return 1;
+}
+
+static int Error_ResetCounts(lua_State *L)
+{
+    luaFMOD_Context *context = contextGet(L);
+
+    for (int slot = 0; slot < ERROR_RESULT_SLOTS; ++slot) {
+        context->errorCounts[slot] = 0;
+    }
+
+    return 0;
+}
+
 FUNCTION_TABLE_BEGIN(CoreStaticFunctions)
     FUNCTION_TABLE_ENTRY(Debug_Initialize)
+    FUNCTION_TABLE_ENTRY(Scratch_GetStats)
+    FUNCTION_TABLE_ENTRY(Scratch_SetTrimThreshold)
+    FUNCTION_TABLE_ENTRY(Error_SetFastMode)
+    FUNCTION_TABLE_ENTRY(Error_GetCounts)
+    FUNCTION_TABLE_ENTRY(Error_ResetCounts)
+    FUNCTION_TABLE_ENTRY(ParameterCache_GetStats)
+    FUNCTION_TABLE_ENTRY(ParameterCache_Clear)
+    FUNCTION_TABLE_ENTRY(Shadow_SetEnabled)
+    FUNCTION_TABLE_ENTRY(Shadow_GetStats)
+    FUNCTION_TABLE_ENTRY(Shadow_Clear)
+    FUNCTION_TABLE_ENTRY(await)
+    FUNCTION_TABLE_ENTRY(createAttributesArray)
+    FUNCTION_TABLE_ENTRY(exportHandle)
+    FUNCTION_TABLE_ENTRY(importHandle)
 FUNCTION_TABLE_END
 
 static int parseID(lua_State *L)
@@ -79,6 +609,8 @@ static int parseID(lua_State *L)
 
 FUNCTION_TABLE_BEGIN(StudioStaticFunctions)
     FUNCTION_TABLE_ENTRY(parseID)
+    FUNCTION_TABLE_ENTRY(loadBankIndex)
+    FUNCTION_TABLE_ENTRY(queryInstances)
 FUNCTION_TABLE_END
 
 #define REGISTER_FUNCTION_TABLE(L, name, table) \
@@ -119,6 +651,10 @@ static void registerMethodsTable(lua_State *L, const char *name, const luaL_reg
     lua_pushcfunction(L, handlesAreEqual);
     lua_setfield(L, -2, "__eq");
 
+    /* Record the type name so handles can be exported to other states */
+    lua_pushstring(L, name);
+    lua_setfield(L, -2, "__name");
+
     luaL_register(L, NULL, methods);
 
     lua_pop(L, 1);
@@ -137,6 +673,8 @@ extern int LUAFMOD_EXPORT luaopen_luaFMOD(lua_State *L)
 {
     platformInitialize(L);
 
+    createErrorMessages(L);
+
     /* The FMOD table */
     REGISTER_FUNCTION_TABLE(L, "FMOD", CoreStaticFunctions);
 
@@ -147,6 +685,13 @@ extern int LUAFMOD_EXPORT luaopen_luaFMOD(lua_State *L)
     /* Set FMOD.System */
     lua_setfield(L, -2, "System");
 
+    /* The FMOD.Memory table */
+    lua_createtable(L, 0, 2);
+    REGISTER_FUNCTION_TABLE(L, NULL, MemoryStaticFunctions);
+
+    /* Set FMOD.Memory */
+    lua_setfield(L, -2, "Memory");
+
     /* The FMOD.Studio table */
     lua_createtable(L, 0, 1);
     REGISTER_FUNCTION_TABLE(L, NULL, StudioStaticFunctions);
@@ -164,6 +709,7 @@ extern int LUAFMOD_EXPORT luaopen_luaFMOD(lua_State *L)
     /* Create the class method tables */
     REGISTER_METHODS_TABLE(L, FMOD_STUDIO_BANK);
     REGISTER_METHODS_TABLE(L, FMOD_STUDIO_BUS);
+    REGISTER_METHODS_TABLE(L, FMOD_STUDIO_COMMANDREPLAY);
     REGISTER_METHODS_TABLE(L, FMOD_STUDIO_EVENTDESCRIPTION);
     REGISTER_METHODS_TABLE(L, FMOD_STUDIO_EVENTINSTANCE);
     REGISTER_METHODS_TABLE(L, FMOD_STUDIO_SYSTEM);
@@ -174,6 +720,16 @@ extern int LUAFMOD_EXPORT luaopen_luaFMOD(lua_State *L)
     REGISTER_METHODS_TABLE(L, FMOD_CHANNELGROUP);
     REGISTER_METHODS_TABLE(L, FMOD_DSP);
     REGISTER_METHODS_TABLE(L, FMOD_DSPCONNECTION);
+    REGISTER_METHODS_TABLE(L, FMOD_GEOMETRY);
+    REGISTER_METHODS_TABLE(L, luaFMOD_Sequencer);
+    REGISTER_METHODS_TABLE(L, luaFMOD_Telemetry);
+    REGISTER_METHODS_TABLE(L, luaFMOD_BankIndex);
+    REGISTER_METHODS_TABLE(L, luaFMOD_InstanceQuery);
+    REGISTER_METHODS_TABLE(L, luaFMOD_EmitterManager);
+    REGISTER_METHODS_TABLE(L, luaFMOD_ResidencyManager);
+    REGISTER_METHODS_TABLE(L, luaFMOD_Automation);
+    REGISTER_METHODS_TABLE(L, luaFMOD_AttributesArray);
+    REGISTER_METHODS_TABLE(L, luaFMOD_ProgrammerSoundResolver);
 
     /* Create constants */
     createConstantTables(L);
@@ -0,0 +1,494 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "platform.h"
+
+/* FMOD.Memory.initialize{ mode = ..., size = ..., limit = ... }
+
+   Modes:
+     "pool"        - FMOD manages a single preallocated block of `size` bytes.
+     "sizeclass"   - Blocks are rounded up to a size class and recycled through
+                     per-thread caches, so the mixer and stream threads rarely take
+                     a lock or call malloc.
+     "passthrough" - Straight to malloc/realloc/free, with accounting.
+
+   The callback modes keep current, peak and allocation counts per FMOD_MEMORY_TYPE,
+   and fail allocations that would exceed `limit` bytes if it is given. Pool sizes
+   must be a multiple of 512 bytes.
+
+   This must be called before any FMOD system is created.
+*/
+
+enum {
+    CATEGORY_NORMAL,
+    CATEGORY_STREAM_FILE,
+    CATEGORY_STREAM_DECODE,
+    CATEGORY_SAMPLEDATA,
+    CATEGORY_DSP_BUFFER,
+    CATEGORY_PLUGIN,
+    CATEGORY_PERSISTENT,
+    CATEGORY_COUNT
+};
+
+static const char *CATEGORY_NAMES[CATEGORY_COUNT] = {
+    "NORMAL", "STREAM_FILE", "STREAM_DECODE", "SAMPLEDATA", "DSP_BUFFER", "PLUGIN", "PERSISTENT"
+};
+
+/* 64-bit, since long is 32-bit on Windows and totals can pass 2 GB */
+typedef struct Counters {
+    volatile long long current;
+    volatile long long peak;
+    volatile long long count;
+} Counters;
+
+static Counters sTotal;
+static Counters sCategories[CATEGORY_COUNT];
+static long long sLimit = 0;
+
+static int sInitialized = 0;
+static int sAccounting = 0;
+
+static int categoryOf(FMOD_MEMORY_TYPE type)
+{
+    if (type & FMOD_MEMORY_STREAM_FILE) return CATEGORY_STREAM_FILE;
+    if (type & FMOD_MEMORY_STREAM_DECODE) return CATEGORY_STREAM_DECODE;
+    if (type & FMOD_MEMORY_SAMPLEDATA) return CATEGORY_SAMPLEDATA;
+    if (type & FMOD_MEMORY_DSP_BUFFER) return CATEGORY_DSP_BUFFER;
+    if (type & FMOD_MEMORY_PLUGIN) return CATEGORY_PLUGIN;
+    if (type & FMOD_MEMORY_PERSISTENT) return CATEGORY_PERSISTENT;
+    return CATEGORY_NORMAL;
+}
+
+/* Peaks are updated without a compare-and-swap, so they can be slightly low under
+   contention. They are for reporting only.
+*/
+static void countersAdd(Counters *counters, long long size, long long count)
+{
+    long long current = atomicAdd64(&counters->current, size);
+
+    atomicAdd64(&counters->count, count);
+
+    if (current > counters->peak) {
+        counters->peak = current;
+    }
+}
+
+/* Returns 0 if the allocation would exceed the limit */
+static int account(int category, long long size, long long count)
+{
+    long long total = atomicAdd64(&sTotal.current, size);
+
+    if (sLimit && size > 0 && total > sLimit) {
+        atomicAdd64(&sTotal.current, -size);
+        return 0;
+    }
+
+    atomicAdd64(&sTotal.count, count);
+
+    if (total > sTotal.peak) {
+        sTotal.peak = total;
+    }
+
+    countersAdd(&sCategories[category], size, count);
+
+    return 1;
+}
+
+/* Every block handed to FMOD is preceded by this header. It is 16 bytes on all
+   platforms to keep the caller's memory 16-byte aligned.
+*/
+typedef union BlockHeader {
+    struct {
+        unsigned int size;
+        unsigned short sizeClass;
+        unsigned short category;
+        union BlockHeader *next;
+    } info;
+    char padding[16];
+} BlockHeader;
+
+#define HEADER_TO_POINTER(header) ((void*)((header) + 1))
+#define POINTER_TO_HEADER(pointer) (((BlockHeader*)(pointer)) - 1)
+
+/* Pass-through */
+
+static void *F_CALL passthroughAlloc(unsigned int size, FMOD_MEMORY_TYPE type, const char *sourcestr)
+{
+    int category = categoryOf(type);
+
+    if (!account(category, size, 1)) {
+        return NULL;
+    }
+
+    BlockHeader *header = malloc(sizeof(*header) + size);
+
+    if (!header) {
+        account(category, -(long long)size, -1);
+        return NULL;
+    }
+
+    header->info.size = size;
+    header->info.category = category;
+
+    return HEADER_TO_POINTER(header);
+}
+
+static void F_CALL passthroughFree(void *ptr, FMOD_MEMORY_TYPE type, const char *sourcestr)
+{
+    BlockHeader *header = POINTER_TO_HEADER(ptr);
+
+    account(header->info.category, -(long long)header->info.size, -1);
+
+    free(header);
+}
+
+static void *F_CALL passthroughRealloc(void *ptr, unsigned int size, FMOD_MEMORY_TYPE type, const char *sourcestr)
+{
+    if (!ptr) {
+        return passthroughAlloc(size, type, sourcestr);
+    }
+
+    BlockHeader *header = POINTER_TO_HEADER(ptr);
+
+    long long delta = (long long)size - header->info.size;
+
+    if (!account(header->info.category, delta, 0)) {
+        return NULL;
+    }
+
+    BlockHeader *newHeader = realloc(header, sizeof(*header) + size);
+
+    if (!newHeader) {
+        account(header->info.category, -delta, 0);
+        return NULL;
+    }
+
+    newHeader->info.size = size;
+
+    return HEADER_TO_POINTER(newHeader);
+}
+
+/* Size classes */
+
+static const unsigned int SIZE_CLASSES[] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096,
+    6144, 8192, 12288, 16384, 24576, 32768
+};
+
+enum {
+    NUM_SIZE_CLASSES = sizeof(SIZE_CLASSES) / sizeof(SIZE_CLASSES[0]),
+    LARGE_SIZE_CLASS = NUM_SIZE_CLASSES,
+    CACHE_LIMIT = 64,
+    TRANSFER_BATCH = 16,
+};
+
+typedef struct FreeList {
+    BlockHeader *head;
+    int count;
+} FreeList;
+
+static LUAFMOD_CRITICAL_SECTION *sCriticalSection = NULL;
+static FreeList sGlobalLists[NUM_SIZE_CLASSES];
+
+/* Blocks cached by a thread are not returned when the thread exits. The caches are
+   bounded, and FMOD's threads live as long as the system does.
+*/
+static LUAFMOD_THREAD_LOCAL FreeList tCaches[NUM_SIZE_CLASSES];
+
+static int sizeClassOf(unsigned int size)
+{
+    for (int i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        if (size <= SIZE_CLASSES[i]) {
+            return i;
+        }
+    }
+
+    return LARGE_SIZE_CLASS;
+}
+
+static void moveBlocks(FreeList *from, FreeList *to, int count)
+{
+    while (count-- > 0 && from->head) {
+        BlockHeader *block = from->head;
+        from->head = block->info.next;
+        --from->count;
+
+        block->info.next = to->head;
+        to->head = block;
+        ++to->count;
+    }
+}
+
+static BlockHeader *sizeClassTake(int sizeClass)
+{
+    if (sizeClass == LARGE_SIZE_CLASS) {
+        return NULL;
+    }
+
+    FreeList *cache = &tCaches[sizeClass];
+
+    if (!cache->head) {
+        criticalSectionEnter(sCriticalSection);
+        moveBlocks(&sGlobalLists[sizeClass], cache, TRANSFER_BATCH);
+        criticalSectionLeave(sCriticalSection);
+    }
+
+    if (!cache->head) {
+        return NULL;
+    }
+
+    BlockHeader *block = cache->head;
+    cache->head = block->info.next;
+    --cache->count;
+
+    return block;
+}
+
+static void sizeClassGive(BlockHeader *block)
+{
+    int sizeClass = block->info.sizeClass;
+
+    if (sizeClass == LARGE_SIZE_CLASS) {
+        free(block);
+        return;
+    }
+
+    FreeList *cache = &tCaches[sizeClass];
+
+    block->info.next = cache->head;
+    cache->head = block;
+    ++cache->count;
+
+    if (cache->count > CACHE_LIMIT) {
+        criticalSectionEnter(sCriticalSection);
+        moveBlocks(cache, &sGlobalLists[sizeClass], TRANSFER_BATCH);
+        criticalSectionLeave(sCriticalSection);
+    }
+}
+
+static void *F_CALL sizeClassAlloc(unsigned int size, FMOD_MEMORY_TYPE type, const char *sourcestr)
+{
+    int category = categoryOf(type);
+
+    if (!account(category, size, 1)) {
+        return NULL;
+    }
+
+    int sizeClass = sizeClassOf(size);
+
+    BlockHeader *block = sizeClassTake(sizeClass);
+
+    if (!block) {
+        unsigned int capacity = sizeClass == LARGE_SIZE_CLASS ? size : SIZE_CLASSES[sizeClass];
+        block = malloc(sizeof(*block) + capacity);
+    }
+
+    if (!block) {
+        account(category, -(long long)size, -1);
+        return NULL;
+    }
+
+    block->info.size = size;
+    block->info.sizeClass = sizeClass;
+    block->info.category = category;
+
+    return HEADER_TO_POINTER(block);
+}
+
+static void F_CALL sizeClassFree(void *ptr, FMOD_MEMORY_TYPE type, const char *sourcestr)
+{
+    BlockHeader *block = POINTER_TO_HEADER(ptr);
+
+    account(block->info.category, -(long long)block->info.size, -1);
+
+    sizeClassGive(block);
+}
+
+static void *F_CALL sizeClassRealloc(void *ptr, unsigned int size, FMOD_MEMORY_TYPE type, const char *sourcestr)
+{
+    if (!ptr) {
+        return sizeClassAlloc(size, type, sourcestr);
+    }
+
+    BlockHeader *block = POINTER_TO_HEADER(ptr);
+
+    if (block->info.sizeClass != LARGE_SIZE_CLASS && size <= SIZE_CLASSES[block->info.sizeClass]) {
+        long long delta = (long long)size - block->info.size;
+
+        if (!account(block->info.category, delta, 0)) {
+            return NULL;
+        }
+
+        block->info.size = size;
+
+        return ptr;
+    }
+
+    void *newPointer = sizeClassAlloc(size, type, sourcestr);
+
+    if (!newPointer) {
+        return NULL;
+    }
+
+    memcpy(newPointer, ptr, block->info.size < size ? block->info.size : size);
+
+    sizeClassFree(ptr, type, sourcestr);
+
+    return newPointer;
+}
+
+/* Lua interface */
+
+static int initialize(lua_State *L)
+{
+    static const char *MODES[] = { "pool", "sizeclass", "passthrough", NULL };
+
+    luaL_checktype(L, 1, LUA_TTABLE);
+
+    lua_getfield(L, 1, "mode");
+    const char *modeName = lua_tostring(L, -1);
+    int mode = 0;
+
+    while (MODES[mode] && !(modeName && strcmp(MODES[mode], modeName) == 0)) {
+        ++mode;
+    }
+
+    if (!MODES[mode]) {
+        return luaL_argerror(L, 1, lua_pushfstring(L, "invalid mode '%s'", modeName ? modeName : "nil"));
+    }
+
+    lua_getfield(L, 1, "size");
+    lua_Number size = lua_tonumber(L, -1);
+
+    lua_getfield(L, 1, "limit");
+    lua_Number limit = lua_tonumber(L, -1);
+
+    lua_pop(L, 3);
+
+    if (sInitialized) {
+        return luaL_error(L, "FMOD.Memory.initialize has already been called");
+    }
+
+    void *pool = NULL;
+    FMOD_MEMORY_ALLOC_CALLBACK allocCallback = NULL;
+    FMOD_MEMORY_REALLOC_CALLBACK reallocCallback = NULL;
+    FMOD_MEMORY_FREE_CALLBACK freeCallback = NULL;
+
+    if (mode == 0) {
+        /* Deliberately never freed once FMOD has it; FMOD uses it until the process exits */
+        if (size <= 0 || size > INT_MAX) {
+            return luaL_argerror(L, 1, "pool mode requires a positive size that fits in an int");
+        }
+
+        if (fmod(size, 512) != 0) {
+            return luaL_argerror(L, 1, "pool size must be a multiple of 512 bytes");
+        }
+
+        pool = malloc((size_t)size);
+
+        if (!pool) {
+            return luaL_error(L, "failed to allocate %d byte pool", (int)size);
+        }
+    } else if (mode == 1) {
+        sCriticalSection = criticalSectionCreate();
+
+        if (!sCriticalSection) {
+            return luaL_error(L, "out of memory");
+        }
+
+        allocCallback = sizeClassAlloc;
+        reallocCallback = sizeClassRealloc;
+        freeCallback = sizeClassFree;
+    } else {
+        allocCallback = passthroughAlloc;
+        reallocCallback = passthroughRealloc;
+        freeCallback = passthroughFree;
+    }
+
+    sLimit = (long long)limit;
+
+    RETURN_IF_ERROR(FMOD_Memory_Initialize(pool, (int)size, allocCallback, reallocCallback, freeCallback,
+        FMOD_MEMORY_ALL), free(pool););
+
+    sInitialized = 1;
+    sAccounting = (allocCallback != NULL);
+
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+static void pushCounters(lua_State *L, Counters *counters)
+{
+    lua_createtable(L, 0, 3);
+
+    lua_pushnumber(L, (lua_Number)counters->current);
+    lua_setfield(L, -2, "current");
+
+    lua_pushnumber(L, (lua_Number)counters->peak);
+    lua_setfield(L, -2, "peak");
+
+    lua_pushnumber(L, (lua_Number)counters->count);
+    lua_setfield(L, -2, "count");
+}
+
+/* getStats([blocking])
+   Returns FMOD's current and peak allocation sizes, then a table of counters per
+   FMOD_MEMORY_TYPE (nil in pool mode, where FMOD does not call back to us).
+*/
+static int getStats(lua_State *L)
+{
+    FMOD_BOOL blocking = lua_toboolean(L, 1);
+
+    int current = 0;
+    int peak = 0;
+
+    RETURN_IF_ERROR(FMOD_Memory_GetStats(&current, &peak, blocking));
+
+    lua_pushinteger(L, current);
+    lua_pushinteger(L, peak);
+
+    if (!sAccounting) {
+        lua_pushnil(L);
+        return 3;
+    }
+
+    lua_createtable(L, 0, CATEGORY_COUNT + 1);
+
+    pushCounters(L, &sTotal);
+    lua_setfield(L, -2, "ALL");
+
+    for (int i = 0; i < CATEGORY_COUNT; ++i) {
+        pushCounters(L, &sCategories[i]);
+        lua_setfield(L, -2, CATEGORY_NAMES[i]);
+    }
+
+    return 3;
+}
+
+FUNCTION_TABLE_BEGIN(MemoryStaticFunctions)
+    FUNCTION_TABLE_ENTRY(initialize)
+    FUNCTION_TABLE_ENTRY(getStats)
+FUNCTION_TABLE_END
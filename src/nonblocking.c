@@ -0,0 +1,421 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+
+#include "common.h"
+#include "context.h"
+#include "nonblocking.h"
+#include "platform.h"
+
+/* Sounds created with FMOD_NONBLOCKING report completion on an FMOD thread. The
+   callback below only records the result in the queue of the context that created
+   the sound (found through the sound's FMOD userdata); delivery to Lua happens in
+   nonblockingPumpResults, which is called from System:update.
+
+   Per-sound state lives in a registry table keyed by light userdata until the
+   result is delivered, so sounds released without Sound:release don't leak it:
+       { start = <time>, callback = <function>, threads = { <coroutine>, ... } }
+
+   Open latencies outlive the entry, but only for the most recent LATENCY_HISTORY
+   opens; the latency table holds sound -> milliseconds plus a ring of the sounds
+   in its array part, with the next ring slot in "next".
+*/
+
+static const char *REGISTRY_KEY = "luaFMOD_Nonblocking";
+static const char *LATENCY_REGISTRY_KEY = "luaFMOD_NonblockingLatency";
+
+#define LATENCY_HISTORY 256
+
+typedef struct OpenRecord {
+    FMOD_SOUND *sound;
+    FMOD_RESULT result;
+    double time;
+} OpenRecord;
+
+struct NonblockingQueue {
+    LUAFMOD_CRITICAL_SECTION *criticalSection;
+
+    /* Set when the owning state closes; later results are dropped */
+    int closed;
+
+    OpenRecord *records;
+    int count;
+    int capacity;
+};
+
+static FMOD_RESULT F_CALL nonblockCallback(FMOD_SOUND *sound, FMOD_RESULT result)
+{
+    double time = platformGetTime();
+
+    NonblockingQueue *queue = NULL;
+
+    if (FMOD_Sound_GetUserData(sound, (void**)&queue) != FMOD_OK || !queue) {
+        return FMOD_OK;
+    }
+
+    criticalSectionEnter(queue->criticalSection);
+
+    if (queue->closed) {
+        criticalSectionLeave(queue->criticalSection);
+        return FMOD_OK;
+    }
+
+    if (queue->count == queue->capacity) {
+        int capacity = queue->capacity ? queue->capacity * 2 : 32;
+        OpenRecord *records = realloc(queue->records, sizeof(*records) * capacity);
+
+        if (!records) {
+            criticalSectionLeave(queue->criticalSection);
+            return FMOD_ERR_MEMORY;
+        }
+
+        queue->records = records;
+        queue->capacity = capacity;
+    }
+
+    OpenRecord *record = &queue->records[queue->count++];
+    record->sound = sound;
+    record->result = result;
+    record->time = time;
+
+    criticalSectionLeave(queue->criticalSection);
+    return FMOD_OK;
+}
+
+FMOD_RESULT nonblockingPrepare(lua_State *L, FMOD_CREATESOUNDEXINFO *exinfo)
+{
+    luaFMOD_Context *context = contextGet(L);
+
+    if (!context->nonblocking) {
+        NonblockingQueue *queue = calloc(1, sizeof(*queue));
+
+        if (!queue) {
+            return FMOD_ERR_MEMORY;
+        }
+
+        queue->criticalSection = criticalSectionCreate();
+
+        if (!queue->criticalSection) {
+            free(queue);
+            return FMOD_ERR_MEMORY;
+        }
+
+        context->nonblocking = queue;
+    }
+
+    exinfo->nonblockcallback = nonblockCallback;
+    exinfo->userdata = context->nonblocking;
+
+    return FMOD_OK;
+}
+
+/* Pushes the registry table called key, creating it if needed. */
+static void pushTable(lua_State *L, const char *key)
+{
+    lua_getfield(L, LUA_REGISTRYINDEX, key);
+
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_setfield(L, LUA_REGISTRYINDEX, key);
+    }
+}
+
+/* Pushes the nonblocking registry table. */
+static void pushRegistryTable(lua_State *L)
+{
+    pushTable(L, REGISTRY_KEY);
+}
+
+/* Remembers the open latency of sound, forgetting the oldest one if the history is full. */
+static void recordLatency(lua_State *L, FMOD_SOUND *sound, double latency)
+{
+    pushTable(L, LATENCY_REGISTRY_KEY);
+
+    lua_getfield(L, -1, "next");
+    int slot = lua_isnil(L, -1) ? 1 : (int)lua_tointeger(L, -1);
+    lua_pop(L, 1);
+
+    lua_rawgeti(L, -1, slot);
+
+    if (!lua_isnil(L, -1)) {
+        lua_pushnil(L);
+        lua_rawset(L, -3);
+    } else {
+        lua_pop(L, 1);
+    }
+
+    lua_pushlightuserdata(L, sound);
+    lua_rawseti(L, -2, slot);
+
+    lua_pushlightuserdata(L, sound);
+    lua_pushnumber(L, latency);
+    lua_rawset(L, -3);
+
+    lua_pushinteger(L, slot % LATENCY_HISTORY + 1);
+    lua_setfield(L, -2, "next");
+
+    lua_pop(L, 1);
+}
+
+/* Pushes the entry for the given sound, or nil if there isn't one. */
+static void pushEntry(lua_State *L, FMOD_SOUND *sound)
+{
+    pushRegistryTable(L);
+    lua_pushlightuserdata(L, sound);
+    lua_rawget(L, -2);
+    lua_remove(L, -2);
+}
+
+void nonblockingRegister(lua_State *L, FMOD_SOUND *sound, double startTime, int callbackIndex)
+{
+    pushRegistryTable(L);
+    lua_pushlightuserdata(L, sound);
+
+    lua_newtable(L);
+
+    lua_pushnumber(L, startTime);
+    lua_setfield(L, -2, "start");
+
+    if (callbackIndex && !lua_isnoneornil(L, callbackIndex)) {
+        lua_pushvalue(L, callbackIndex);
+        lua_setfield(L, -2, "callback");
+    }
+
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+}
+
+void nonblockingForget(lua_State *L, FMOD_SOUND *sound)
+{
+    pushRegistryTable(L);
+    lua_pushlightuserdata(L, sound);
+    lua_pushnil(L);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+
+    /* The ring slot stays until it is reused; clearing a missing key is harmless */
+    pushTable(L, LATENCY_REGISTRY_KEY);
+    lua_pushlightuserdata(L, sound);
+    lua_pushnil(L);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+}
+
+/* Pushes true on success, or the usual error values on failure. Returns the number of
+   values pushed.
+*/
+static int pushStatus(lua_State *L, FMOD_RESULT result)
+{
+    if (result == FMOD_OK) {
+        lua_pushboolean(L, 1);
+        return 1;
+    } else {
+        return pushError(L, result);
+    }
+}
+
+int nonblockingWaitForOpen(lua_State *L, FMOD_SOUND *sound)
+{
+    pushEntry(L, sound);
+
+    if (lua_isnil(L, -1)) {
+        /* Either delivered already, or not a nonblocking open */
+        FMOD_OPENSTATE state = FMOD_OPENSTATE_READY;
+        FMOD_RESULT result = FMOD_Sound_GetOpenState(sound, &state, NULL, NULL, NULL);
+
+        if (result == FMOD_OK && state == FMOD_OPENSTATE_LOADING) {
+            return luaL_error(L, "sound was not created with FMOD_NONBLOCKING");
+        }
+
+        return pushStatus(L, state == FMOD_OPENSTATE_ERROR && result == FMOD_OK ? FMOD_ERR_FILE_BAD : result);
+    }
+
+    if (lua_pushthread(L)) {
+        return luaL_error(L, "waitForOpen must be called from a coroutine");
+    }
+
+    lua_getfield(L, -2, "threads");
+
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_setfield(L, -4, "threads");
+    }
+
+    lua_pushvalue(L, -2);
+    lua_rawseti(L, -2, (int)lua_objlen(L, -2) + 1);
+
+    lua_settop(L, 0);
+    return lua_yield(L, 0);
+}
+
+int nonblockingPushOpenLatency(lua_State *L, FMOD_SOUND *sound)
+{
+    pushTable(L, LATENCY_REGISTRY_KEY);
+    lua_pushlightuserdata(L, sound);
+    lua_rawget(L, -2);
+    return 1;
+}
+
+/* Stores the error on top of the stack in errorIndex unless an earlier error is already
+   stored there, and pops it.
+*/
+static void keepFirstError(lua_State *L, int errorIndex)
+{
+    if (lua_isnil(L, errorIndex)) {
+        lua_replace(L, errorIndex);
+    } else {
+        lua_pop(L, 1);
+    }
+}
+
+/* Resumes each coroutine waiting on the entry at entryIndex with the open status.
+   Leaves the stack unchanged.
+*/
+static void resumeThreads(lua_State *L, int entryIndex, FMOD_RESULT result, int errorIndex)
+{
+    lua_getfield(L, entryIndex, "threads");
+
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+        return;
+    }
+
+    lua_pushnil(L);
+    lua_setfield(L, entryIndex, "threads");
+
+    int count = (int)lua_objlen(L, -1);
+
+    for (int i = 1; i <= count; ++i) {
+        lua_rawgeti(L, -1, i);
+        lua_State *thread = lua_tothread(L, -1);
+        lua_pop(L, 1);
+
+        /* Skip coroutines that were resumed elsewhere since they started waiting */
+        if (lua_status(thread) != LUA_YIELD) {
+            continue;
+        }
+
+        int status = lua_resume(thread, pushStatus(thread, result));
+
+        if (status != 0 && status != LUA_YIELD) {
+            lua_xmove(thread, L, 1);
+            keepFirstError(L, errorIndex);
+        }
+    }
+
+    lua_pop(L, 1);
+}
+
+void nonblockingClose(NonblockingQueue *queue)
+{
+    criticalSectionEnter(queue->criticalSection);
+
+    free(queue->records);
+    queue->records = NULL;
+    queue->count = 0;
+    queue->capacity = 0;
+    queue->closed = 1;
+
+    criticalSectionLeave(queue->criticalSection);
+}
+
+/* Returns 1 and pushes the first error raised by a callback or coroutine once all
+   results have been delivered, or returns 0 and leaves the stack unchanged.
+*/
+int nonblockingPumpResults(lua_State *L)
+{
+    NonblockingQueue *queue = contextGet(L)->nonblocking;
+
+    if (!queue) {
+        return 0;
+    }
+
+    criticalSectionEnter(queue->criticalSection);
+
+    OpenRecord *records = queue->records;
+    int count = queue->count;
+
+    queue->records = NULL;
+    queue->count = 0;
+    queue->capacity = 0;
+
+    criticalSectionLeave(queue->criticalSection);
+
+    if (count == 0) {
+        free(records);
+        return 0;
+    }
+
+    lua_pushnil(L);
+    int errorIndex = lua_gettop(L);
+
+    for (int i = 0; i < count; ++i) {
+        OpenRecord *record = &records[i];
+
+        pushEntry(L, record->sound);
+        int entryIndex = lua_gettop(L);
+
+        if (lua_isnil(L, entryIndex)) {
+            lua_settop(L, errorIndex);
+            continue;
+        }
+
+        lua_getfield(L, entryIndex, "start");
+        double latency = (record->time - lua_tonumber(L, -1)) * 1000.0;
+        lua_pop(L, 1);
+
+        /* The entry stays on the stack for the callback and waiting coroutines */
+        nonblockingForget(L, record->sound);
+        recordLatency(L, record->sound, latency);
+
+        lua_getfield(L, entryIndex, "callback");
+
+        if (!lua_isnil(L, -1)) {
+            PUSH_HANDLE(L, FMOD_SOUND, record->sound);
+            lua_pushinteger(L, record->result);
+            lua_pushnumber(L, latency);
+
+            if (lua_pcall(L, 3, 0, 0) != 0) {
+                keepFirstError(L, errorIndex);
+            }
+        } else {
+            lua_pop(L, 1);
+        }
+
+        resumeThreads(L, entryIndex, record->result, errorIndex);
+
+        lua_settop(L, errorIndex);
+    }
+
+    free(records);
+
+    if (!lua_isnil(L, errorIndex)) {
+        return 1;
+    }
+
+    lua_pop(L, 1);
+
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef NONBLOCKING_H
+#define NONBLOCKING_H
+
+#include <fmod.h>
+#include <lauxlib.h>
+
+struct NonblockingQueue;
+
+/* Sets the nonblocking callback and userdata in exinfo, which should be a copy
+   of any struct passed from Lua */
+FMOD_RESULT nonblockingPrepare(lua_State *L, FMOD_CREATESOUNDEXINFO *exinfo);
+void nonblockingRegister(lua_State *L, FMOD_SOUND *sound, double startTime, int callbackIndex);
+void nonblockingForget(lua_State *L, FMOD_SOUND *sound);
+int nonblockingWaitForOpen(lua_State *L, FMOD_SOUND *sound);
+int nonblockingPushOpenLatency(lua_State *L, FMOD_SOUND *sound);
+/* Returns 1 and pushes the first error a callback or coroutine raised, else returns 0 */
+int nonblockingPumpResults(lua_State *L);
+
+/* Frees queued results and drops later ones; called when the owning state closes.
+   The queue itself stays, since sounds still opening refer to it.
+*/
+void nonblockingClose(struct NonblockingQueue *queue);
+
+#endif /* NONBLOCKING_H */
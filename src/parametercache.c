@@ -0,0 +1,316 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "hashtable.h"
+#include "parametercache.h"
+
+/* Parameter names passed from Lua are interned strings, so a name is identified
+   by its string pointer. The cache maps (description, name, label) pointers to a
+   parameter ID and label value, letting name-based calls use the ID-based API.
+   Cached strings are anchored in a registry table so their addresses can't be
+   reused while they are in the cache. IDs that FMOD later rejects (the bank was
+   unloaded and the description address reused) are forgotten and looked up again.
+
+   Each Lua state (the main state and the callback state, which run on different
+   threads) has its own cache in its registry, next to the table anchoring its
+   strings, so no locking is needed and a cache goes away with its strings.
+*/
+
+#define MIN_TABLE_SIZE 64
+#define MAX_ENTRIES 4096
+#define MAX_LABEL_LENGTH 256
+
+typedef struct CacheEntry {
+    const void *owner;
+    const char *name;
+    const char *label;
+    FMOD_STUDIO_PARAMETER_ID id;
+    float labelValue;
+} CacheEntry;
+
+struct ParameterCache {
+    HashTable entries;
+
+    double hits;
+    double misses;
+    double uncached;
+};
+
+static int sCacheKey;
+static int sAnchorTableKey;
+
+static int cacheCollect(lua_State *L)
+{
+    ParameterCache *cache = lua_touserdata(L, 1);
+
+    hashTableFree(&cache->entries);
+
+    return 0;
+}
+
+static ParameterCache *cacheGet(lua_State *L)
+{
+    lua_pushlightuserdata(L, &sCacheKey);
+    lua_rawget(L, LUA_REGISTRYINDEX);
+
+    ParameterCache *cache = lua_touserdata(L, -1);
+
+    lua_pop(L, 1);
+
+    if (cache) {
+        return cache;
+    }
+
+    lua_pushlightuserdata(L, &sCacheKey);
+
+    cache = lua_newuserdata(L, sizeof(*cache));
+    memset(cache, 0, sizeof(*cache));
+
+    lua_createtable(L, 0, 1);
+    lua_pushcfunction(L, cacheCollect);
+    lua_setfield(L, -2, "__gc");
+    lua_setmetatable(L, -2);
+
+    lua_rawset(L, LUA_REGISTRYINDEX);
+
+    return cache;
+}
+
+static unsigned int keyHash(const CacheEntry *key)
+{
+    size_t value = (size_t)key->owner * 31 + (size_t)key->name * 17 + (size_t)key->label;
+
+    value ^= value >> 16;
+    value *= 0x45D9F3Bu;
+
+    return (unsigned int)(value ^ (value >> 16));
+}
+
+static int entryUsed(const void *slot)
+{
+    return ((const CacheEntry*)slot)->name != NULL;
+}
+
+static unsigned int entryHash(const void *slot)
+{
+    return keyHash(slot);
+}
+
+/* key is a CacheEntry holding only the owner, name and label */
+static int entryMatches(const void *slot, const void *key)
+{
+    const CacheEntry *entry = slot;
+    const CacheEntry *wanted = key;
+
+    return entry->owner == wanted->owner && entry->name == wanted->name && entry->label == wanted->label;
+}
+
+static const HashTableType sEntryType = {
+    sizeof(CacheEntry), MIN_TABLE_SIZE, entryUsed, entryHash, entryMatches
+};
+
+/* Removed entries' strings stay anchored until the cache is next cleared */
+static void clearCache(lua_State *L, ParameterCache *cache)
+{
+    hashTableClear(&cache->entries, &sEntryType);
+
+    lua_pushlightuserdata(L, &sAnchorTableKey);
+    lua_newtable(L);
+    lua_rawset(L, LUA_REGISTRYINDEX);
+}
+
+static void anchorString(lua_State *L, int index)
+{
+    lua_pushlightuserdata(L, &sAnchorTableKey);
+    lua_rawget(L, LUA_REGISTRYINDEX);
+
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushlightuserdata(L, &sAnchorTableKey);
+        lua_pushvalue(L, -2);
+        lua_rawset(L, LUA_REGISTRYINDEX);
+    }
+
+    lua_pushvalue(L, index);
+    lua_pushboolean(L, 1);
+    lua_rawset(L, -3);
+
+    lua_pop(L, 1);
+}
+
+static FMOD_RESULT resolveID(FMOD_STUDIO_SYSTEM *system, FMOD_STUDIO_EVENTDESCRIPTION *owner, const char *name,
+    FMOD_STUDIO_PARAMETER_ID *id)
+{
+    FMOD_STUDIO_PARAMETER_DESCRIPTION parameter;
+    FMOD_RESULT result = FMOD_OK;
+
+    if (owner) {
+        result = FMOD_Studio_EventDescription_GetParameterDescriptionByName(owner, name, &parameter);
+    } else {
+        result = FMOD_Studio_System_GetParameterDescriptionByName(system, name, &parameter);
+    }
+
+    if (result == FMOD_OK) {
+        *id = parameter.id;
+    }
+
+    return result;
+}
+
+/* Labeled parameters take the label's index as their value */
+static FMOD_RESULT resolveLabel(FMOD_STUDIO_SYSTEM *system, FMOD_STUDIO_EVENTDESCRIPTION *owner,
+    FMOD_STUDIO_PARAMETER_ID id, const char *label, float *labelValue)
+{
+    char buffer[MAX_LABEL_LENGTH];
+
+    for (int i = 0; ; ++i) {
+        FMOD_RESULT result = FMOD_OK;
+
+        if (owner) {
+            result = FMOD_Studio_EventDescription_GetParameterLabelByID(owner, id, i, buffer, sizeof(buffer), NULL);
+        } else {
+            result = FMOD_Studio_System_GetParameterLabelByID(system, id, i, buffer, sizeof(buffer), NULL);
+        }
+
+        if (result == FMOD_ERR_TRUNCATED) {
+            continue;
+        } else if (result != FMOD_OK) {
+            return result;
+        }
+
+        if (strcmp(buffer, label) == 0) {
+            *labelValue = (float)i;
+            return FMOD_OK;
+        }
+    }
+}
+
+int parameterCacheLookup(lua_State *L, FMOD_STUDIO_SYSTEM *system, FMOD_STUDIO_EVENTDESCRIPTION *description,
+    int nameIndex, int labelIndex, FMOD_STUDIO_PARAMETER_ID *id, float *labelValue)
+{
+    ParameterCache *cache = cacheGet(L);
+    const void *owner = description ? (const void*)description : (const void*)system;
+
+    /* Only actual strings are interned; converted numbers get a new address each time */
+    if (lua_type(L, nameIndex) != LUA_TSTRING || (labelIndex && lua_type(L, labelIndex) != LUA_TSTRING)) {
+        cache->uncached++;
+        return 0;
+    }
+
+    const char *name = lua_tostring(L, nameIndex);
+    const char *label = labelIndex ? lua_tostring(L, labelIndex) : NULL;
+
+    CacheEntry resolved = { owner, name, label, { 0, 0 }, 0 };
+    unsigned int hash = keyHash(&resolved);
+    CacheEntry *entry = hashTableFind(&cache->entries, &sEntryType, hash, &resolved);
+
+    if (entry) {
+        cache->hits++;
+
+        *id = entry->id;
+        *labelValue = entry->labelValue;
+
+        return 1;
+    }
+
+    cache->misses++;
+
+    /* Leave errors such as unknown names to the name-based call */
+    if (resolveID(system, description, name, &resolved.id) != FMOD_OK) {
+        return 0;
+    }
+
+    if (label && resolveLabel(system, description, resolved.id, label, &resolved.labelValue) != FMOD_OK) {
+        return 0;
+    }
+
+    if (cache->entries.count >= MAX_ENTRIES) {
+        clearCache(L, cache);
+    }
+
+    anchorString(L, nameIndex);
+
+    if (labelIndex) {
+        anchorString(L, labelIndex);
+    }
+
+    entry = hashTableInsert(&cache->entries, &sEntryType, hash);
+
+    if (!entry) {
+        return 0;
+    }
+
+    *entry = resolved;
+
+    *id = resolved.id;
+    *labelValue = resolved.labelValue;
+
+    return 1;
+}
+
+void parameterCacheForget(lua_State *L, FMOD_STUDIO_SYSTEM *system, FMOD_STUDIO_EVENTDESCRIPTION *description,
+    int nameIndex, int labelIndex)
+{
+    ParameterCache *cache = cacheGet(L);
+    const void *owner = description ? (const void*)description : (const void*)system;
+
+    const char *name = lua_tostring(L, nameIndex);
+    const char *label = labelIndex ? lua_tostring(L, labelIndex) : NULL;
+
+    CacheEntry key = { owner, name, label, { 0, 0 }, 0 };
+    CacheEntry *entry = hashTableFind(&cache->entries, &sEntryType, keyHash(&key), &key);
+
+    if (entry) {
+        hashTableRemove(&cache->entries, &sEntryType, entry);
+    }
+}
+
+int ParameterCache_GetStats(lua_State *L)
+{
+    ParameterCache *cache = cacheGet(L);
+
+    lua_createtable(L, 0, 4);
+
+    lua_pushinteger(L, cache->entries.count);
+    lua_setfield(L, -2, "entries");
+
+    lua_pushnumber(L, cache->hits);
+    lua_setfield(L, -2, "hits");
+
+    lua_pushnumber(L, cache->misses);
+    lua_setfield(L, -2, "misses");
+
+    lua_pushnumber(L, cache->uncached);
+    lua_setfield(L, -2, "uncached");
+
+    return 1;
+}
+
+int ParameterCache_Clear(lua_State *L)
+{
+    clearCache(L, cacheGet(L));
+
+    return 0;
+}
@@ -0,0 +1,31 @@
+#ifndef PARAMETERCACHE_H
+#define PARAMETERCACHE_H
+
+#include <fmod_studio.h>
+#include <lauxlib.h>
+
+typedef struct ParameterCache ParameterCache;
+
+/* Resolves the parameter named by the string at nameIndex, and the label at
+   labelIndex if it is not 0, to an ID and label value. Pass an event description
+   for event parameters, or a NULL description and the system for global ones.
+   Returns 0 if the name can't be cached, in which case the caller should use the
+   name-based call.
+*/
+int parameterCacheLookup(lua_State *L, FMOD_STUDIO_SYSTEM *system, FMOD_STUDIO_EVENTDESCRIPTION *description,
+    int nameIndex, int labelIndex, FMOD_STUDIO_PARAMETER_ID *id, float *labelValue);
+
+/* True if an ID-based call failed because the cached ID is out of date */
+#define PARAMETER_CACHE_STALE(result) ((result) == FMOD_ERR_EVENT_NOTFOUND || (result) == FMOD_ERR_INVALID_HANDLE)
+
+/* Drops a cached entry whose ID was rejected, e.g. after its bank was unloaded */
+void parameterCacheForget(lua_State *L, FMOD_STUDIO_SYSTEM *system, FMOD_STUDIO_EVENTDESCRIPTION *description,
+    int nameIndex, int labelIndex);
+
+/* FMOD.ParameterCache_GetStats() */
+int ParameterCache_GetStats(lua_State *L);
+
+/* FMOD.ParameterCache_Clear() */
+int ParameterCache_Clear(lua_State *L);
+
+#endif /* PARAMETERCACHE_H */
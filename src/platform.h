@@ -11,6 +11,30 @@ void criticalSectionRelease(LUAFMOD_CRITICAL_SECTION *criticalSection);
 void criticalSectionEnter(LUAFMOD_CRITICAL_SECTION *criticalSection);
 void criticalSectionLeave(LUAFMOD_CRITICAL_SECTION *criticalSection);
 
+typedef struct LUAFMOD_THREAD LUAFMOD_THREAD;
+typedef void (*LUAFMOD_THREAD_FUNCTION)(void *userdata);
+
+/* Returns NULL if the thread couldn't be started */
+LUAFMOD_THREAD *threadCreate(LUAFMOD_THREAD_FUNCTION function, void *userdata);
+
+/* Waits for the thread to finish and frees it */
+void threadJoin(LUAFMOD_THREAD *thread);
+
+/* Monotonic time in seconds */
+double platformGetTime();
+
+void platformSleep(double seconds);
+
+/* Atomically adds delta to *value and returns the new value */
+long atomicAdd(volatile long *value, long delta);
+long long atomicAdd64(volatile long long *value, long long delta);
+
+#ifdef _MSC_VER
+    #define LUAFMOD_THREAD_LOCAL __declspec(thread)
+#else
+    #define LUAFMOD_THREAD_LOCAL __thread
+#endif
+
 #ifdef LUAFMOD_DYNAMIC
     #ifdef _WIN32
         #define LUAFMOD_EXPORT __declspec(dllexport)
@@ -2,6 +2,8 @@
 
 #include <lauxlib.h>
 #include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
 
 #include "../platform.h"
 
@@ -61,4 +63,70 @@ void criticalSectionLeave(LUAFMOD_CRITICAL_SECTION *criticalSection)
     CHECK(pthread_mutex_unlock(mutex));
 }
 
+struct LUAFMOD_THREAD {
+    pthread_t thread;
+    LUAFMOD_THREAD_FUNCTION function;
+    void *userdata;
+};
+
+static void *threadMain(void *argument)
+{
+    LUAFMOD_THREAD *thread = argument;
+    thread->function(thread->userdata);
+
+    return NULL;
+}
+
+LUAFMOD_THREAD *threadCreate(LUAFMOD_THREAD_FUNCTION function, void *userdata)
+{
+    LUAFMOD_THREAD *thread = malloc(sizeof(*thread));
+
+    if (!thread) {
+        return NULL;
+    }
+
+    thread->function = function;
+    thread->userdata = userdata;
+
+    if (pthread_create(&thread->thread, NULL, threadMain, thread) != 0) {
+        free(thread);
+        return NULL;
+    }
+
+    return thread;
+}
+
+void threadJoin(LUAFMOD_THREAD *thread)
+{
+    pthread_join(thread->thread, NULL);
+    free(thread);
+}
+
+double platformGetTime()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+void platformSleep(double seconds)
+{
+    struct timespec duration;
+    duration.tv_sec = (time_t)seconds;
+    duration.tv_nsec = (long)((seconds - (double)duration.tv_sec) * 1e9);
+
+    nanosleep(&duration, NULL);
+}
+
+long atomicAdd(volatile long *value, long delta)
+{
+    return __sync_add_and_fetch(value, delta);
+}
+
+long long atomicAdd64(volatile long long *value, long long delta)
+{
+    return __sync_add_and_fetch(value, delta);
+}
+
 #endif /* __linux__ */
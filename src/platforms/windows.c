@@ -116,4 +116,71 @@ void criticalSectionLeave(LUAFMOD_CRITICAL_SECTION *criticalSection)
     LeaveCriticalSection(c);
 }
 
+struct LUAFMOD_THREAD {
+    HANDLE handle;
+    LUAFMOD_THREAD_FUNCTION function;
+    void *userdata;
+};
+
+static DWORD WINAPI threadMain(LPVOID argument)
+{
+    LUAFMOD_THREAD *thread = argument;
+    thread->function(thread->userdata);
+
+    return 0;
+}
+
+LUAFMOD_THREAD *threadCreate(LUAFMOD_THREAD_FUNCTION function, void *userdata)
+{
+    LUAFMOD_THREAD *thread = malloc(sizeof(*thread));
+
+    if (!thread) {
+        return NULL;
+    }
+
+    thread->function = function;
+    thread->userdata = userdata;
+    thread->handle = CreateThread(NULL, 0, threadMain, thread, 0, NULL);
+
+    if (!thread->handle) {
+        free(thread);
+        return NULL;
+    }
+
+    return thread;
+}
+
+void threadJoin(LUAFMOD_THREAD *thread)
+{
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    free(thread);
+}
+
+double platformGetTime()
+{
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+
+void platformSleep(double seconds)
+{
+    Sleep((DWORD)(seconds * 1000));
+}
+
+long atomicAdd(volatile long *value, long delta)
+{
+    return InterlockedExchangeAdd(value, delta) + delta;
+}
+
+long long atomicAdd64(volatile long long *value, long long delta)
+{
+    return InterlockedExchangeAdd64(value, delta) + delta;
+}
+
 #endif /* WIN32 */
@@ -0,0 +1,1152 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "hashtable.h"
+#include "context.h"
+#include "platform.h"
+#include "programmersounds.h"
+
+/* Answers CREATE_PROGRAMMER_SOUND and DESTROY_PROGRAMMER_SOUND natively, so
+   dialogue never runs Lua on FMOD threads. The audio table key for a programmer
+   instrument is the key set for the instance with setKey, else the key mapped
+   from the instrument name with map, else the instrument name itself. Sounds are
+   created from Studio.System:getSoundInfo results, shared between instances
+   using the same key and released when the last one is done with them.
+
+   With setRetain, unused sounds stay open as a least recently used cache within
+   a byte budget, and prefetch opens upcoming lines ahead of time (with the
+   default NONBLOCKING mode) so they are ready when they are needed. Sizes come
+   from the audio table entry's length in its bank. Open states are polled from
+   Studio.System:update to measure open latency.
+
+   Unused sounds sit in a least recently used list, so eviction takes them from
+   its tail. Map slots move when others are removed, so each cached sound has a
+   list node of its own that records its key. Instances and acquire hold separate
+   counts, so relinquish can't drop a reference an instance holds.
+
+   A stream can only play once at a time, so an instance that needs a stream
+   another is using opens one of its own, released when it is done with it, and
+   acquire refuses a stream in use.
+
+   The resolver is found through the FMOD userdata of the instance or its
+   description, which is why attaching replaces any Lua callback on the target.
+   Instances created from an attached description take the resolver as their
+   userdata, and it counts every instance it is set on. Callbacks keep arriving
+   from those until they are destroyed, so release (or __gc) detaches it from
+   descriptions and drops its cached sounds, and the resolver is freed when the
+   last counted instance is destroyed.
+*/
+
+#define RESOLVER_MAGIC 0x50534E44u
+#define MIN_MAP_SIZE 16
+
+typedef struct LruNode {
+    struct LruNode *previous;
+    struct LruNode *next;
+    int linked;
+
+    /* The sound's key, owned by its map slot */
+    unsigned int hash;
+    const char *key;
+} LruNode;
+
+typedef struct MapSlot {
+    unsigned int hash;
+    const void *pointerKey;
+    char *stringKey;
+
+    /* Key mappings */
+    char *value;
+
+    /* Cached sounds */
+    FMOD_SOUND *sound;
+    int subsoundIndex;
+    int references;
+    int acquired;
+    unsigned int bytes;
+    double openStart;
+    int ready;
+    int failed;
+    int prefetched;
+    int stream;
+    LruNode *lru;
+} MapSlot;
+
+/* Maps are HashTables of MapSlots, keyed by string or by pointer */
+typedef HashTable Map;
+
+#define MAP_SLOT(map, i) HASH_SLOT_AT(map, MapSlot, i)
+
+struct luaFMOD_ProgrammerSoundResolver {
+    unsigned int magic;
+    int released;
+
+    LUAFMOD_CRITICAL_SECTION *lock;
+
+    FMOD_STUDIO_SYSTEM *system;
+    FMOD_SYSTEM *core;
+    FMOD_MODE mode;
+    int retain;
+    double budget;
+    double residentBytes;
+
+    /* Instrument name -> audio table key */
+    Map names;
+
+    /* Instance -> audio table key */
+    Map instances;
+
+    /* Audio table key -> sound */
+    Map sounds;
+
+    /* Attached descriptions, detached on release */
+    Map descriptions;
+
+    /* Instances with the resolver as their userdata */
+    int liveInstances;
+
+    /* Unused sounds, most recently used first */
+    LruNode *lruHead;
+    LruNode *lruTail;
+
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int created;
+    unsigned int prefetches;
+    unsigned int evictions;
+    unsigned int releasedSounds;
+    unsigned int failures;
+    unsigned int opened;
+    double openLatencyTotal;
+    double openLatencyMax;
+    FMOD_RESULT lastError;
+
+    luaFMOD_ProgrammerSoundResolver *next;
+};
+
+#define SELF_TYPE luaFMOD_ProgrammerSoundResolver
+
+/* The userdata boxes a pointer to the resolver, which is NULL once released */
+#undef GET_SELF
+#define GET_SELF \
+    SELF_TYPE *self = CHECK_HANDLE(L, 1, SELF_TYPE); \
+    if (!self) return luaL_error(L, "resolver has been released")
+
+static char *copyString(const char *string)
+{
+    size_t length = strlen(string) + 1;
+    char *copy = malloc(length);
+
+    if (copy) {
+        memcpy(copy, string, length);
+    }
+
+    return copy;
+}
+
+/* FNV-1a */
+static unsigned int stringHash(const char *string)
+{
+    unsigned int hash = 2166136261u;
+
+    for (; *string; ++string) {
+        hash = (hash ^ (unsigned char)*string) * 16777619u;
+    }
+
+    return hash;
+}
+
+static int slotUsed(const void *slot)
+{
+    return ((const MapSlot*)slot)->stringKey || ((const MapSlot*)slot)->pointerKey;
+}
+
+static unsigned int slotHash(const void *slot)
+{
+    return ((const MapSlot*)slot)->hash;
+}
+
+static int stringKeyMatches(const void *slot, const void *key)
+{
+    return strcmp(((const MapSlot*)slot)->stringKey, key) == 0;
+}
+
+static int pointerKeyMatches(const void *slot, const void *key)
+{
+    return ((const MapSlot*)slot)->pointerKey == key;
+}
+
+static const HashTableType sStringMap = { sizeof(MapSlot), MIN_MAP_SIZE, slotUsed, slotHash, stringKeyMatches };
+static const HashTableType sPointerMap = { sizeof(MapSlot), MIN_MAP_SIZE, slotUsed, slotHash, pointerKeyMatches };
+
+static MapSlot *mapFind(Map *map, unsigned int hash, const void *pointerKey, const char *stringKey)
+{
+    return stringKey
+        ? hashTableFind(map, &sStringMap, hash, stringKey)
+        : hashTableFind(map, &sPointerMap, hash, pointerKey);
+}
+
+/* Returns the slot for the key, adding an empty one (with the key copied) if needed */
+static MapSlot *mapInsert(Map *map, unsigned int hash, const void *pointerKey, const char *stringKey)
+{
+    MapSlot *slot = mapFind(map, hash, pointerKey, stringKey);
+
+    if (slot) {
+        return slot;
+    }
+
+    char *keyCopy = NULL;
+
+    if (stringKey && !(keyCopy = copyString(stringKey))) {
+        return NULL;
+    }
+
+    slot = hashTableInsert(map, stringKey ? &sStringMap : &sPointerMap, hash);
+
+    if (!slot) {
+        free(keyCopy);
+        return NULL;
+    }
+
+    slot->hash = hash;
+    slot->pointerKey = stringKey ? NULL : pointerKey;
+    slot->stringKey = keyCopy;
+
+    return slot;
+}
+
+/* Frees the slot's strings and removes it; a later slot may move into its place */
+static void mapRemove(Map *map, MapSlot *removed)
+{
+    free(removed->stringKey);
+    free(removed->value);
+
+    hashTableRemove(map, removed->pointerKey ? &sPointerMap : &sStringMap, removed);
+}
+
+static void mapClear(Map *map)
+{
+    for (unsigned int i = 0; i < map->size; ++i) {
+        free(MAP_SLOT(*map, i)->stringKey);
+        free(MAP_SLOT(*map, i)->value);
+    }
+
+    hashTableFree(map);
+}
+
+/* Sets the value of a key mapping, or removes the mapping if value is NULL */
+static int setMapping(Map *map, unsigned int hash, const void *pointerKey, const char *stringKey, const char *value)
+{
+    if (!value) {
+        MapSlot *slot = mapFind(map, hash, pointerKey, stringKey);
+
+        if (slot) {
+            mapRemove(map, slot);
+        }
+
+        return 1;
+    }
+
+    char *valueCopy = copyString(value);
+    MapSlot *slot = valueCopy ? mapInsert(map, hash, pointerKey, stringKey) : NULL;
+
+    if (!slot) {
+        free(valueCopy);
+        return 0;
+    }
+
+    free(slot->value);
+    slot->value = valueCopy;
+
+    return 1;
+}
+
+static const char *resolveKey(luaFMOD_ProgrammerSoundResolver *resolver, FMOD_STUDIO_EVENTINSTANCE *event,
+    const char *name)
+{
+    MapSlot *slot = mapFind(&resolver->instances, hashPointer(event), event, NULL);
+
+    if (slot) {
+        return slot->value;
+    }
+
+    slot = mapFind(&resolver->names, stringHash(name), NULL, name);
+
+    return slot ? slot->value : name;
+}
+
+static int slotInUse(const MapSlot *slot)
+{
+    return slot->references > 0 || slot->acquired > 0;
+}
+
+static void lruUnlink(luaFMOD_ProgrammerSoundResolver *resolver, LruNode *node)
+{
+    if (!node->linked) {
+        return;
+    }
+
+    if (node->previous) {
+        node->previous->next = node->next;
+    } else {
+        resolver->lruHead = node->next;
+    }
+
+    if (node->next) {
+        node->next->previous = node->previous;
+    } else {
+        resolver->lruTail = node->previous;
+    }
+
+    node->previous = NULL;
+    node->next = NULL;
+    node->linked = 0;
+}
+
+/* Moves an unused sound to the front of the list, or takes a used one off it */
+static void lruTouch(luaFMOD_ProgrammerSoundResolver *resolver, MapSlot *slot)
+{
+    LruNode *node = slot->lru;
+
+    lruUnlink(resolver, node);
+
+    if (slotInUse(slot)) {
+        return;
+    }
+
+    node->next = resolver->lruHead;
+
+    if (resolver->lruHead) {
+        resolver->lruHead->previous = node;
+    } else {
+        resolver->lruTail = node;
+    }
+
+    resolver->lruHead = node;
+    node->linked = 1;
+}
+
+/* Creates the sound for key without caching it */
+static FMOD_SOUND *createSound(luaFMOD_ProgrammerSoundResolver *resolver, const char *key,
+    FMOD_STUDIO_SOUND_INFO *info)
+{
+    FMOD_SOUND *sound = NULL;
+    FMOD_RESULT result = FMOD_Studio_System_GetSoundInfo(resolver->system, key, info);
+
+    if (result == FMOD_OK) {
+        result = FMOD_System_CreateSound(resolver->core, info->name_or_data, info->mode | resolver->mode,
+            &info->exinfo, &sound);
+    }
+
+    if (result != FMOD_OK) {
+        resolver->failures++;
+        resolver->lastError = result;
+        return NULL;
+    }
+
+    resolver->created++;
+
+    return sound;
+}
+
+/* Opens the sound for key and adds it to the cache, unreferenced */
+static MapSlot *openSound(luaFMOD_ProgrammerSoundResolver *resolver, const char *key, unsigned int hash)
+{
+    FMOD_STUDIO_SOUND_INFO info;
+    double start = platformGetTime();
+    FMOD_SOUND *sound = createSound(resolver, key, &info);
+
+    if (!sound) {
+        return NULL;
+    }
+
+    LruNode *node = calloc(1, sizeof(*node));
+    MapSlot *slot = node ? mapInsert(&resolver->sounds, hash, NULL, key) : NULL;
+
+    if (!slot) {
+        free(node);
+        FMOD_Sound_Release(sound);
+        resolver->failures++;
+        resolver->lastError = FMOD_ERR_MEMORY;
+        return NULL;
+    }
+
+    node->hash = hash;
+    node->key = slot->stringKey;
+
+    slot->sound = sound;
+    slot->subsoundIndex = info.subsoundindex;
+    slot->references = 0;
+    slot->acquired = 0;
+    slot->bytes = info.exinfo.length;
+    slot->openStart = start;
+    slot->ready = 0;
+    slot->failed = 0;
+    slot->prefetched = 0;
+    slot->stream = ((info.mode | resolver->mode) & FMOD_CREATESTREAM) != 0;
+    slot->lru = node;
+
+    lruTouch(resolver, slot);
+
+    resolver->residentBytes += slot->bytes;
+
+    return slot;
+}
+
+static void releaseSound(luaFMOD_ProgrammerSoundResolver *resolver, FMOD_SOUND *sound)
+{
+    FMOD_RESULT result = FMOD_Sound_Release(sound);
+
+    if (result != FMOD_OK) {
+        resolver->lastError = result;
+    }
+
+    resolver->releasedSounds++;
+}
+
+static void removeSound(luaFMOD_ProgrammerSoundResolver *resolver, MapSlot *slot)
+{
+    releaseSound(resolver, slot->sound);
+
+    lruUnlink(resolver, slot->lru);
+    free(slot->lru);
+
+    resolver->residentBytes -= slot->bytes;
+    mapRemove(&resolver->sounds, slot);
+}
+
+/* Finds or opens the sound for key; the caller adds its reference. A sound that
+   failed to open is opened again once nothing uses it, and not handed out before.
+*/
+static MapSlot *findSound(luaFMOD_ProgrammerSoundResolver *resolver, const char *key)
+{
+    unsigned int hash = stringHash(key);
+    MapSlot *slot = mapFind(&resolver->sounds, hash, NULL, key);
+
+    if (slot && slot->failed) {
+        if (slotInUse(slot)) {
+            resolver->failures++;
+            return NULL;
+        }
+
+        removeSound(resolver, slot);
+        slot = NULL;
+    }
+
+    if (slot) {
+        resolver->hits++;
+    } else {
+        resolver->misses++;
+        slot = openSound(resolver, key, hash);
+
+        if (!slot) {
+            return NULL;
+        }
+    }
+
+    slot->prefetched = 0;
+
+    return slot;
+}
+
+static void createProgrammerSound(luaFMOD_ProgrammerSoundResolver *resolver, FMOD_STUDIO_EVENTINSTANCE *event,
+    FMOD_STUDIO_PROGRAMMER_SOUND_PROPERTIES *properties)
+{
+    const char *key = resolveKey(resolver, event, properties->name);
+    MapSlot *slot = findSound(resolver, key);
+
+    if (slot && slot->stream && slotInUse(slot)) {
+        /* Not cached, so destroyProgrammerSound releases it */
+        FMOD_STUDIO_SOUND_INFO info;
+
+        properties->sound = createSound(resolver, key, &info);
+        properties->subsoundIndex = info.subsoundindex;
+    } else if (slot) {
+        slot->references++;
+        lruTouch(resolver, slot);
+
+        properties->sound = slot->sound;
+        properties->subsoundIndex = slot->subsoundIndex;
+    }
+}
+
+/* Closes unused sounds, least recently used first, until the budget is met */
+static void enforceBudget(luaFMOD_ProgrammerSoundResolver *resolver)
+{
+    while (resolver->residentBytes > resolver->budget && resolver->lruTail) {
+        LruNode *oldest = resolver->lruTail;
+
+        removeSound(resolver, mapFind(&resolver->sounds, oldest->hash, NULL, oldest->key));
+        resolver->evictions++;
+    }
+}
+
+/* Called after a reference is dropped; releases or caches the sound if that was the last */
+static void releaseIfUnused(luaFMOD_ProgrammerSoundResolver *resolver, MapSlot *slot)
+{
+    if (slotInUse(slot)) {
+        return;
+    }
+
+    if (!resolver->retain || resolver->released || slot->failed) {
+        removeSound(resolver, slot);
+    } else {
+        lruTouch(resolver, slot);
+        enforceBudget(resolver);
+    }
+}
+
+static void destroyProgrammerSound(luaFMOD_ProgrammerSoundResolver *resolver, FMOD_STUDIO_EVENTINSTANCE *event,
+    FMOD_STUDIO_PROGRAMMER_SOUND_PROPERTIES *properties)
+{
+    if (!properties->sound) {
+        return;
+    }
+
+    const char *key = resolveKey(resolver, event, properties->name);
+    MapSlot *slot = mapFind(&resolver->sounds, stringHash(key), NULL, key);
+
+    /* The key may have changed since the sound was created */
+    if (slot && slot->sound != properties->sound) {
+        slot = NULL;
+    }
+
+    for (unsigned int i = 0; !slot && i < resolver->sounds.size; ++i) {
+        if (MAP_SLOT(resolver->sounds, i)->sound == properties->sound) {
+            slot = MAP_SLOT(resolver->sounds, i);
+        }
+    }
+
+    if (!slot) {
+        /* Created before a release or flush cleared the map */
+        releaseSound(resolver, properties->sound);
+        return;
+    }
+
+    if (slot->references > 0) {
+        slot->references--;
+        releaseIfUnused(resolver, slot);
+    }
+}
+
+/* Records sounds that have finished opening, and drops unused ones that failed;
+   failed ones still in use are flagged so they are dropped once they are unused */
+static void pollOpenStates(luaFMOD_ProgrammerSoundResolver *resolver, double now)
+{
+    for (unsigned int i = 0; i < resolver->sounds.size; ++i) {
+        MapSlot *slot = MAP_SLOT(resolver->sounds, i);
+
+        if (!slotUsed(slot) || slot->ready) {
+            continue;
+        }
+
+        FMOD_OPENSTATE state = FMOD_OPENSTATE_LOADING;
+        FMOD_RESULT result = FMOD_Sound_GetOpenState(slot->sound, &state, NULL, NULL, NULL);
+
+        if (result != FMOD_OK || state == FMOD_OPENSTATE_ERROR) {
+            resolver->failures++;
+            resolver->lastError = result != FMOD_OK ? result : FMOD_ERR_FILE_BAD;
+            slot->ready = 1;
+            slot->failed = 1;
+
+            if (!slotInUse(slot)) {
+                removeSound(resolver, slot);
+
+                /* Removal may shift a later slot into this one, so check it again */
+                --i;
+            }
+        } else if (state == FMOD_OPENSTATE_READY) {
+            double latency = now - slot->openStart;
+
+            resolver->opened++;
+            resolver->openLatencyTotal += latency;
+
+            if (latency > resolver->openLatencyMax) {
+                resolver->openLatencyMax = latency;
+            }
+
+            slot->ready = 1;
+        }
+    }
+}
+
+void programmerSoundsUpdateAll(lua_State *L)
+{
+    double now = platformGetTime();
+
+    for (luaFMOD_ProgrammerSoundResolver *resolver = contextGet(L)->programmerSoundResolvers; resolver;
+        resolver = resolver->next) {
+        criticalSectionEnter(resolver->lock);
+        pollOpenStates(resolver, now);
+        criticalSectionLeave(resolver->lock);
+    }
+}
+
+/* Frees a released resolver once no instance can call back into it */
+static void freeResolver(luaFMOD_ProgrammerSoundResolver *resolver)
+{
+    for (unsigned int i = 0; i < resolver->sounds.size; ++i) {
+        MapSlot *slot = MAP_SLOT(resolver->sounds, i);
+
+        if (slotUsed(slot)) {
+            FMOD_Sound_Release(slot->sound);
+            free(slot->lru);
+        }
+    }
+
+    mapClear(&resolver->sounds);
+    mapClear(&resolver->descriptions);
+    criticalSectionRelease(resolver->lock);
+    free(resolver);
+}
+
+static luaFMOD_ProgrammerSoundResolver *findResolver(FMOD_STUDIO_EVENTINSTANCE *event)
+{
+    luaFMOD_ProgrammerSoundResolver *resolver = NULL;
+
+    if (FMOD_Studio_EventInstance_GetUserData(event, (void**)&resolver) == FMOD_OK
+        && resolver && resolver->magic == RESOLVER_MAGIC) {
+        return resolver;
+    }
+
+    FMOD_STUDIO_EVENTDESCRIPTION *description = NULL;
+
+    if (FMOD_Studio_EventInstance_GetDescription(event, &description) == FMOD_OK
+        && FMOD_Studio_EventDescription_GetUserData(description, (void**)&resolver) == FMOD_OK
+        && resolver && resolver->magic == RESOLVER_MAGIC) {
+        return resolver;
+    }
+
+    return NULL;
+}
+
+static FMOD_RESULT F_CALLBACK programmerSoundCallback(FMOD_STUDIO_EVENT_CALLBACK_TYPE type,
+    FMOD_STUDIO_EVENTINSTANCE *event, void *parameters)
+{
+    luaFMOD_ProgrammerSoundResolver *resolver = findResolver(event);
+
+    if (!resolver) {
+        return FMOD_OK;
+    }
+
+    void *userdata = NULL;
+    FMOD_Studio_EventInstance_GetUserData(event, &userdata);
+
+    criticalSectionEnter(resolver->lock);
+
+    if (type == FMOD_STUDIO_EVENT_CALLBACK_CREATED && !resolver->released) {
+        if (!userdata && FMOD_Studio_EventInstance_SetUserData(event, resolver) == FMOD_OK) {
+            resolver->liveInstances++;
+        }
+    } else if (type == FMOD_STUDIO_EVENT_CALLBACK_CREATE_PROGRAMMER_SOUND && !resolver->released) {
+        createProgrammerSound(resolver, event, parameters);
+    } else if (type == FMOD_STUDIO_EVENT_CALLBACK_DESTROY_PROGRAMMER_SOUND) {
+        destroyProgrammerSound(resolver, event, parameters);
+    } else if (type == FMOD_STUDIO_EVENT_CALLBACK_DESTROYED) {
+        setMapping(&resolver->instances, hashPointer(event), event, NULL, NULL);
+
+        if (userdata == resolver) {
+            resolver->liveInstances--;
+        }
+    }
+
+    int unused = resolver->released && resolver->liveInstances == 0;
+
+    criticalSectionLeave(resolver->lock);
+
+    if (unused && type == FMOD_STUDIO_EVENT_CALLBACK_DESTROYED) {
+        freeResolver(resolver);
+    }
+
+    return FMOD_OK;
+}
+
+int programmerSoundResolverCreate(lua_State *L, FMOD_STUDIO_SYSTEM *system, FMOD_MODE mode)
+{
+    FMOD_SYSTEM *core = NULL;
+    RETURN_IF_ERROR(FMOD_Studio_System_GetCoreSystem(system, &core));
+
+    luaFMOD_ProgrammerSoundResolver *resolver = calloc(1, sizeof(*resolver));
+
+    if (!resolver) {
+        return luaL_error(L, "out of memory");
+    }
+
+    resolver->lock = criticalSectionCreate();
+
+    if (!resolver->lock) {
+        free(resolver);
+        return luaL_error(L, "out of memory");
+    }
+
+    resolver->magic = RESOLVER_MAGIC;
+    resolver->system = system;
+    resolver->core = core;
+    resolver->mode = mode;
+    resolver->budget = DBL_MAX;
+    resolver->lastError = FMOD_OK;
+
+    luaFMOD_ProgrammerSoundResolver **box = lua_newuserdata(L, sizeof(*box));
+    *box = resolver;
+    luaL_getmetatable(L, "luaFMOD_ProgrammerSoundResolver");
+    lua_setmetatable(L, -2);
+
+    luaFMOD_Context *context = contextGet(L);
+    resolver->next = context->programmerSoundResolvers;
+    context->programmerSoundResolvers = resolver;
+
+    return 1;
+}
+
+static void releaseUnusedSounds(luaFMOD_ProgrammerSoundResolver *resolver)
+{
+    for (unsigned int i = 0; i < resolver->sounds.size;) {
+        MapSlot *slot = MAP_SLOT(resolver->sounds, i);
+
+        if (slotUsed(slot) && !slotInUse(slot)) {
+            /* Removal may shift a later slot into this one, so check it again */
+            removeSound(resolver, slot);
+        } else {
+            ++i;
+        }
+    }
+}
+
+static void releaseResolver(luaFMOD_ProgrammerSoundResolver *resolver)
+{
+    /* Only Lua touches the descriptions, and FMOD may be waiting on the lock in a
+       callback while these calls run, so they are made before taking it */
+    for (unsigned int i = 0; i < resolver->descriptions.size; ++i) {
+        FMOD_STUDIO_EVENTDESCRIPTION *description = (void*)MAP_SLOT(resolver->descriptions, i)->pointerKey;
+        void *userdata = NULL;
+
+        if (description && FMOD_Studio_EventDescription_GetUserData(description, &userdata) == FMOD_OK
+            && userdata == resolver) {
+            FMOD_Studio_EventDescription_SetCallback(description, NULL, 0);
+            FMOD_Studio_EventDescription_SetUserData(description, NULL);
+        }
+    }
+
+    criticalSectionEnter(resolver->lock);
+
+    resolver->released = 1;
+
+    for (unsigned int i = 0; i < resolver->sounds.size; ++i) {
+        MAP_SLOT(resolver->sounds, i)->acquired = 0;
+    }
+
+    releaseUnusedSounds(resolver);
+    mapClear(&resolver->names);
+    mapClear(&resolver->instances);
+
+    int unused = resolver->liveInstances == 0;
+
+    criticalSectionLeave(resolver->lock);
+
+    if (unused) {
+        freeResolver(resolver);
+    }
+}
+
+static int METHOD_NAME(__gc)(lua_State *L)
+{
+    SELF_TYPE **box = (SELF_TYPE**)luaL_checkudata(L, 1, STRINGIZE(SELF_TYPE));
+    SELF_TYPE *self = *box;
+
+    if (!self) {
+        return 0;
+    }
+
+    *box = NULL;
+
+    for (luaFMOD_ProgrammerSoundResolver **link = &contextGet(L)->programmerSoundResolvers; *link;
+        link = &(*link)->next) {
+        if (*link == self) {
+            *link = self->next;
+            break;
+        }
+    }
+
+    releaseResolver(self);
+
+    return 0;
+}
+
+/* release()
+   Releases the cached sounds, including acquired ones, and stops resolving.
+   Sounds still in use are released when their instances are done with them.
+*/
+static int METHOD_NAME(release)(lua_State *L)
+{
+    return METHOD_NAME(__gc)(L);
+}
+
+/* attach(target)
+   Resolves programmer sounds for an EventInstance, or for every instance of an
+   EventDescription. This uses the target's callback and FMOD userdata, so it
+   replaces any callback set from Lua.
+*/
+static int METHOD_NAME(attach)(lua_State *L)
+{
+    GET_SELF;
+
+    FMOD_STUDIO_EVENT_CALLBACK_TYPE mask = FMOD_STUDIO_EVENT_CALLBACK_CREATED
+        | FMOD_STUDIO_EVENT_CALLBACK_CREATE_PROGRAMMER_SOUND
+        | FMOD_STUDIO_EVENT_CALLBACK_DESTROY_PROGRAMMER_SOUND | FMOD_STUDIO_EVENT_CALLBACK_DESTROYED;
+
+    if (hasMetatable(L, 2, "FMOD_STUDIO_EVENTDESCRIPTION")) {
+        FMOD_STUDIO_EVENTDESCRIPTION *description = CHECK_HANDLE(L, 2, FMOD_STUDIO_EVENTDESCRIPTION);
+
+        if (!mapInsert(&self->descriptions, hashPointer(description), description, NULL)) {
+            return luaL_error(L, "out of memory");
+        }
+
+        RETURN_IF_ERROR(FMOD_Studio_EventDescription_SetUserData(description, self));
+        RETURN_STATUS(FMOD_Studio_EventDescription_SetCallback(description, programmerSoundCallback, mask));
+    }
+
+    FMOD_STUDIO_EVENTINSTANCE *instance = CHECK_HANDLE(L, 2, FMOD_STUDIO_EVENTINSTANCE);
+    void *userdata = NULL;
+
+    RETURN_IF_ERROR(FMOD_Studio_EventInstance_GetUserData(instance, &userdata));
+
+    if (userdata != self) {
+        RETURN_IF_ERROR(FMOD_Studio_EventInstance_SetUserData(instance, self));
+
+        criticalSectionEnter(self->lock);
+        self->liveInstances++;
+        criticalSectionLeave(self->lock);
+    }
+
+    RETURN_STATUS(FMOD_Studio_EventInstance_SetCallback(instance, programmerSoundCallback, mask));
+}
+
+/* map(name, key)
+   Programmer instruments called name play the audio table entry key. A nil key
+   removes the mapping.
+*/
+static int METHOD_NAME(map)(lua_State *L)
+{
+    GET_SELF;
+
+    const char *name = luaL_checkstring(L, 2);
+    const char *key = luaL_optstring(L, 3, NULL);
+
+    criticalSectionEnter(self->lock);
+    int success = setMapping(&self->names, stringHash(name), NULL, name, key);
+    criticalSectionLeave(self->lock);
+
+    if (!success) {
+        return luaL_error(L, "out of memory");
+    }
+
+    return 0;
+}
+
+/* setKey(instance, key)
+   Programmer instruments in instance play the audio table entry key, whatever
+   their name. A nil key removes the override; it is also removed when the
+   instance is destroyed.
+*/
+static int METHOD_NAME(setKey)(lua_State *L)
+{
+    GET_SELF;
+
+    FMOD_STUDIO_EVENTINSTANCE *instance = CHECK_HANDLE(L, 2, FMOD_STUDIO_EVENTINSTANCE);
+    const char *key = luaL_optstring(L, 3, NULL);
+
+    criticalSectionEnter(self->lock);
+    int success = setMapping(&self->instances, hashPointer(instance), instance, NULL, key);
+    criticalSectionLeave(self->lock);
+
+    if (!success) {
+        return luaL_error(L, "out of memory");
+    }
+
+    return 0;
+}
+
+/* setRetain(retain, [budget])
+   If retain is true, sounds are kept after their last use so that later lines
+   with the same key don't load them again. Unused sounds are released least
+   recently used first while more than budget bytes are open (unlimited if nil).
+   flush releases them all.
+*/
+static int METHOD_NAME(setRetain)(lua_State *L)
+{
+    GET_SELF;
+
+    double budget = luaL_optnumber(L, 3, DBL_MAX);
+
+    criticalSectionEnter(self->lock);
+
+    self->retain = lua_toboolean(L, 2);
+    self->budget = budget;
+
+    if (!self->retain) {
+        releaseUnusedSounds(self);
+    } else {
+        enforceBudget(self);
+    }
+
+    criticalSectionLeave(self->lock);
+
+    return 0;
+}
+
+/* prefetch(keys)
+   Opens the sounds for an audio table key, or an array of keys, that are not
+   already open, so that they are ready when they are played. Prefetched sounds
+   are kept until their first use even without setRetain, but count against the
+   budget. Returns the number of sounds opened.
+*/
+static int METHOD_NAME(prefetch)(lua_State *L)
+{
+    GET_SELF;
+
+    int count = lua_istable(L, 2) ? (int)lua_objlen(L, 2) : 1;
+    int opened = 0;
+
+    if (!lua_istable(L, 2)) {
+        luaL_checkstring(L, 2);
+    }
+
+    for (int i = 1; i <= count; ++i) {
+        if (lua_istable(L, 2)) {
+            lua_rawgeti(L, 2, i);
+        } else {
+            lua_pushvalue(L, 2);
+        }
+
+        const char *key = lua_tostring(L, -1);
+
+        if (!key) {
+            return luaL_error(L, "keys[%d] is not a string", i);
+        }
+
+        unsigned int hash = stringHash(key);
+
+        criticalSectionEnter(self->lock);
+
+        MapSlot *slot = mapFind(&self->sounds, hash, NULL, key);
+
+        if (slot) {
+            lruTouch(self, slot);
+        } else if ((slot = openSound(self, key, hash)) != NULL) {
+            slot->prefetched = 1;
+            self->prefetches++;
+            opened++;
+        }
+
+        criticalSectionLeave(self->lock);
+
+        lua_pop(L, 1);
+    }
+
+    criticalSectionEnter(self->lock);
+    enforceBudget(self);
+    criticalSectionLeave(self->lock);
+
+    lua_pushinteger(L, opened);
+
+    return 1;
+}
+
+/* acquire(key)
+   Returns the cached Sound for an audio table key, opening it if needed, and
+   the index of its subsound, for playing lines without a programmer instrument.
+   The sound is shared with instances playing the same key and referenced until
+   relinquish(key) is called; with the default NONBLOCKING mode, getSubSound
+   fails with ERR_NOTREADY until it has opened. Raises an error if the sound is
+   a stream that is already in use.
+*/
+static int METHOD_NAME(acquire)(lua_State *L)
+{
+    GET_SELF;
+
+    const char *key = luaL_checkstring(L, 2);
+
+    criticalSectionEnter(self->lock);
+
+    MapSlot *slot = findSound(self, key);
+    int streamInUse = slot && slot->stream && slotInUse(slot);
+
+    if (slot && !streamInUse) {
+        slot->acquired++;
+        lruTouch(self, slot);
+    }
+
+    FMOD_RESULT result = self->lastError;
+    FMOD_SOUND *sound = slot ? slot->sound : NULL;
+    int subsoundIndex = slot ? slot->subsoundIndex : 0;
+
+    criticalSectionLeave(self->lock);
+
+    if (streamInUse) {
+        return luaL_error(L, "'%s' is a stream that is already in use", key);
+    }
+
+    if (!sound) {
+        RETURN_STATUS(result);
+    }
+
+    PUSH_HANDLE(L, FMOD_SOUND, sound);
+    lua_pushinteger(L, subsoundIndex);
+
+    return 2;
+}
+
+/* relinquish(key)
+   Drops a reference taken by acquire(key). Does nothing if key has no
+   outstanding acquire.
+*/
+static int METHOD_NAME(relinquish)(lua_State *L)
+{
+    GET_SELF;
+
+    const char *key = luaL_checkstring(L, 2);
+
+    criticalSectionEnter(self->lock);
+
+    MapSlot *slot = mapFind(&self->sounds, stringHash(key), NULL, key);
+
+    if (slot && slot->acquired > 0) {
+        slot->acquired--;
+        releaseIfUnused(self, slot);
+    }
+
+    criticalSectionLeave(self->lock);
+
+    return 0;
+}
+
+/* flush()
+   Releases retained sounds that no instance is using.
+*/
+static int METHOD_NAME(flush)(lua_State *L)
+{
+    GET_SELF;
+
+    criticalSectionEnter(self->lock);
+    releaseUnusedSounds(self);
+    criticalSectionLeave(self->lock);
+
+    return 0;
+}
+
+static int METHOD_NAME(getStats)(lua_State *L)
+{
+    GET_SELF;
+
+    criticalSectionEnter(self->lock);
+
+    int cached = 0;
+    int active = 0;
+    int pending = 0;
+
+    for (unsigned int i = 0; i < self->sounds.size; ++i) {
+        if (slotUsed(MAP_SLOT(self->sounds, i))) {
+            if (slotInUse(MAP_SLOT(self->sounds, i))) {
+                active++;
+            } else {
+                cached++;
+            }
+
+            if (!MAP_SLOT(self->sounds, i)->ready) {
+                pending++;
+            }
+        }
+    }
+
+    unsigned int lookups = self->hits + self->misses;
+
+    lua_createtable(L, 0, 17);
+
+    lua_pushinteger(L, active);
+    lua_setfield(L, -2, "active");
+
+    lua_pushinteger(L, cached);
+    lua_setfield(L, -2, "cached");
+
+    lua_pushnumber(L, self->created);
+    lua_setfield(L, -2, "created");
+
+    lua_pushinteger(L, pending);
+    lua_setfield(L, -2, "pending");
+
+    lua_pushnumber(L, self->hits);
+    lua_setfield(L, -2, "hits");
+
+    lua_pushnumber(L, self->misses);
+    lua_setfield(L, -2, "misses");
+
+    lua_pushnumber(L, lookups > 0 ? (double)self->hits / lookups : 0.0);
+    lua_setfield(L, -2, "hitRate");
+
+    lua_pushnumber(L, self->residentBytes);
+    lua_setfield(L, -2, "residentBytes");
+
+    lua_pushnumber(L, self->budget < DBL_MAX ? self->budget : -1);
+    lua_setfield(L, -2, "budget");
+
+    lua_pushnumber(L, self->prefetches);
+    lua_setfield(L, -2, "prefetches");
+
+    lua_pushnumber(L, self->evictions);
+    lua_setfield(L, -2, "evictions");
+
+    lua_pushnumber(L, self->opened > 0 ? self->openLatencyTotal / self->opened : 0.0);
+    lua_setfield(L, -2, "meanOpenLatency");
+
+    lua_pushnumber(L, self->openLatencyMax);
+    lua_setfield(L, -2, "maxOpenLatency");
+
+    lua_pushnumber(L, self->releasedSounds);
+    lua_setfield(L, -2, "released");
+
+    lua_pushnumber(L, self->failures);
+    lua_setfield(L, -2, "failures");
+
+    lua_pushinteger(L, self->lastError);
+    lua_setfield(L, -2, "lastError");
+
+    criticalSectionLeave(self->lock);
+
+    return 1;
+}
+
+METHODS_TABLE_BEGIN
+    METHODS_TABLE_ENTRY(__gc)
+    METHODS_TABLE_ENTRY(release)
+    METHODS_TABLE_ENTRY(attach)
+    METHODS_TABLE_ENTRY(map)
+    METHODS_TABLE_ENTRY(setKey)
+    METHODS_TABLE_ENTRY(setRetain)
+    METHODS_TABLE_ENTRY(prefetch)
+    METHODS_TABLE_ENTRY(acquire)
+    METHODS_TABLE_ENTRY(relinquish)
+    METHODS_TABLE_ENTRY(flush)
+    METHODS_TABLE_ENTRY(getStats)
+METHODS_TABLE_END
@@ -0,0 +1,14 @@
+#ifndef PROGRAMMERSOUNDS_H
+#define PROGRAMMERSOUNDS_H
+
+#include <fmod_studio.h>
+#include <lauxlib.h>
+
+typedef struct luaFMOD_ProgrammerSoundResolver luaFMOD_ProgrammerSoundResolver;
+
+int programmerSoundResolverCreate(lua_State *L, FMOD_STUDIO_SYSTEM *system, FMOD_MODE mode);
+
+/* Records open latency for prefetched and resolved sounds; called from Studio.System:update */
+void programmerSoundsUpdateAll(lua_State *L);
+
+#endif /* PROGRAMMERSOUNDS_H */
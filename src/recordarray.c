@@ -0,0 +1,84 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "recordarray.h"
+
+int recordArrayReserve(RecordArray *array, int required, size_t itemSize)
+{
+    if (required <= array->capacity) {
+        return 1;
+    }
+
+    int newCapacity = array->capacity ? array->capacity : 16;
+
+    while (newCapacity < required) {
+        newCapacity *= 2;
+    }
+
+    void *newItems = realloc(array->items, newCapacity * itemSize);
+
+    if (!newItems) {
+        return 0;
+    }
+
+    array->items = newItems;
+    array->capacity = newCapacity;
+
+    return 1;
+}
+
+void *recordArrayCheck(lua_State *L, const RecordArray *array, int index, size_t itemSize)
+{
+    int i = luaL_checkint(L, index);
+
+    luaL_argcheck(L, 1 <= i && i <= array->count, index, "record index out of range");
+
+    return (char*)array->items + (i - 1) * itemSize;
+}
+
+void recordArrayFree(RecordArray *array)
+{
+    free(array->items);
+
+    array->items = NULL;
+    array->count = 0;
+    array->capacity = 0;
+}
+
+void *recordArrayPushOwner(lua_State *L, const char *type, size_t size, int outIndex)
+{
+    void *owner = NULL;
+
+    if (lua_isnoneornil(L, outIndex)) {
+        owner = lua_newuserdata(L, size);
+        memset(owner, 0, size);
+
+        luaL_getmetatable(L, type);
+        lua_setmetatable(L, -2);
+    } else {
+        owner = luaL_checkudata(L, outIndex, type);
+        lua_pushvalue(L, outIndex);
+    }
+
+    return owner;
+}
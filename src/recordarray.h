@@ -0,0 +1,32 @@
+#ifndef RECORDARRAY_H
+#define RECORDARRAY_H
+
+#include <stddef.h>
+
+#include <lauxlib.h>
+
+/* A growable array of fixed-size records. It is kept between fills, so refilling
+   allocates nothing once the array has grown to size.
+*/
+typedef struct RecordArray {
+    void *items;
+    int count;
+    int capacity;
+} RecordArray;
+
+#define RECORD_AT(array, type, i) (((type*)(array).items) + (i))
+
+/* Grows the array to hold at least required records; returns 0 if out of memory */
+int recordArrayReserve(RecordArray *array, int required, size_t itemSize);
+
+/* Returns the record for the 1-based index argument, raising an error if out of range */
+void *recordArrayCheck(lua_State *L, const RecordArray *array, int index, size_t itemSize);
+
+void recordArrayFree(RecordArray *array);
+
+/* Pushes the userdata of the given type at outIndex, or a new zeroed one if
+   outIndex is nil, and returns it
+*/
+void *recordArrayPushOwner(lua_State *L, const char *type, size_t size, int outIndex);
+
+#endif /* RECORDARRAY_H */
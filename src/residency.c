@@ -0,0 +1,524 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+
+#include "common.h"
+#include "hashtable.h"
+#include "residency.h"
+
+/* Keeps event sample data resident within a byte budget. Each tracked description
+   has a caller supplied cost and sits in a least recently used list; touching it
+   (directly or through createInstance) moves it to the front and loads its sample
+   data if needed. When the resident total exceeds the budget, descriptions are
+   unloaded from the back of the list, skipping any that still have instances.
+   Descriptions are found by pointer through a HashTable of entry indices.
+
+   Releasing or collecting a manager unloads the sample data it loaded, even if
+   the descriptions still have instances.
+*/
+
+#define NO_ENTRY -1
+#define MIN_TABLE_SIZE 64
+
+typedef struct ResidencyEntry {
+    FMOD_STUDIO_EVENTDESCRIPTION *description;
+    double cost;
+    int resident;
+    int previous;
+    int next;
+} ResidencyEntry;
+
+typedef struct TableSlot {
+    const FMOD_STUDIO_EVENTDESCRIPTION *description;
+    int index;
+} TableSlot;
+
+struct luaFMOD_ResidencyManager {
+    double budget;
+    double residentBytes;
+
+    ResidencyEntry *entries;
+    int count;
+    int capacity;
+
+    HashTable table;
+
+    int head;
+    int tail;
+
+    double hits;
+    double misses;
+    double stalls;
+    double prefetches;
+    double evictions;
+    FMOD_RESULT lastError;
+
+    int released;
+};
+
+#define SELF_TYPE luaFMOD_ResidencyManager
+
+#undef GET_SELF
+#define GET_SELF GET_RELEASABLE_SELF("residency manager")
+
+static int slotUsed(const void *slot)
+{
+    return ((const TableSlot*)slot)->description != NULL;
+}
+
+static unsigned int slotHash(const void *slot)
+{
+    return hashPointer(((const TableSlot*)slot)->description);
+}
+
+static int slotMatches(const void *slot, const void *description)
+{
+    return ((const TableSlot*)slot)->description == description;
+}
+
+static const HashTableType sTableType = {
+    sizeof(TableSlot), MIN_TABLE_SIZE, slotUsed, slotHash, slotMatches
+};
+
+static void recordError(luaFMOD_ResidencyManager *manager, FMOD_RESULT result)
+{
+    if (result != FMOD_OK) {
+        manager->lastError = result;
+    }
+}
+
+static int findEntry(const luaFMOD_ResidencyManager *manager, const FMOD_STUDIO_EVENTDESCRIPTION *description)
+{
+    TableSlot *slot = hashTableFind(&manager->table, &sTableType, hashPointer(description), description);
+
+    return slot ? slot->index : NO_ENTRY;
+}
+
+/* Adds an entry for description to the table and the end of the entry array, uninitialized */
+static ResidencyEntry *addEntry(luaFMOD_ResidencyManager *manager, FMOD_STUDIO_EVENTDESCRIPTION *description)
+{
+    if (manager->count == manager->capacity) {
+        int capacity = manager->capacity ? manager->capacity * 2 : 32;
+        ResidencyEntry *entries = realloc(manager->entries, capacity * sizeof(ResidencyEntry));
+
+        if (!entries) {
+            return NULL;
+        }
+
+        manager->entries = entries;
+        manager->capacity = capacity;
+    }
+
+    TableSlot *slot = hashTableInsert(&manager->table, &sTableType, hashPointer(description));
+
+    if (!slot) {
+        return NULL;
+    }
+
+    slot->description = description;
+    slot->index = manager->count;
+
+    return &manager->entries[manager->count++];
+}
+
+static void listRemove(luaFMOD_ResidencyManager *manager, int index)
+{
+    ResidencyEntry *entry = &manager->entries[index];
+
+    if (entry->previous != NO_ENTRY) {
+        manager->entries[entry->previous].next = entry->next;
+    } else {
+        manager->head = entry->next;
+    }
+
+    if (entry->next != NO_ENTRY) {
+        manager->entries[entry->next].previous = entry->previous;
+    } else {
+        manager->tail = entry->previous;
+    }
+}
+
+static void pushFront(luaFMOD_ResidencyManager *manager, int index)
+{
+    ResidencyEntry *entry = &manager->entries[index];
+
+    entry->previous = NO_ENTRY;
+    entry->next = manager->head;
+
+    if (manager->head != NO_ENTRY) {
+        manager->entries[manager->head].previous = index;
+    } else {
+        manager->tail = index;
+    }
+
+    manager->head = index;
+}
+
+static void moveToFront(luaFMOD_ResidencyManager *manager, int index)
+{
+    if (manager->head != index) {
+        listRemove(manager, index);
+        pushFront(manager, index);
+    }
+}
+
+static void makeResident(luaFMOD_ResidencyManager *manager, ResidencyEntry *entry)
+{
+    FMOD_RESULT result = FMOD_Studio_EventDescription_LoadSampleData(entry->description);
+
+    if (result == FMOD_OK) {
+        entry->resident = 1;
+        manager->residentBytes += entry->cost;
+    } else {
+        recordError(manager, result);
+    }
+}
+
+/* Unloads a resident entry's sample data unless it still has instances */
+static void evictIfIdle(luaFMOD_ResidencyManager *manager, ResidencyEntry *entry)
+{
+    int instanceCount = 0;
+    FMOD_RESULT result = FMOD_Studio_EventDescription_GetInstanceCount(entry->description, &instanceCount);
+
+    if (result != FMOD_OK) {
+        recordError(manager, result);
+        return;
+    }
+
+    if (instanceCount > 0) {
+        return;
+    }
+
+    recordError(manager, FMOD_Studio_EventDescription_UnloadSampleData(entry->description));
+
+    entry->resident = 0;
+    manager->residentBytes -= entry->cost;
+    manager->evictions++;
+}
+
+/* Unloads least recently used descriptions until the budget is met. The most
+   recently used description is never evicted, so a single entry larger than the
+   budget can still play.
+*/
+static void enforceBudget(luaFMOD_ResidencyManager *manager)
+{
+    int index = manager->tail;
+
+    while (manager->residentBytes > manager->budget && index != NO_ENTRY && index != manager->head) {
+        ResidencyEntry *entry = &manager->entries[index];
+        int previous = entry->previous;
+
+        if (entry->resident) {
+            evictIfIdle(manager, entry);
+        }
+
+        index = previous;
+    }
+}
+
+static int checkEntry(lua_State *L, luaFMOD_ResidencyManager *manager, int index)
+{
+    FMOD_STUDIO_EVENTDESCRIPTION *description = CHECK_HANDLE(L, index, FMOD_STUDIO_EVENTDESCRIPTION);
+
+    int entry = findEntry(manager, description);
+
+    if (entry == NO_ENTRY) {
+        luaL_argerror(L, index, "description is not tracked");
+    }
+
+    return entry;
+}
+
+/* Marks an entry as used, counting a hit if its sample data is ready, a stall if
+   it is still loading and a miss if it had to be loaded.
+*/
+static void touch(luaFMOD_ResidencyManager *manager, int index)
+{
+    ResidencyEntry *entry = &manager->entries[index];
+
+    moveToFront(manager, index);
+
+    if (!entry->resident) {
+        manager->misses++;
+        makeResident(manager, entry);
+        enforceBudget(manager);
+        return;
+    }
+
+    FMOD_STUDIO_LOADING_STATE state = FMOD_STUDIO_LOADING_STATE_LOADED;
+    recordError(manager, FMOD_Studio_EventDescription_GetSampleLoadingState(entry->description, &state));
+
+    if (state == FMOD_STUDIO_LOADING_STATE_LOADED) {
+        manager->hits++;
+    } else {
+        manager->stalls++;
+    }
+}
+
+int residencyManagerCreate(lua_State *L, double budget)
+{
+    luaL_argcheck(L, budget >= 0, 2, "budget must not be negative");
+
+    luaFMOD_ResidencyManager *manager = NEW_SELF(L);
+
+    manager->budget = budget;
+    manager->head = NO_ENTRY;
+    manager->tail = NO_ENTRY;
+    manager->lastError = FMOD_OK;
+
+    return 1;
+}
+
+static int METHOD_NAME(__gc)(lua_State *L)
+{
+    GET_SELF_FOR_GC;
+
+    for (int i = 0; i < self->count; ++i) {
+        if (self->entries[i].resident) {
+            FMOD_Studio_EventDescription_UnloadSampleData(self->entries[i].description);
+        }
+    }
+
+    free(self->entries);
+    hashTableFree(&self->table);
+
+    self->entries = NULL;
+    self->count = 0;
+    self->released = 1;
+
+    return 0;
+}
+
+/* release()
+   Unloads the sample data this manager loaded and frees it.
+*/
+static int METHOD_NAME(release)(lua_State *L)
+{
+    return METHOD_NAME(__gc)(L);
+}
+
+/* add(description, bytes)
+   Tracks a description. bytes is the memory its sample data occupies when loaded;
+   EventDescription:getSoundSize is a spatializer distance, not a memory size, so
+   the cost has to come from the caller (e.g. from the Studio bank build output).
+*/
+static int METHOD_NAME(add)(lua_State *L)
+{
+    GET_SELF;
+
+    FMOD_STUDIO_EVENTDESCRIPTION *description = CHECK_HANDLE(L, 2, FMOD_STUDIO_EVENTDESCRIPTION);
+    double cost = luaL_checknumber(L, 3);
+
+    luaL_argcheck(L, cost >= 0, 3, "cost must not be negative");
+
+    int index = findEntry(self, description);
+
+    if (index != NO_ENTRY) {
+        ResidencyEntry *entry = &self->entries[index];
+
+        if (entry->resident) {
+            self->residentBytes += cost - entry->cost;
+        }
+
+        entry->cost = cost;
+        return 0;
+    }
+
+    ResidencyEntry *entry = addEntry(self, description);
+
+    if (!entry) {
+        return luaL_error(L, "out of memory");
+    }
+
+    index = (int)(entry - self->entries);
+
+    entry->description = description;
+    entry->cost = cost;
+    entry->resident = 0;
+
+    /* New entries start cold */
+    entry->next = NO_ENTRY;
+    entry->previous = self->tail;
+
+    if (self->tail != NO_ENTRY) {
+        self->entries[self->tail].next = index;
+    } else {
+        self->head = index;
+    }
+
+    self->tail = index;
+
+    return 0;
+}
+
+/* touch(description)
+   Records a use of the description, loading its sample data if it isn't resident.
+*/
+static int METHOD_NAME(touch)(lua_State *L)
+{
+    GET_SELF;
+
+    touch(self, checkEntry(L, self, 2));
+
+    return 0;
+}
+
+/* createInstance(description)
+   Touches the description and creates an instance of it.
+*/
+static int METHOD_NAME(createInstance)(lua_State *L)
+{
+    GET_SELF;
+
+    int index = checkEntry(L, self, 2);
+
+    touch(self, index);
+
+    FMOD_STUDIO_EVENTINSTANCE *instance = NULL;
+    RETURN_IF_ERROR(FMOD_Studio_EventDescription_CreateInstance(self->entries[index].description, &instance));
+
+    PUSH_HANDLE(L, FMOD_STUDIO_EVENTINSTANCE, instance);
+
+    return 1;
+}
+
+/* prefetch(description)
+   A hint that the description will be used soon. Its sample data is loaded ahead
+   of time, as long as that doesn't push out anything used more recently than it.
+*/
+static int METHOD_NAME(prefetch)(lua_State *L)
+{
+    GET_SELF;
+
+    int index = checkEntry(L, self, 2);
+    ResidencyEntry *entry = &self->entries[index];
+
+    if (entry->resident) {
+        return 0;
+    }
+
+    /* Only evict entries colder than this one */
+    for (int i = self->tail; i != NO_ENTRY && i != index && self->residentBytes + entry->cost > self->budget;
+        i = self->entries[i].previous) {
+        if (self->entries[i].resident) {
+            evictIfIdle(self, &self->entries[i]);
+        }
+    }
+
+    if (self->residentBytes + entry->cost > self->budget) {
+        lua_pushboolean(L, 0);
+        return 1;
+    }
+
+    moveToFront(self, index);
+    makeResident(self, entry);
+    self->prefetches++;
+
+    lua_pushboolean(L, entry->resident);
+    return 1;
+}
+
+/* setBudget(bytes) */
+static int METHOD_NAME(setBudget)(lua_State *L)
+{
+    GET_SELF;
+
+    double budget = luaL_checknumber(L, 2);
+
+    luaL_argcheck(L, budget >= 0, 2, "budget must not be negative");
+
+    self->budget = budget;
+
+    return 0;
+}
+
+/* update()
+   Evicts descriptions that were kept over budget because they still had instances.
+*/
+static int METHOD_NAME(update)(lua_State *L)
+{
+    GET_SELF;
+
+    enforceBudget(self);
+
+    return 0;
+}
+
+/* isResident(description) */
+static int METHOD_NAME(isResident)(lua_State *L)
+{
+    GET_SELF;
+
+    int index = checkEntry(L, self, 2);
+
+    lua_pushboolean(L, self->entries[index].resident);
+
+    return 1;
+}
+
+static int METHOD_NAME(getStats)(lua_State *L)
+{
+    GET_SELF;
+
+    lua_createtable(L, 0, 9);
+
+    lua_pushinteger(L, self->count);
+    lua_setfield(L, -2, "tracked");
+
+    lua_pushnumber(L, self->residentBytes);
+    lua_setfield(L, -2, "residentBytes");
+
+    lua_pushnumber(L, self->budget);
+    lua_setfield(L, -2, "budget");
+
+    lua_pushnumber(L, self->hits);
+    lua_setfield(L, -2, "hits");
+
+    lua_pushnumber(L, self->misses);
+    lua_setfield(L, -2, "misses");
+
+    lua_pushnumber(L, self->stalls);
+    lua_setfield(L, -2, "stalls");
+
+    lua_pushnumber(L, self->prefetches);
+    lua_setfield(L, -2, "prefetches");
+
+    lua_pushnumber(L, self->evictions);
+    lua_setfield(L, -2, "evictions");
+
+    lua_pushinteger(L, self->lastError);
+    lua_setfield(L, -2, "lastError");
+
+    return 1;
+}
+
+METHODS_TABLE_BEGIN
+    METHODS_TABLE_ENTRY(__gc)
+    METHODS_TABLE_ENTRY(release)
+    METHODS_TABLE_ENTRY(add)
+    METHODS_TABLE_ENTRY(touch)
+    METHODS_TABLE_ENTRY(createInstance)
+    METHODS_TABLE_ENTRY(prefetch)
+    METHODS_TABLE_ENTRY(setBudget)
+    METHODS_TABLE_ENTRY(update)
+    METHODS_TABLE_ENTRY(isResident)
+    METHODS_TABLE_ENTRY(getStats)
+METHODS_TABLE_END
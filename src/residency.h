@@ -0,0 +1,11 @@
+#ifndef RESIDENCY_H
+#define RESIDENCY_H
+
+#include <fmod_studio.h>
+#include <lauxlib.h>
+
+typedef struct luaFMOD_ResidencyManager luaFMOD_ResidencyManager;
+
+int residencyManagerCreate(lua_State *L, double budget);
+
+#endif /* RESIDENCY_H */
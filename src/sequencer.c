@@ -0,0 +1,424 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+
+#include "common.h"
+#include "context.h"
+#include "sequencer.h"
+
+/* Schedules sounds against the mixer clock. Each queued entry starts a given number of
+   samples after the previous one; entries are played paused, given a start delay on
+   their parent DSP clock and then unpaused, keeping up to `lookahead` of them
+   scheduled ahead of the mixer.
+
+   Sequencers are serviced from System:update, so Lua never has to poll DSP clocks.
+   Releasing or collecting a sequencer frees its queue; channels it already
+   scheduled still play.
+*/
+
+typedef struct SequencerEntry {
+    FMOD_SOUND *sound;
+    FMOD_CHANNELGROUP *group;
+    unsigned long long offset;
+} SequencerEntry;
+
+typedef struct ScheduledChannel {
+    FMOD_CHANNEL *channel;
+    unsigned long long start;
+} ScheduledChannel;
+
+enum { MAX_LOOKAHEAD = 16 };
+
+struct luaFMOD_Sequencer {
+    FMOD_SYSTEM *system;
+    int lookahead;
+    int running;
+    int released;
+
+    SequencerEntry *queue;
+    int queueHead;
+    int queueCount;
+    int queueCapacity;
+
+    ScheduledChannel scheduled[MAX_LOOKAHEAD];
+    int scheduledCount;
+
+    /* DSP clock at which the most recently scheduled entry starts */
+    unsigned long long cursor;
+
+    /* Statistics */
+    unsigned int scheduledTotal;
+    unsigned int lateCount;
+    unsigned long long maxLateness;
+    unsigned long long lastUpdateClock;
+    unsigned int intervalCount;
+    double meanInterval;
+    double maxIntervalDeviation;
+    FMOD_RESULT lastError;
+
+    luaFMOD_Sequencer *next;
+};
+
+#define SELF_TYPE luaFMOD_Sequencer
+
+#undef GET_SELF
+#define GET_SELF GET_RELEASABLE_SELF("sequencer")
+
+static FMOD_RESULT getMixerClock(luaFMOD_Sequencer *sequencer, unsigned long long *clock)
+{
+    FMOD_CHANNELGROUP *master = NULL;
+
+    FMOD_RESULT result = FMOD_System_GetMasterChannelGroup(sequencer->system, &master);
+
+    if (result != FMOD_OK) {
+        return result;
+    }
+
+    return FMOD_ChannelGroup_GetDSPClock(master, NULL, clock);
+}
+
+static FMOD_RESULT scheduleEntry(luaFMOD_Sequencer *sequencer, SequencerEntry *entry,
+    unsigned long long now)
+{
+    unsigned long long start = sequencer->cursor + entry->offset;
+    sequencer->cursor = start;
+
+    FMOD_CHANNEL *channel = NULL;
+
+    FMOD_RESULT result = FMOD_System_PlaySound(sequencer->system, entry->sound, entry->group, 1, &channel);
+
+    if (result != FMOD_OK) {
+        return result;
+    }
+
+    unsigned long long parentClock = 0;
+
+    result = FMOD_Channel_GetDSPClock(channel, NULL, &parentClock);
+
+    if (result == FMOD_OK) {
+        /* Translate from the mixer timeline to the channel's parent clock */
+        unsigned long long delay = parentClock + (start > now ? start - now : 0);
+
+        if (start < now) {
+            unsigned long long lateness = now - start;
+
+            ++sequencer->lateCount;
+
+            if (lateness > sequencer->maxLateness) {
+                sequencer->maxLateness = lateness;
+            }
+        }
+
+        result = FMOD_Channel_SetDelay(channel, delay, 0, 0);
+    }
+
+    if (result == FMOD_OK) {
+        result = FMOD_Channel_SetPaused(channel, 0);
+    }
+
+    if (result != FMOD_OK) {
+        FMOD_Channel_Stop(channel);
+        return result;
+    }
+
+    ScheduledChannel *scheduled = &sequencer->scheduled[sequencer->scheduledCount++];
+    scheduled->channel = channel;
+    scheduled->start = start;
+
+    ++sequencer->scheduledTotal;
+
+    return FMOD_OK;
+}
+
+static void recordInterval(luaFMOD_Sequencer *sequencer, unsigned long long now)
+{
+    if (sequencer->lastUpdateClock != 0 && now > sequencer->lastUpdateClock) {
+        double interval = (double)(now - sequencer->lastUpdateClock);
+
+        ++sequencer->intervalCount;
+        sequencer->meanInterval += (interval - sequencer->meanInterval) / sequencer->intervalCount;
+
+        double deviation = interval - sequencer->meanInterval;
+
+        if (deviation < 0) {
+            deviation = -deviation;
+        }
+
+        if (deviation > sequencer->maxIntervalDeviation) {
+            sequencer->maxIntervalDeviation = deviation;
+        }
+    }
+
+    sequencer->lastUpdateClock = now;
+}
+
+static void updateSequencer(luaFMOD_Sequencer *sequencer)
+{
+    if (!sequencer->running) {
+        return;
+    }
+
+    unsigned long long now = 0;
+    FMOD_RESULT result = getMixerClock(sequencer, &now);
+
+    if (result != FMOD_OK) {
+        sequencer->lastError = result;
+        return;
+    }
+
+    recordInterval(sequencer, now);
+
+    /* Forget entries which have started */
+    int kept = 0;
+
+    for (int i = 0; i < sequencer->scheduledCount; ++i) {
+        if (sequencer->scheduled[i].start > now) {
+            sequencer->scheduled[kept++] = sequencer->scheduled[i];
+        }
+    }
+
+    sequencer->scheduledCount = kept;
+
+    while (sequencer->scheduledCount < sequencer->lookahead && sequencer->queueCount > 0) {
+        SequencerEntry *entry = &sequencer->queue[sequencer->queueHead];
+
+        sequencer->queueHead = (sequencer->queueHead + 1) % sequencer->queueCapacity;
+        --sequencer->queueCount;
+
+        result = scheduleEntry(sequencer, entry, now);
+
+        if (result != FMOD_OK) {
+            sequencer->lastError = result;
+        }
+    }
+}
+
+void sequencerUpdateAll(lua_State *L)
+{
+    for (luaFMOD_Sequencer *sequencer = contextGet(L)->sequencers; sequencer; sequencer = sequencer->next) {
+        updateSequencer(sequencer);
+    }
+}
+
+int sequencerCreate(lua_State *L, FMOD_SYSTEM *system, int lookahead)
+{
+    luaL_argcheck(L, lookahead >= 1 && lookahead <= MAX_LOOKAHEAD, 2, "lookahead out of range");
+
+    luaFMOD_Sequencer *sequencer = NEW_SELF(L);
+
+    sequencer->system = system;
+    sequencer->lookahead = lookahead;
+    sequencer->lastError = FMOD_OK;
+
+    luaFMOD_Context *context = contextGet(L);
+
+    sequencer->next = context->sequencers;
+    context->sequencers = sequencer;
+
+    return 1;
+}
+
+static int METHOD_NAME(__gc)(lua_State *L)
+{
+    GET_SELF_FOR_GC;
+
+    for (luaFMOD_Sequencer **link = &contextGet(L)->sequencers; *link; link = &(*link)->next) {
+        if (*link == self) {
+            *link = self->next;
+            break;
+        }
+    }
+
+    free(self->queue);
+    self->queue = NULL;
+    self->released = 1;
+
+    return 0;
+}
+
+/* Stops servicing the sequencer; channels already scheduled still play. */
+static int METHOD_NAME(release)(lua_State *L)
+{
+    return METHOD_NAME(__gc)(L);
+}
+
+/* enqueue(sound, offset, channelgroup)
+   offset is the start time in mixer samples, relative to the previous entry's start.
+*/
+static int METHOD_NAME(enqueue)(lua_State *L)
+{
+    GET_SELF;
+
+    FMOD_SOUND *sound = CHECK_HANDLE(L, 2, FMOD_SOUND);
+    lua_Number offset = luaL_checknumber(L, 3);
+    FMOD_CHANNELGROUP *group = lua_isnoneornil(L, 4) ? NULL : CHECK_HANDLE(L, 4, FMOD_CHANNELGROUP);
+
+    luaL_argcheck(L, offset >= 0, 3, "offset must not be negative");
+
+    if (self->queueCount == self->queueCapacity) {
+        int capacity = self->queueCapacity ? self->queueCapacity * 2 : 16;
+        SequencerEntry *queue = malloc(sizeof(*queue) * capacity);
+
+        if (!queue) {
+            return luaL_error(L, "out of memory");
+        }
+
+        for (int i = 0; i < self->queueCount; ++i) {
+            queue[i] = self->queue[(self->queueHead + i) % self->queueCapacity];
+        }
+
+        free(self->queue);
+
+        self->queue = queue;
+        self->queueHead = 0;
+        self->queueCapacity = capacity;
+    }
+
+    SequencerEntry *entry = &self->queue[(self->queueHead + self->queueCount) % self->queueCapacity];
+    entry->sound = sound;
+    entry->group = group;
+    entry->offset = (unsigned long long)offset;
+
+    ++self->queueCount;
+
+    return 0;
+}
+
+/* start([delay])
+   Starts the sequence delay mixer samples from now.
+*/
+static int METHOD_NAME(start)(lua_State *L)
+{
+    GET_SELF;
+
+    lua_Number delay = luaL_optnumber(L, 2, 0);
+
+    unsigned long long now = 0;
+    RETURN_IF_ERROR(getMixerClock(self, &now));
+
+    self->cursor = now + (unsigned long long)delay;
+    self->running = 1;
+    self->lastError = FMOD_OK;
+
+    updateSequencer(self);
+
+    RETURN_STATUS(self->lastError);
+}
+
+/* Stops scheduled channels which have not started yet and clears the queue. */
+static int METHOD_NAME(stop)(lua_State *L)
+{
+    GET_SELF;
+
+    for (int i = 0; i < self->scheduledCount; ++i) {
+        FMOD_Channel_Stop(self->scheduled[i].channel);
+    }
+
+    self->scheduledCount = 0;
+    self->queueCount = 0;
+    self->queueHead = 0;
+    self->running = 0;
+
+    return 0;
+}
+
+static int METHOD_NAME(update)(lua_State *L)
+{
+    GET_SELF;
+
+    updateSequencer(self);
+
+    RETURN_STATUS(self->lastError);
+}
+
+static int METHOD_NAME(getCursor)(lua_State *L)
+{
+    GET_SELF;
+
+    lua_pushnumber(L, (lua_Number)self->cursor);
+
+    return 1;
+}
+
+/* Returns a table of scheduling statistics. Clock values are in mixer samples; the
+   update interval is measured on the mixer clock, so its deviation is the jitter that
+   the lookahead has to cover.
+*/
+static int METHOD_NAME(getStats)(lua_State *L)
+{
+    GET_SELF;
+
+    lua_createtable(L, 0, 8);
+
+    lua_pushinteger(L, self->queueCount);
+    lua_setfield(L, -2, "queued");
+
+    lua_pushinteger(L, self->scheduledCount);
+    lua_setfield(L, -2, "pending");
+
+    lua_pushnumber(L, self->scheduledTotal);
+    lua_setfield(L, -2, "scheduled");
+
+    lua_pushnumber(L, self->lateCount);
+    lua_setfield(L, -2, "late");
+
+    lua_pushnumber(L, (lua_Number)self->maxLateness);
+    lua_setfield(L, -2, "maxLateness");
+
+    lua_pushnumber(L, self->meanInterval);
+    lua_setfield(L, -2, "updateInterval");
+
+    lua_pushnumber(L, self->maxIntervalDeviation);
+    lua_setfield(L, -2, "jitter");
+
+    lua_pushinteger(L, self->lastError);
+    lua_setfield(L, -2, "lastError");
+
+    return 1;
+}
+
+static int METHOD_NAME(resetStats)(lua_State *L)
+{
+    GET_SELF;
+
+    self->scheduledTotal = 0;
+    self->lateCount = 0;
+    self->maxLateness = 0;
+    self->lastUpdateClock = 0;
+    self->intervalCount = 0;
+    self->meanInterval = 0;
+    self->maxIntervalDeviation = 0;
+    self->lastError = FMOD_OK;
+
+    return 0;
+}
+
+METHODS_TABLE_BEGIN
+    METHODS_TABLE_ENTRY(__gc)
+    METHODS_TABLE_ENTRY(release)
+    METHODS_TABLE_ENTRY(enqueue)
+    METHODS_TABLE_ENTRY(start)
+    METHODS_TABLE_ENTRY(stop)
+    METHODS_TABLE_ENTRY(update)
+    METHODS_TABLE_ENTRY(getCursor)
+    METHODS_TABLE_ENTRY(getStats)
+    METHODS_TABLE_ENTRY(resetStats)
+METHODS_TABLE_END
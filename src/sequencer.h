@@ -0,0 +1,12 @@
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include <fmod.h>
+#include <lauxlib.h>
+
+typedef struct luaFMOD_Sequencer luaFMOD_Sequencer;
+
+int sequencerCreate(lua_State *L, FMOD_SYSTEM *system, int lookahead);
+void sequencerUpdateAll(lua_State *L);
+
+#endif /* SEQUENCER_H */
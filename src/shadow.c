@@ -0,0 +1,402 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "hashtable.h"
+#include "shadow.h"
+
+/* An opt-in cache of the last value written through the common Studio setters,
+   so that scripts which set the same values every frame don't fill the Studio
+   command queue. Entries are keyed by handle in a HashTable and hold a few fixed properties plus the most recent
+   parameters. Automation tracks, AttributesArray:set3DAttributes and emitter
+   managers record their writes here too; writes made any other way (e.g. from
+   FMOD Studio itself) aren't seen, so the cache is off by default.
+
+   Each Lua state has its own cache in its registry, so the callback state (which
+   runs on FMOD threads) never touches the main state's cache and no locking is
+   needed. Releasing an instance forgets it, and releaseAllInstances, Bank:unload,
+   Studio.System:unloadAll and Studio.System:release clear the calling state's
+   cache, since they destroy handles whose addresses FMOD may reuse, and emitter
+   managers forget the instances they stop.
+*/
+
+#define MIN_TABLE_SIZE 64
+#define MAX_ENTRIES 8192
+#define MAX_PARAMETERS 8
+
+static const int PROPERTY_OFFSETS[SHADOW_PROPERTY_COUNT + 1] = { 0, 1, 2, 3, 15 };
+
+typedef struct ShadowEntry {
+    const void *handle;
+    unsigned int valid;
+
+    float values[15];
+
+    int parameterCount;
+    int nextParameter;
+    FMOD_STUDIO_PARAMETER_ID parameterIDs[MAX_PARAMETERS];
+    float parameterValues[MAX_PARAMETERS];
+} ShadowEntry;
+
+struct ShadowCache {
+    int enabled;
+    float tolerance;
+
+    HashTable entries;
+
+    double saved;
+    double written;
+};
+
+static int sCacheKey;
+
+static int cacheCollect(lua_State *L)
+{
+    ShadowCache *cache = lua_touserdata(L, 1);
+
+    hashTableFree(&cache->entries);
+
+    return 0;
+}
+
+/* Returns the cache for L, or NULL if it hasn't been created */
+static ShadowCache *cacheFind(lua_State *L)
+{
+    lua_pushlightuserdata(L, &sCacheKey);
+    lua_rawget(L, LUA_REGISTRYINDEX);
+
+    ShadowCache *cache = lua_touserdata(L, -1);
+
+    lua_pop(L, 1);
+
+    return cache;
+}
+
+static ShadowCache *cacheGet(lua_State *L)
+{
+    ShadowCache *cache = cacheFind(L);
+
+    if (cache) {
+        return cache;
+    }
+
+    lua_pushlightuserdata(L, &sCacheKey);
+
+    cache = lua_newuserdata(L, sizeof(*cache));
+    memset(cache, 0, sizeof(*cache));
+
+    lua_createtable(L, 0, 1);
+    lua_pushcfunction(L, cacheCollect);
+    lua_setfield(L, -2, "__gc");
+    lua_setmetatable(L, -2);
+
+    lua_rawset(L, LUA_REGISTRYINDEX);
+
+    return cache;
+}
+
+/* Returns the cache if it is enabled */
+static ShadowCache *enabledCache(lua_State *L)
+{
+    ShadowCache *cache = cacheFind(L);
+
+    return cache && cache->enabled ? cache : NULL;
+}
+
+static int entryUsed(const void *slot)
+{
+    return ((const ShadowEntry*)slot)->handle != NULL;
+}
+
+static unsigned int entryHash(const void *slot)
+{
+    return hashPointer(((const ShadowEntry*)slot)->handle);
+}
+
+static int entryMatches(const void *slot, const void *handle)
+{
+    return ((const ShadowEntry*)slot)->handle == handle;
+}
+
+static const HashTableType sEntryType = {
+    sizeof(ShadowEntry), MIN_TABLE_SIZE, entryUsed, entryHash, entryMatches
+};
+
+static ShadowEntry *findEntry(ShadowCache *cache, const void *handle)
+{
+    return hashTableFind(&cache->entries, &sEntryType, hashPointer(handle), handle);
+}
+
+static void clearCache(ShadowCache *cache)
+{
+    hashTableClear(&cache->entries, &sEntryType);
+}
+
+/* Returns the entry for handle, adding it if needed, or NULL if out of memory */
+static ShadowEntry *addEntry(ShadowCache *cache, const void *handle)
+{
+    ShadowEntry *entry = findEntry(cache, handle);
+
+    if (entry) {
+        return entry;
+    }
+
+    if (cache->entries.count >= MAX_ENTRIES) {
+        clearCache(cache);
+    }
+
+    entry = hashTableInsert(&cache->entries, &sEntryType, hashPointer(handle));
+
+    if (entry) {
+        entry->handle = handle;
+    }
+
+    return entry;
+}
+
+static int matches(const ShadowCache *cache, float a, float b)
+{
+    return a == b || fabsf(a - b) <= cache->tolerance;
+}
+
+int shadowIsRedundant(lua_State *L, const void *handle, int property, const float *values)
+{
+    ShadowCache *cache = enabledCache(L);
+
+    if (!cache) {
+        return 0;
+    }
+
+    ShadowEntry *entry = findEntry(cache, handle);
+
+    if (!entry || !(entry->valid & (1u << property))) {
+        return 0;
+    }
+
+    const float *shadow = entry->values + PROPERTY_OFFSETS[property];
+    int count = PROPERTY_OFFSETS[property + 1] - PROPERTY_OFFSETS[property];
+
+    /* The tolerance is for continuous values; paused is a flag */
+    for (int i = 0; i < count; ++i) {
+        if (property == SHADOW_PAUSED ? shadow[i] != values[i] : !matches(cache, shadow[i], values[i])) {
+            return 0;
+        }
+    }
+
+    cache->saved++;
+
+    return 1;
+}
+
+void shadowRecord(lua_State *L, const void *handle, int property, const float *values, FMOD_RESULT result)
+{
+    ShadowCache *cache = enabledCache(L);
+
+    if (!cache) {
+        return;
+    }
+
+    cache->written++;
+
+    if (result != FMOD_OK) {
+        ShadowEntry *entry = findEntry(cache, handle);
+
+        if (entry) {
+            entry->valid &= ~(1u << property);
+        }
+
+        return;
+    }
+
+    ShadowEntry *entry = addEntry(cache, handle);
+
+    if (entry) {
+        int offset = PROPERTY_OFFSETS[property];
+
+        memcpy(entry->values + offset, values, (PROPERTY_OFFSETS[property + 1] - offset) * sizeof(float));
+        entry->valid |= 1u << property;
+    }
+}
+
+static int findParameter(const ShadowEntry *entry, FMOD_STUDIO_PARAMETER_ID id)
+{
+    for (int i = 0; i < entry->parameterCount; ++i) {
+        if (entry->parameterIDs[i].data1 == id.data1 && entry->parameterIDs[i].data2 == id.data2) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int shadowIsRedundantParameter(lua_State *L, const void *handle, FMOD_STUDIO_PARAMETER_ID id, float value)
+{
+    ShadowCache *cache = enabledCache(L);
+
+    if (!cache) {
+        return 0;
+    }
+
+    ShadowEntry *entry = findEntry(cache, handle);
+
+    if (!entry) {
+        return 0;
+    }
+
+    int i = findParameter(entry, id);
+
+    if (i < 0 || !matches(cache, entry->parameterValues[i], value)) {
+        return 0;
+    }
+
+    cache->saved++;
+
+    return 1;
+}
+
+void shadowRecordParameter(lua_State *L, const void *handle, FMOD_STUDIO_PARAMETER_ID id, float value,
+    FMOD_RESULT result)
+{
+    ShadowCache *cache = enabledCache(L);
+
+    if (!cache) {
+        return;
+    }
+
+    cache->written++;
+
+    ShadowEntry *entry = result == FMOD_OK ? addEntry(cache, handle) : findEntry(cache, handle);
+
+    if (!entry) {
+        return;
+    }
+
+    int i = findParameter(entry, id);
+
+    if (result != FMOD_OK) {
+        if (i >= 0) {
+            entry->parameterIDs[i] = entry->parameterIDs[entry->parameterCount - 1];
+            entry->parameterValues[i] = entry->parameterValues[entry->parameterCount - 1];
+            entry->parameterCount--;
+            entry->nextParameter = 0;
+        }
+
+        return;
+    }
+
+    if (i < 0) {
+        if (entry->parameterCount < MAX_PARAMETERS) {
+            i = entry->parameterCount++;
+        } else {
+            /* Replace in rotation once full */
+            i = entry->nextParameter;
+            entry->nextParameter = (entry->nextParameter + 1) % MAX_PARAMETERS;
+        }
+
+        entry->parameterIDs[i] = id;
+    }
+
+    entry->parameterValues[i] = value;
+}
+
+void shadowForgetParameters(lua_State *L, const void *handle)
+{
+    ShadowCache *cache = enabledCache(L);
+    ShadowEntry *entry = cache ? findEntry(cache, handle) : NULL;
+
+    if (entry) {
+        entry->parameterCount = 0;
+        entry->nextParameter = 0;
+    }
+}
+
+void shadowForget(lua_State *L, const void *handle)
+{
+    ShadowCache *cache = cacheFind(L);
+    ShadowEntry *entry = cache ? findEntry(cache, handle) : NULL;
+
+    if (entry) {
+        hashTableRemove(&cache->entries, &sEntryType, entry);
+    }
+}
+
+void shadowForgetAll(lua_State *L)
+{
+    ShadowCache *cache = cacheFind(L);
+
+    if (cache) {
+        clearCache(cache);
+    }
+}
+
+/* Disabling the cache also clears it, since writes made while it is off aren't tracked */
+int Shadow_SetEnabled(lua_State *L)
+{
+    ShadowCache *cache = cacheGet(L);
+
+    float tolerance = (float)luaL_optnumber(L, 2, 0);
+
+    luaL_argcheck(L, tolerance >= 0, 2, "tolerance must not be negative");
+
+    cache->enabled = lua_toboolean(L, 1);
+    cache->tolerance = tolerance;
+
+    if (!cache->enabled) {
+        clearCache(cache);
+    }
+
+    return 0;
+}
+
+int Shadow_GetStats(lua_State *L)
+{
+    ShadowCache *cache = cacheGet(L);
+
+    lua_createtable(L, 0, 4);
+
+    lua_pushboolean(L, cache->enabled);
+    lua_setfield(L, -2, "enabled");
+
+    lua_pushinteger(L, cache->entries.count);
+    lua_setfield(L, -2, "entries");
+
+    lua_pushnumber(L, cache->saved);
+    lua_setfield(L, -2, "saved");
+
+    lua_pushnumber(L, cache->written);
+    lua_setfield(L, -2, "written");
+
+    return 1;
+}
+
+int Shadow_Clear(lua_State *L)
+{
+    ShadowCache *cache = cacheGet(L);
+
+    clearCache(cache);
+    cache->saved = 0;
+    cache->written = 0;
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+#ifndef SHADOW_H
+#define SHADOW_H
+
+#include <fmod_studio.h>
+#include <lauxlib.h>
+
+typedef struct ShadowCache ShadowCache;
+
+/* Shadowed properties; each holds the number of floats noted */
+enum {
+    SHADOW_VOLUME,      /* 1 */
+    SHADOW_PITCH,       /* 1 */
+    SHADOW_PAUSED,      /* 1 */
+    SHADOW_ATTRIBUTES,  /* 12, as laid out in FMOD_3D_ATTRIBUTES */
+    SHADOW_PROPERTY_COUNT
+};
+
+/* Returns 1 if the shadow cache is enabled and the last successful write of
+   property on handle matches values within the tolerance, counting a saved call.
+*/
+int shadowIsRedundant(lua_State *L, const void *handle, int property, const float *values);
+
+/* Records the values written, or forgets the property if result is an error */
+void shadowRecord(lua_State *L, const void *handle, int property, const float *values, FMOD_RESULT result);
+
+int shadowIsRedundantParameter(lua_State *L, const void *handle, FMOD_STUDIO_PARAMETER_ID id, float value);
+void shadowRecordParameter(lua_State *L, const void *handle, FMOD_STUDIO_PARAMETER_ID id, float value,
+    FMOD_RESULT result);
+
+/* Forgets the parameters of handle, after they were written by name or label */
+void shadowForgetParameters(lua_State *L, const void *handle);
+
+/* Forgets everything about handle; called when it is released */
+void shadowForget(lua_State *L, const void *handle);
+
+/* Forgets every handle; called when handles are destroyed in bulk */
+void shadowForgetAll(lua_State *L);
+
+/* FMOD.Shadow_SetEnabled(enabled, [tolerance]) */
+int Shadow_SetEnabled(lua_State *L);
+
+/* FMOD.Shadow_GetStats() */
+int Shadow_GetStats(lua_State *L);
+
+/* FMOD.Shadow_Clear() */
+int Shadow_Clear(lua_State *L);
+
+#endif /* SHADOW_H */
@@ -0,0 +1,56 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <math.h>
+
+/* Four-wide SSE lanes where the target has SSE, otherwise one scalar lane, so loops
+   written as LANES-wide steps plus a scalar tail compile on every platform.
+*/
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+
+    #define LANES 4
+
+    typedef __m128 Lanes;
+
+    #define LOAD(pointer) _mm_loadu_ps(pointer)
+    #define STORE(pointer, value) _mm_storeu_ps(pointer, value)
+    #define SPLAT(value) _mm_set1_ps(value)
+    #define ADD(a, b) _mm_add_ps(a, b)
+    #define SUB(a, b) _mm_sub_ps(a, b)
+    #define MUL(a, b) _mm_mul_ps(a, b)
+    #define DIV(a, b) _mm_div_ps(a, b)
+    #define MAX(a, b) _mm_max_ps(a, b)
+    #define SQRT(a) _mm_sqrt_ps(a)
+    #define ABS(a) _mm_andnot_ps(_mm_set1_ps(-0.0f), a)
+
+    static inline float horizontalMax(Lanes value)
+    {
+        value = _mm_max_ps(value, _mm_movehl_ps(value, value));
+        value = _mm_max_ss(value, _mm_shuffle_ps(value, value, 1));
+        return _mm_cvtss_f32(value);
+    }
+#else
+    #define LANES 1
+
+    typedef float Lanes;
+
+    #define LOAD(pointer) (*(pointer))
+    #define STORE(pointer, value) (*(pointer) = (value))
+    #define SPLAT(value) (value)
+    #define ADD(a, b) ((a) + (b))
+    #define SUB(a, b) ((a) - (b))
+    #define MUL(a, b) ((a) * (b))
+    #define DIV(a, b) ((a) / (b))
+    #define MAX(a, b) ((a) > (b) ? (a) : (b))
+    #define SQRT(a) sqrtf(a)
+    #define ABS(a) fabsf(a)
+
+    static inline float horizontalMax(Lanes value)
+    {
+        return value;
+    }
+#endif
+
+#endif /* SIMD_H */
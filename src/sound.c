@@ -19,6 +19,7 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include "common.h"
+#include "nonblocking.h"
 
 #define SELF_TYPE FMOD_SOUND
 #define FMOD_PREFIX FMOD_Sound_
@@ -39,6 +40,38 @@ static int GET_FMOD_SOUND_indexed(lua_State *L, FMOD_RESULT F_API (*getter)(SELF
   return 1;
 }
 
+static int METHOD_NAME(release)(lua_State *L)
+{
+  GET_SELF;
+
+  RETURN_IF_ERROR(FMOD_Sound_Release(self));
+
+  nonblockingForget(L, self);
+
+  lua_pushboolean(L, 1);
+  return 1;
+}
+
+/* Suspends the calling coroutine until an FMOD_NONBLOCKING open completes. Returns
+   immediately if it already has.
+*/
+static int METHOD_NAME(waitForOpen)(lua_State *L)
+{
+  GET_SELF;
+
+  return nonblockingWaitForOpen(L, self);
+}
+
+/* Milliseconds from createSound to the open completing, or nil if still pending (or
+   if it completed more than 256 nonblocking opens ago).
+*/
+static int METHOD_NAME(getOpenLatency)(lua_State *L)
+{
+  GET_SELF;
+
+  return nonblockingPushOpenLatency(L, self);
+}
+
 GET(SystemObject, (FMOD_SYSTEM, HANDLE))
 HANDLE_LIST(SubSound, FMOD_SOUND)
 GET(SubSoundParent, (FMOD_SOUND, HANDLE))
@@ -50,14 +83,13 @@ PROPERTY_MULTI(3DMinMaxDistance, float, float)
 PROPERTY_MULTI(3DConeSettings, float, float, float)
 PROPERTY(Mode, (FMOD_MODE, CONSTANT))
 PROPERTY(LoopCount, int)
+GET_MULTI(OpenState, (FMOD_OPENSTATE, CONSTANT), unsigned, FMOD_BOOL, FMOD_BOOL)
 GET(MusicNumChannels, int)
 PROPERTY_INDEXED(MusicChannelVolume, int, float)
 PROPERTY(MusicSpeed, float)
 
 METHODS_TABLE_BEGIN
-#if 0
     METHODS_TABLE_ENTRY(release)
-#endif
     METHODS_TABLE_ENTRY(getSystemObject)
 #if 0
     METHODS_TABLE_ENTRY(lock)
@@ -82,7 +114,11 @@ METHODS_TABLE_BEGIN
 #if 0
     METHODS_TABLE_ENTRY(getNumTags)
     METHODS_TABLE_ENTRY(getTag)
+#endif
     METHODS_TABLE_ENTRY(getOpenState)
+    METHODS_TABLE_ENTRY(waitForOpen)
+    METHODS_TABLE_ENTRY(getOpenLatency)
+#if 0
     METHODS_TABLE_ENTRY(readData)
     METHODS_TABLE_ENTRY(seekData)
     METHODS_TABLE_ENTRY(setSoundGroup)
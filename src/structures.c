@@ -21,7 +21,10 @@ DEALINGS IN THE SOFTWARE.
 #include "common.h"
 #include <string.h>
 
-static int sReferenceTable = LUA_NOREF;
+/* The address of this is the registry key for the reference table, so each Lua
+   universe gets its own table.
+*/
+static int sReferenceTableKey;
 
 /* Pops a struct instance from the top of the stack.
    Pushes the reference table for the struct instance onto the stack.
@@ -30,7 +33,13 @@ static void affirmReferenceTable(lua_State *L)
 {
     int instanceIndex = lua_gettop(L);
 
-    if (sReferenceTable == LUA_NOREF) {
+    /* Get the global reference table */
+    lua_pushlightuserdata(L, &sReferenceTableKey);
+    lua_rawget(L, LUA_REGISTRYINDEX);
+
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+
         /* Create the global reference table */
         lua_newtable(L);
 
@@ -44,13 +53,12 @@ static void affirmReferenceTable(lua_State *L)
         /* Set the metatable on the global reference table */
         lua_setmetatable(L, -2);
 
-        /* Store a reference to the global reference table */
-        sReferenceTable = luaL_ref(L, LUA_REGISTRYINDEX);
+        /* Store the global reference table in the registry */
+        lua_pushlightuserdata(L, &sReferenceTableKey);
+        lua_pushvalue(L, -2);
+        lua_rawset(L, LUA_REGISTRYINDEX);
     }
 
-    /* Get the global reference table */
-    lua_rawgeti(L, LUA_REGISTRYINDEX, sReferenceTable);
-
     int globalIndex = lua_gettop(L);
 
     /* Get the instance reference table */
@@ -18,8 +18,23 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 DEALINGS IN THE SOFTWARE.
 */
 
+#include "automation.h"
+#include "await.h"
+#include "bankindex.h"
+#include "bankloader.h"
 #include "common.h"
+#include "emitters.h"
 #include "logging.h"
+#include "nonblocking.h"
+#include "parametercache.h"
+#include "platform.h"
+#include "programmersounds.h"
+#include "residency.h"
+#include "sequencer.h"
+#include "shadow.h"
+#include "studiosystem.h"
+#include "telemetry.h"
+#include <math.h>
 #include <stdlib.h>
 
 #define SELF_TYPE FMOD_STUDIO_SYSTEM
@@ -67,9 +82,10 @@ static int METHOD_NAME(initialize)(lua_State *L)
     int studioflags = CHECK_CONSTANT(L, 3, FMOD_STUDIO_INITFLAGS);
     int coreflags = CHECK_CONSTANT(L, 4, FMOD_INITFLAGS);
 
-    /* TODO extradriverdata? */
+    /* For the WAVWRITER outputs, extradriverdata is the output filename */
+    void *extradriverdata = (void*)luaL_optstring(L, 5, NULL);
 
-    REQUIRE_OK(FMOD_Studio_System_Initialize(self, maxchannels, studioflags, coreflags, NULL));
+    REQUIRE_OK(FMOD_Studio_System_Initialize(self, maxchannels, studioflags, coreflags, extradriverdata));
 
     return 0;
 }
@@ -78,18 +94,72 @@ static int METHOD_NAME(release)(lua_State *L)
 {
     GET_SELF;
 
+    shadowForgetAll(L);
+
     REQUIRE_OK(FMOD_Studio_System_Release(self));
 
     return 0;
 }
 
-static int METHOD_NAME(update)(lua_State *L)
+FMOD_RESULT studioSystemUpdate(lua_State *L, FMOD_STUDIO_SYSTEM *system)
 {
-    GET_SELF;
+    automationUpdateAll(L);
+
+    FMOD_RESULT result = FMOD_Studio_System_Update(system);
+
+    if (result != FMOD_OK) {
+        return result;
+    }
 
-    REQUIRE_OK(FMOD_Studio_System_Update(self));
+    stackBufferReset(L);
+
+    int top = lua_gettop(L);
 
     loggingPumpMessages(L);
+    int errors = nonblockingPumpResults(L);
+    errors += awaitPump(L);
+    sequencerUpdateAll(L);
+    programmerSoundsUpdateAll(L);
+
+    /* Raise the first callback error only once the whole step has run */
+    if (errors > 0) {
+        lua_settop(L, top + 1);
+        lua_error(L);
+    }
+
+    return FMOD_OK;
+}
+
+typedef struct ProtectedUpdate {
+    FMOD_STUDIO_SYSTEM *system;
+    FMOD_RESULT result;
+} ProtectedUpdate;
+
+static int protectedUpdate(lua_State *L)
+{
+    ProtectedUpdate *call = lua_touserdata(L, 1);
+
+    call->result = studioSystemUpdate(L, call->system);
+
+    return 0;
+}
+
+int studioSystemProtectedUpdate(lua_State *L, FMOD_STUDIO_SYSTEM *system, FMOD_RESULT *result)
+{
+    ProtectedUpdate call = { system, FMOD_OK };
+
+    int status = lua_cpcall(L, protectedUpdate, &call);
+
+    *result = call.result;
+
+    return status;
+}
+
+static int METHOD_NAME(update)(lua_State *L)
+{
+    GET_SELF;
+
+    REQUIRE_OK(studioSystemUpdate(L, self));
 
     return 0;
 }
@@ -432,9 +502,27 @@ static int METHOD_NAME(getParameterByName)(lua_State *L)
 
     const char *name = luaL_checkstring(L, 2);
 
+    FMOD_STUDIO_PARAMETER_ID id;
+    float labelValue = 0;
+
     float value = 0;
     float finalvalue = 0;
-    RETURN_IF_ERROR(FMOD_Studio_System_GetParameterByName(self, name, &value, &finalvalue));
+    FMOD_RESULT result = FMOD_ERR_EVENT_NOTFOUND;
+
+    /* See the parameter cache note in eventinstance.c */
+    if (parameterCacheLookup(L, self, NULL, 2, 0, &id, &labelValue)) {
+        result = FMOD_Studio_System_GetParameterByID(self, id, &value, &finalvalue);
+
+        if (PARAMETER_CACHE_STALE(result)) {
+            parameterCacheForget(L, self, NULL, 2, 0);
+        }
+    }
+
+    if (PARAMETER_CACHE_STALE(result)) {
+        result = FMOD_Studio_System_GetParameterByName(self, name, &value, &finalvalue);
+    }
+
+    RETURN_IF_ERROR(result);
 
     lua_pushnumber(L, value);
     lua_pushnumber(L, finalvalue);
@@ -450,6 +538,19 @@ static int METHOD_NAME(setParameterByName)(lua_State *L)
     float value = (float)luaL_checknumber(L, 3);
     int ignoreseekspeed = lua_toboolean(L, 4);
 
+    FMOD_STUDIO_PARAMETER_ID id;
+    float labelValue = 0;
+
+    if (parameterCacheLookup(L, self, NULL, 2, 0, &id, &labelValue)) {
+        FMOD_RESULT result = FMOD_Studio_System_SetParameterByID(self, id, value, ignoreseekspeed);
+
+        if (!PARAMETER_CACHE_STALE(result)) {
+            RETURN_STATUS(result);
+        }
+
+        parameterCacheForget(L, self, NULL, 2, 0);
+    }
+
     RETURN_STATUS(FMOD_Studio_System_SetParameterByName(self, name, value, ignoreseekspeed));
 }
 
@@ -461,6 +562,19 @@ static int METHOD_NAME(setParameterByNameWithLabel)(lua_State *L)
     const char *label = luaL_checkstring(L, 3);
     int ignoreseekspeed = lua_toboolean(L, 4);
 
+    FMOD_STUDIO_PARAMETER_ID id;
+    float labelValue = 0;
+
+    if (parameterCacheLookup(L, self, NULL, 2, 3, &id, &labelValue)) {
+        FMOD_RESULT result = FMOD_Studio_System_SetParameterByID(self, id, labelValue, ignoreseekspeed);
+
+        if (!PARAMETER_CACHE_STALE(result)) {
+            RETURN_STATUS(result);
+        }
+
+        parameterCacheForget(L, self, NULL, 2, 3);
+    }
+
     RETURN_STATUS(FMOD_Studio_System_SetParameterByNameWithLabel(self, name, label, ignoreseekspeed));
 }
 
@@ -609,10 +723,32 @@ static int METHOD_NAME(loadBankMemory)(lua_State *L)
     return 1;
 }
 
+/* loadBanks(paths, flags, [readers])
+   Loads all of the banks in paths at once and waits for them, calling update
+   until each is loaded or has failed. If readers is positive (the default is 4)
+   the files are read into memory on that many threads and loaded with
+   LOAD_MEMORY; 0 leaves file reading to Studio. Returns an array with a table
+   per path holding bank (if it loaded), result, readTime and loadTime in seconds
+   since the call started, followed by the total time.
+*/
+static int METHOD_NAME(loadBanks)(lua_State *L)
+{
+    GET_SELF;
+
+    int flags = CHECK_CONSTANT(L, 3, FMOD_STUDIO_LOAD_BANK_FLAGS);
+    int readers = luaL_optint(L, 4, 4);
+
+    luaL_argcheck(L, readers >= 0, 4, "reader count must not be negative");
+
+    return bankLoaderRun(L, self, 2, flags, readers);
+}
+
 static int METHOD_NAME(unloadAll)(lua_State *L)
 {
     GET_SELF;
 
+    shadowForgetAll(L);
+
     RETURN_STATUS(FMOD_Studio_System_UnloadAll(self));
 }
 
@@ -647,6 +783,21 @@ static int METHOD_NAME(stopCommandCapture)(lua_State *L)
     RETURN_STATUS(FMOD_Studio_System_StopCommandCapture(self));
 }
 
+static int METHOD_NAME(loadCommandReplay)(lua_State *L)
+{
+    GET_SELF;
+
+    const char *filename = luaL_checkstring(L, 2);
+    int flags = OPTIONAL_CONSTANT(L, 3, FMOD_STUDIO_COMMANDREPLAY_FLAGS, FMOD_STUDIO_COMMANDREPLAY_NORMAL);
+
+    FMOD_STUDIO_COMMANDREPLAY *replay = NULL;
+    RETURN_IF_ERROR(FMOD_Studio_System_LoadCommandReplay(self, filename, flags, &replay));
+
+    PUSH_HANDLE(L, FMOD_STUDIO_COMMANDREPLAY, replay);
+
+    return 1;
+}
+
 static int METHOD_NAME(getBankCount)(lua_State *L)
 {
     GET_SELF;
@@ -687,6 +838,36 @@ static int METHOD_NAME(getBankList)(lua_State *L)
     return 1;
 }
 
+static FMOD_RESULT getBankDetails(void *handle, FMOD_GUID *id, char *path, int size, int *retrieved)
+{
+    FMOD_RESULT result = FMOD_Studio_Bank_GetID(handle, id);
+
+    if (result != FMOD_OK) {
+        return result;
+    }
+
+    return FMOD_Studio_Bank_GetPath(handle, path, size, retrieved);
+}
+
+/* Returns arrays of handles, paths and IDs */
+static int METHOD_NAME(getBankListDetailed)(lua_State *L)
+{
+    GET_SELF;
+
+    int count = 0;
+    RETURN_IF_ERROR(FMOD_Studio_System_GetBankCount(self, &count));
+
+    STACKBUFFER_CREATE(FMOD_STUDIO_BANK*, array, count);
+
+    RETURN_IF_ERROR(FMOD_Studio_System_GetBankList(self, array, count, &count), STACKBUFFER_RELEASE(array););
+
+    int results = pushDetailedList(L, "FMOD_STUDIO_BANK", (void**)array, count, getBankDetails);
+
+    STACKBUFFER_RELEASE(array);
+
+    return results;
+}
+
 static int METHOD_NAME(getParameterDescriptionCount)(lua_State *L)
 {
     GET_SELF;
@@ -777,6 +958,223 @@ FUNCTION_TABLE_BEGIN(StudioSystemStaticFunctions)
     METHODS_TABLE_ENTRY(create)
 FUNCTION_TABLE_END
 
+/* buildBankIndex(filename, [stamps])
+   Writes metadata for all loaded banks to filename; see bankindex.c. stamps is an
+   optional table mapping bank paths to modification stamps. Returns true and the
+   number of objects indexed without a path (if the strings bank is not loaded).
+*/
+static int METHOD_NAME(buildBankIndex)(lua_State *L)
+{
+    GET_SELF;
+
+    return bankIndexBuild(L, self, 2, 3);
+}
+
+/* captureTelemetry([out])
+   Records CPU and memory usage for the system, every bus in every loaded bank and every
+   live event instance into out, creating it if necessary. Returns out.
+*/
+static int METHOD_NAME(captureTelemetry)(lua_State *L)
+{
+    GET_SELF;
+
+    return telemetryCapture(L, self, 2);
+}
+
+/* simulate(seconds, [buses])
+   Runs update (with everything Studio.System:update delivers) in a tight loop
+   until the mixer clock has advanced by the given number of seconds, which runs
+   faster than realtime when the core system uses a non-realtime output
+   (OUTPUTTYPE.NOSOUND_NRT or WAVWRITER_NRT). Time is measured on the master
+   ChannelGroup's DSP clock, so it is right whether or not the system was
+   initialized with STUDIO_INIT.SYNCHRONOUS_UPDATE; without it the mixer runs on
+   the Studio thread and the loop mostly waits for it. The loop also stops if the
+   clock does not move for a second.
+   Returns a table with the update count, simulated and elapsed seconds, the
+   speed relative to realtime, the average core DSP and update CPU, and for each
+   bus in buses its average exclusive and inclusive CPU time per update in
+   microseconds.
+*/
+static int METHOD_NAME(simulate)(lua_State *L)
+{
+    GET_SELF;
+
+    double seconds = luaL_checknumber(L, 2);
+    luaL_argcheck(L, seconds > 0, 2, "seconds must be positive");
+
+    int busCount = 0;
+
+    if (!lua_isnoneornil(L, 3)) {
+        luaL_checktype(L, 3, LUA_TTABLE);
+        busCount = (int)lua_objlen(L, 3);
+    }
+
+    /* Userdata rather than STACKBUFFERs, since each update resets the scratch arena
+       and callbacks may raise errors
+    */
+    FMOD_STUDIO_BUS **buses = lua_newuserdata(L, sizeof(*buses) * (busCount ? busCount : 1));
+    double *busTotals = lua_newuserdata(L, sizeof(*busTotals) * (busCount ? busCount * 2 : 1));
+
+    for (int i = 0; i < busCount; ++i) {
+        lua_rawgeti(L, 3, i + 1);
+        buses[i] = CHECK_HANDLE(L, -1, FMOD_STUDIO_BUS);
+        lua_pop(L, 1);
+
+        busTotals[i * 2] = 0;
+        busTotals[i * 2 + 1] = 0;
+    }
+
+    FMOD_SYSTEM *core = NULL;
+    RETURN_IF_ERROR(FMOD_Studio_System_GetCoreSystem(self, &core));
+
+    int samplerate = 0;
+    RETURN_IF_ERROR(FMOD_System_GetSoftwareFormat(core, &samplerate, NULL, NULL));
+
+    FMOD_CHANNELGROUP *master = NULL;
+    RETURN_IF_ERROR(FMOD_System_GetMasterChannelGroup(core, &master));
+
+    unsigned long long startClock = 0;
+    RETURN_IF_ERROR(FMOD_ChannelGroup_GetDSPClock(master, &startClock, NULL));
+
+    unsigned long long targetSamples = (unsigned long long)ceil(seconds * samplerate);
+    unsigned long long clock = startClock;
+
+    FMOD_RESULT result = FMOD_OK;
+    double dspTotal = 0;
+    double updateTotal = 0;
+    double start = platformGetTime();
+    double lastAdvance = start;
+    int frames = 0;
+
+    while (result == FMOD_OK && clock - startClock < targetSamples) {
+        result = studioSystemUpdate(L, self);
+
+        if (result != FMOD_OK) {
+            break;
+        }
+
+        frames++;
+
+        FMOD_CPU_USAGE usage = { 0 };
+
+        if (FMOD_System_GetCPUUsage(core, &usage) == FMOD_OK) {
+            dspTotal += usage.dsp;
+            updateTotal += usage.update;
+        }
+
+        for (int i = 0; i < busCount; ++i) {
+            unsigned int exclusive = 0;
+            unsigned int inclusive = 0;
+
+            if (FMOD_Studio_Bus_GetCPUUsage(buses[i], &exclusive, &inclusive) == FMOD_OK) {
+                busTotals[i * 2] += exclusive;
+                busTotals[i * 2 + 1] += inclusive;
+            }
+        }
+
+        unsigned long long previous = clock;
+        result = FMOD_ChannelGroup_GetDSPClock(master, &clock, NULL);
+
+        if (clock != previous) {
+            lastAdvance = platformGetTime();
+        } else if (platformGetTime() - lastAdvance > 1.0) {
+            break;
+        }
+    }
+
+    double elapsed = platformGetTime() - start;
+
+    RETURN_IF_ERROR(result);
+
+    double simulated = (double)(clock - startClock) / samplerate;
+    double divisor = frames > 0 ? frames : 1;
+
+    lua_createtable(L, 0, 7);
+
+    lua_pushinteger(L, frames);
+    lua_setfield(L, -2, "frames");
+
+    lua_pushnumber(L, simulated);
+    lua_setfield(L, -2, "simulated");
+
+    lua_pushnumber(L, elapsed);
+    lua_setfield(L, -2, "elapsed");
+
+    lua_pushnumber(L, elapsed > 0 ? simulated / elapsed : 0);
+    lua_setfield(L, -2, "speed");
+
+    lua_pushnumber(L, dspTotal / divisor);
+    lua_setfield(L, -2, "dsp");
+
+    lua_pushnumber(L, updateTotal / divisor);
+    lua_setfield(L, -2, "update");
+
+    lua_createtable(L, busCount, 0);
+
+    for (int i = 0; i < busCount; ++i) {
+        lua_createtable(L, 0, 2);
+
+        lua_pushnumber(L, busTotals[i * 2] / divisor);
+        lua_setfield(L, -2, "exclusive");
+
+        lua_pushnumber(L, busTotals[i * 2 + 1] / divisor);
+        lua_setfield(L, -2, "inclusive");
+
+        lua_rawseti(L, -2, i + 1);
+    }
+
+    lua_setfield(L, -2, "buses");
+
+    return 1;
+}
+
+/* createEmitterManager([cellSize], [poolSize])
+   cellSize is the spatial grid cell size in distance units; poolSize is the number
+   of stopped instances kept for reuse when emitters come back into range.
+*/
+static int METHOD_NAME(createEmitterManager)(lua_State *L)
+{
+    GET_SELF;
+
+    float cellSize = (float)luaL_optnumber(L, 2, 50);
+    int poolSize = luaL_optint(L, 3, 0);
+
+    return emitterManagerCreate(L, self, cellSize, poolSize);
+}
+
+/* createAutomation()
+   Automation tracks are evaluated at the start of each update.
+*/
+static int METHOD_NAME(createAutomation)(lua_State *L)
+{
+    GET_SELF;
+
+    return automationCreate(L, self);
+}
+
+/* createProgrammerSoundResolver([mode])
+   mode is added to the mode from getSoundInfo when creating sounds; the default
+   is CREATECOMPRESSEDSAMPLE | NONBLOCKING.
+*/
+static int METHOD_NAME(createProgrammerSoundResolver)(lua_State *L)
+{
+    GET_SELF;
+
+    FMOD_MODE mode = OPTIONAL_CONSTANT(L, 2, FMOD_MODE, FMOD_CREATECOMPRESSEDSAMPLE | FMOD_NONBLOCKING);
+
+    return programmerSoundResolverCreate(L, self, mode);
+}
+
+/* createResidencyManager(budget)
+   budget is the number of bytes of event sample data to keep loaded.
+*/
+static int METHOD_NAME(createResidencyManager)(lua_State *L)
+{
+    luaL_checkudata(L, 1, STRINGIZE(SELF_TYPE));
+
+    return residencyManagerCreate(L, luaL_checknumber(L, 2));
+}
+
 METHODS_TABLE_BEGIN
     METHODS_TABLE_ENTRY(setAdvancedSettings)
     METHODS_TABLE_ENTRY(getAdvancedSettings)
@@ -814,17 +1212,27 @@ METHODS_TABLE_BEGIN
     METHODS_TABLE_ENTRY(setListenerWeight)
     METHODS_TABLE_ENTRY(loadBankFile)
     METHODS_TABLE_ENTRY(loadBankMemory)
+    METHODS_TABLE_ENTRY(loadBanks)
     METHODS_TABLE_ENTRY(unloadAll)
     METHODS_TABLE_ENTRY(flushCommands)
     METHODS_TABLE_ENTRY(flushSampleLoading)
     METHODS_TABLE_ENTRY(startCommandCapture)
     METHODS_TABLE_ENTRY(stopCommandCapture)
+    METHODS_TABLE_ENTRY(loadCommandReplay)
     METHODS_TABLE_ENTRY(getBankCount)
     METHODS_TABLE_ENTRY(getBankList)
+    METHODS_TABLE_ENTRY(getBankListDetailed)
     METHODS_TABLE_ENTRY(getParameterDescriptionCount)
     METHODS_TABLE_ENTRY(getParameterDescriptionList)
     METHODS_TABLE_ENTRY(getCPUUsage)
     METHODS_TABLE_ENTRY(getBufferUsage)
     METHODS_TABLE_ENTRY(resetBufferUsage)
     METHODS_TABLE_ENTRY(getMemoryUsage)
+    METHODS_TABLE_ENTRY(captureTelemetry)
+    METHODS_TABLE_ENTRY(buildBankIndex)
+    METHODS_TABLE_ENTRY(createEmitterManager)
+    METHODS_TABLE_ENTRY(createAutomation)
+    METHODS_TABLE_ENTRY(createResidencyManager)
+    METHODS_TABLE_ENTRY(createProgrammerSoundResolver)
+    METHODS_TABLE_ENTRY(simulate)
 METHODS_TABLE_END
@@ -0,0 +1,23 @@
+#ifndef STUDIOSYSTEM_H
+#define STUDIOSYSTEM_H
+
+#include <fmod_studio.h>
+#include <lauxlib.h>
+
+/* Everything Studio.System:update does: runs automation, updates FMOD and then
+   delivers logging, nonblocking results, awaits, sequencer scheduling and
+   programmer sound bookkeeping. Returns the FMOD update result; nothing is
+   delivered if it fails. The first error raised by a Lua callback or resumed
+   coroutine is rethrown after every step has run.
+
+   This also resets the scratch arena, so callers must not hold STACKBUFFERs.
+*/
+FMOD_RESULT studioSystemUpdate(lua_State *L, FMOD_STUDIO_SYSTEM *system);
+
+/* studioSystemUpdate under lua_cpcall, for callers with resources to clean up.
+   Returns the lua_cpcall status, with the error on the stack if it is nonzero,
+   and stores the FMOD update result in result.
+*/
+int studioSystemProtectedUpdate(lua_State *L, FMOD_STUDIO_SYSTEM *system, FMOD_RESULT *result);
+
+#endif /* STUDIOSYSTEM_H */
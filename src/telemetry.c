@@ -0,0 +1,273 @@
+/*
+Copyright 2026 Ben Batt
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+
+#include "common.h"
+#include "recordarray.h"
+#include "telemetry.h"
+
+/* A reusable array of CPU and memory records, filled by
+   Studio.System:captureTelemetry. Records and scratch lists are kept between
+   captures, so a capture allocates nothing once the array has grown to size.
+   Buses and events that appear in several banks are recorded once.
+*/
+
+enum {
+    KIND_SYSTEM,
+    KIND_BUS,
+    KIND_INSTANCE,
+};
+
+static const char *KIND_NAMES[] = { "system", "bus", "instance" };
+
+typedef struct TelemetryRecord {
+    void *handle;
+    int kind;
+    unsigned int cpuExclusive;
+    unsigned int cpuInclusive;
+    int memoryExclusive;
+    int memoryInclusive;
+    int sampleData;
+} TelemetryRecord;
+
+struct luaFMOD_Telemetry {
+    RecordArray records;
+
+    RecordArray banks;
+    RecordArray buses;
+    RecordArray events;
+    RecordArray instances;
+};
+
+#define SELF_TYPE luaFMOD_Telemetry
+
+#undef GET_SELF
+#define GET_SELF \
+    SELF_TYPE *self = (SELF_TYPE*)luaL_checkudata(L, 1, STRINGIZE(SELF_TYPE))
+
+static TelemetryRecord *addRecord(luaFMOD_Telemetry *telemetry, int kind, void *handle)
+{
+    if (!recordArrayReserve(&telemetry->records, telemetry->records.count + 1, sizeof(TelemetryRecord))) {
+        return NULL;
+    }
+
+    TelemetryRecord *record = RECORD_AT(telemetry->records, TelemetryRecord, telemetry->records.count++);
+    record->handle = handle;
+    record->kind = kind;
+    record->cpuExclusive = 0;
+    record->cpuInclusive = 0;
+    record->memoryExclusive = 0;
+    record->memoryInclusive = 0;
+    record->sampleData = 0;
+
+    return record;
+}
+
+static void storeMemory(TelemetryRecord *record, FMOD_RESULT result, FMOD_STUDIO_MEMORY_USAGE *usage)
+{
+    if (result == FMOD_OK) {
+        record->memoryExclusive = usage->exclusive;
+        record->memoryInclusive = usage->inclusive;
+        record->sampleData = usage->sampledata;
+    }
+}
+
+static int comparePointers(const void *a, const void *b)
+{
+    const char *left = *(void* const*)a;
+    const char *right = *(void* const*)b;
+
+    return left < right ? -1 : left > right;
+}
+
+/* Sorts a list of handles and drops duplicates */
+static void uniqueHandles(RecordArray *list)
+{
+    void **items = list->items;
+    int count = 0;
+
+    qsort(items, list->count, sizeof(void*), comparePointers);
+
+    for (int i = 0; i < list->count; ++i) {
+        if (count == 0 || items[count - 1] != items[i]) {
+            items[count++] = items[i];
+        }
+    }
+
+    list->count = count;
+}
+
+/* Appends the result of a GetCount/GetList pair to list. */
+#define APPEND_LIST(list, getCount, getList, owner, type) \
+    do { \
+        int count = 0; \
+        result = getCount(owner, &count); \
+        if (result != FMOD_OK) return result; \
+        if (!recordArrayReserve(&(list), (list).count + count, sizeof(void*))) return FMOD_ERR_MEMORY; \
+        result = getList(owner, RECORD_AT(list, type*, (list).count), count, &count); \
+        if (result != FMOD_OK) return result; \
+        (list).count += count; \
+    } while(0)
+
+static FMOD_RESULT capture(luaFMOD_Telemetry *telemetry, FMOD_STUDIO_SYSTEM *system)
+{
+    FMOD_RESULT result = FMOD_OK;
+    FMOD_STUDIO_MEMORY_USAGE usage;
+
+    telemetry->records.count = 0;
+    telemetry->banks.count = 0;
+    telemetry->buses.count = 0;
+    telemetry->events.count = 0;
+
+    TelemetryRecord *record = addRecord(telemetry, KIND_SYSTEM, system);
+    if (!record) return FMOD_ERR_MEMORY;
+
+    storeMemory(record, FMOD_Studio_System_GetMemoryUsage(system, &usage), &usage);
+
+    APPEND_LIST(telemetry->banks, FMOD_Studio_System_GetBankCount, FMOD_Studio_System_GetBankList,
+        system, FMOD_STUDIO_BANK);
+
+    for (int b = 0; b < telemetry->banks.count; ++b) {
+        FMOD_STUDIO_BANK *bank = *RECORD_AT(telemetry->banks, FMOD_STUDIO_BANK*, b);
+
+        APPEND_LIST(telemetry->buses, FMOD_Studio_Bank_GetBusCount, FMOD_Studio_Bank_GetBusList,
+            bank, FMOD_STUDIO_BUS);
+        APPEND_LIST(telemetry->events, FMOD_Studio_Bank_GetEventCount, FMOD_Studio_Bank_GetEventList,
+            bank, FMOD_STUDIO_EVENTDESCRIPTION);
+    }
+
+    uniqueHandles(&telemetry->buses);
+    uniqueHandles(&telemetry->events);
+
+    for (int i = 0; i < telemetry->buses.count; ++i) {
+        FMOD_STUDIO_BUS *bus = *RECORD_AT(telemetry->buses, FMOD_STUDIO_BUS*, i);
+
+        record = addRecord(telemetry, KIND_BUS, bus);
+        if (!record) return FMOD_ERR_MEMORY;
+
+        FMOD_Studio_Bus_GetCPUUsage(bus, &record->cpuExclusive, &record->cpuInclusive);
+        storeMemory(record, FMOD_Studio_Bus_GetMemoryUsage(bus, &usage), &usage);
+    }
+
+    for (int e = 0; e < telemetry->events.count; ++e) {
+        FMOD_STUDIO_EVENTDESCRIPTION *description = *RECORD_AT(telemetry->events, FMOD_STUDIO_EVENTDESCRIPTION*, e);
+
+        telemetry->instances.count = 0;
+        APPEND_LIST(telemetry->instances, FMOD_Studio_EventDescription_GetInstanceCount,
+            FMOD_Studio_EventDescription_GetInstanceList, description, FMOD_STUDIO_EVENTINSTANCE);
+
+        for (int i = 0; i < telemetry->instances.count; ++i) {
+            FMOD_STUDIO_EVENTINSTANCE *instance = *RECORD_AT(telemetry->instances, FMOD_STUDIO_EVENTINSTANCE*, i);
+
+            record = addRecord(telemetry, KIND_INSTANCE, instance);
+            if (!record) return FMOD_ERR_MEMORY;
+
+            FMOD_Studio_EventInstance_GetCPUUsage(instance, &record->cpuExclusive, &record->cpuInclusive);
+            storeMemory(record, FMOD_Studio_EventInstance_GetMemoryUsage(instance, &usage), &usage);
+        }
+    }
+
+    return FMOD_OK;
+}
+
+#undef APPEND_LIST
+
+int telemetryCapture(lua_State *L, FMOD_STUDIO_SYSTEM *system, int outIndex)
+{
+    luaFMOD_Telemetry *telemetry = recordArrayPushOwner(L, STRINGIZE(SELF_TYPE), sizeof(*telemetry), outIndex);
+
+    RETURN_IF_ERROR(capture(telemetry, system));
+
+    return 1;
+}
+
+static int METHOD_NAME(__gc)(lua_State *L)
+{
+    GET_SELF;
+
+    recordArrayFree(&self->records);
+    recordArrayFree(&self->banks);
+    recordArrayFree(&self->buses);
+    recordArrayFree(&self->events);
+    recordArrayFree(&self->instances);
+
+    return 0;
+}
+
+static int METHOD_NAME(getCount)(lua_State *L)
+{
+    GET_SELF;
+
+    lua_pushinteger(L, self->records.count);
+
+    return 1;
+}
+
+/* getRecord(i)
+   Returns kind, exclusive CPU, inclusive CPU (microseconds), exclusive memory,
+   inclusive memory and sample data memory (bytes). No garbage is created.
+*/
+static int METHOD_NAME(getRecord)(lua_State *L)
+{
+    GET_SELF;
+
+    TelemetryRecord *record = recordArrayCheck(L, &self->records, 2, sizeof(TelemetryRecord));
+
+    lua_pushstring(L, KIND_NAMES[record->kind]);
+    lua_pushinteger(L, record->cpuExclusive);
+    lua_pushinteger(L, record->cpuInclusive);
+    lua_pushinteger(L, record->memoryExclusive);
+    lua_pushinteger(L, record->memoryInclusive);
+    lua_pushinteger(L, record->sampleData);
+
+    return 6;
+}
+
+/* getHandle(i)
+   Returns the Studio.System, Bus or EventInstance the record describes.
+*/
+static int METHOD_NAME(getHandle)(lua_State *L)
+{
+    GET_SELF;
+
+    TelemetryRecord *record = recordArrayCheck(L, &self->records, 2, sizeof(TelemetryRecord));
+
+    switch (record->kind) {
+    case KIND_SYSTEM:
+        PUSH_HANDLE(L, FMOD_STUDIO_SYSTEM, (FMOD_STUDIO_SYSTEM*)record->handle);
+        break;
+    case KIND_BUS:
+        PUSH_HANDLE(L, FMOD_STUDIO_BUS, (FMOD_STUDIO_BUS*)record->handle);
+        break;
+    default:
+        PUSH_HANDLE(L, FMOD_STUDIO_EVENTINSTANCE, (FMOD_STUDIO_EVENTINSTANCE*)record->handle);
+        break;
+    }
+
+    return 1;
+}
+
+METHODS_TABLE_BEGIN
+    METHODS_TABLE_ENTRY(__gc)
+    METHODS_TABLE_ENTRY(getCount)
+    METHODS_TABLE_ENTRY(getRecord)
+    METHODS_TABLE_ENTRY(getHandle)
+METHODS_TABLE_END
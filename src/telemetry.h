@@ -0,0 +1,12 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <fmod_studio.h>
+#include <lauxlib.h>
+
+typedef struct luaFMOD_Telemetry luaFMOD_Telemetry;
+
+/* Fills the telemetry array at outIndex, or a new one if outIndex is nil, and pushes it */
+int telemetryCapture(lua_State *L, FMOD_STUDIO_SYSTEM *system, int outIndex);
+
+#endif /* TELEMETRY_H */
@@ -201,6 +201,14 @@ typedef unsigned long long DSP_CLOCK;
     RETURN_STATUS(JOIN(FMOD_PREFIX, Set ## name)(self FOR_EACH(2, (__VA_ARGS__), COMMA PREFIX_INDEX(value)))); \
   }
 
+#define CALL_MULTI(methodName, fmodName, ...) \
+  static int METHOD_NAME(methodName)(lua_State *L) \
+  { \
+    GET_SELF; \
+    FOR_EACH(2, (__VA_ARGS__), READ, ) \
+    RETURN_STATUS(JOIN(FMOD_PREFIX, fmodName)(self FOR_EACH(2, (__VA_ARGS__), COMMA PREFIX_INDEX(value)))); \
+  }
+
 #define GET_INDEXED_MULTI(name, ...) \
   static int METHOD_NAME(get ## name)(lua_State *L) \
   { \
@@ -388,3 +396,38 @@ static int SET_TIMEUNIT(lua_State *L, FMOD_RESULT F_API (*setter)(SELF_TYPE *, u
 
   RETURN_STATUS(setter(self, value, timeUnit));
 }
+
+/* Returns an array of { dspclock, volume } pairs */
+static int GET_FADE_POINTS(lua_State *L,
+  FMOD_RESULT F_API (*getter)(SELF_TYPE *, unsigned int *, unsigned long long *, float *))
+{
+  GET_SELF;
+
+  unsigned int count = 0;
+  RETURN_IF_ERROR(getter(self, &count, NULL, NULL));
+
+  STACKBUFFER_CREATE(unsigned long long, clocks, count);
+  STACKBUFFER_CREATE(float, volumes, count);
+
+  RETURN_IF_ERROR(getter(self, &count, clocks, volumes),
+    STACKBUFFER_RELEASE(volumes); STACKBUFFER_RELEASE(clocks););
+
+  lua_createtable(L, count, 0);
+
+  for (unsigned int i = 0; i < count; ++i) {
+    lua_createtable(L, 2, 0);
+
+    lua_pushinteger(L, clocks[i]);
+    lua_rawseti(L, -2, 1);
+
+    lua_pushnumber(L, volumes[i]);
+    lua_rawseti(L, -2, 2);
+
+    lua_rawseti(L, -2, i + 1);
+  }
+
+  STACKBUFFER_RELEASE(volumes);
+  STACKBUFFER_RELEASE(clocks);
+
+  return 1;
+}